@@ -0,0 +1,119 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   arm64_atomic.h
+ *
+ * @brief  ARM64 atomic operations using load/store exclusive
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "common.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup BCM2711_Hardware BCM2711 Hardware layer
+ * @brief    Abstraction layer for the BCM2711 SoC from Broadcom
+ * @{
+ */
+
+/**
+ * @brief   Atomically add to a 64-bit value
+ * @details Safe against interrupts and other cores. Exception return clears the exclusive monitor,
+ *          so an interrupted update is simply retried
+ * @param   ptr Pointer to the value
+ * @param   value Value to add (two's complement for subtraction)
+ * @return  The new value
+ */
+static inline u64 atomic_add_return(volatile u64 *ptr, u64 value) {
+  u64 result;
+  u32 failed;
+
+  asm volatile(
+      "1: ldaxr %0, [%2]      \n"
+      "   add %0, %0, %3      \n"
+      "   stlxr %w1, %0, [%2] \n" /* Retry if another writer got in between */
+      "   cbnz %w1, 1b        \n"
+      : "=&r"(result), "=&r"(failed)
+      : "r"(ptr), "r"(value)
+      : "memory");
+
+  return result;
+}
+
+/**
+ * @brief   Atomically add to a 32-bit value
+ * @param   ptr Pointer to the value
+ * @param   value Value to add (two's complement for subtraction)
+ * @return  The new value
+ */
+static inline u32 atomic_add_return_32(volatile u32 *ptr, u32 value) {
+  u32 result;
+  u32 failed;
+
+  asm volatile(
+      "1: ldaxr %w0, [%2]       \n"
+      "   add %w0, %w0, %w3     \n"
+      "   stlxr %w1, %w0, [%2]  \n"
+      "   cbnz %w1, 1b          \n"
+      : "=&r"(result), "=&r"(failed)
+      : "r"(ptr), "r"(value)
+      : "memory");
+
+  return result;
+}
+
+/**
+ * @brief   Atomically replace a 64-bit value if it matches an expected value
+ * @param   ptr Pointer to the value
+ * @param   expected Value that must be present for the exchange to happen
+ * @param   desired Value to store
+ * @return  The value found at ptr. The exchange happened if this equals expected
+ */
+static inline u64 atomic_cmpxchg(volatile u64 *ptr, u64 expected, u64 desired) {
+  u64 found;
+  u32 failed;
+
+  asm volatile(
+      "1: ldaxr %0, [%2]      \n"
+      "   cmp %0, %3          \n"
+      "   b.ne 2f             \n" /* Mismatch, give up without storing */
+      "   stlxr %w1, %4, [%2] \n"
+      "   cbnz %w1, 1b        \n"
+      "   b 3f                \n"
+      "2: clrex               \n"
+      "3:                     \n"
+      : "=&r"(found), "=&r"(failed)
+      : "r"(ptr), "r"(expected), "r"(desired)
+      : "memory", "cc");
+
+  return found;
+}
+
+/**
+ * @brief   Atomically swap a 64-bit value
+ * @param   ptr Pointer to the value
+ * @param   value Value to store
+ * @return  The previous value
+ */
+static inline u64 atomic_xchg(volatile u64 *ptr, u64 value) {
+  u64 previous;
+  u32 failed;
+
+  asm volatile(
+      "1: ldaxr %0, [%2]      \n"
+      "   stlxr %w1, %3, [%2] \n"
+      "   cbnz %w1, 1b        \n"
+      : "=&r"(previous), "=&r"(failed)
+      : "r"(ptr), "r"(value)
+      : "memory");
+
+  return previous;
+}
+
+/** @} */
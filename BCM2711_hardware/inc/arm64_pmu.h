@@ -0,0 +1,118 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   arm64_pmu.h
+ *
+ * @brief  ARM64 performance monitor unit (PMU) abstraction
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "common.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup BCM2711_Hardware BCM2711 Hardware layer
+ * @brief    Abstraction layer for the BCM2711 SoC from Broadcom
+ * @{
+ */
+
+/** @brief  PMCR_EL0 enable bit */
+#define PMCR_E (1U << 0)
+/** @brief  PMCR_EL0 event counter reset bit */
+#define PMCR_P (1U << 1)
+/** @brief  PMCR_EL0 cycle counter reset bit */
+#define PMCR_C (1U << 2)
+
+/** @brief  PMCNTENSET_EL0 cycle counter enable bit */
+#define PMCNTEN_CYCLES (1U << 31)
+
+/** @brief  PMUSERENR_EL0 bit giving EL0 access to the PMU */
+#define PMUSERENR_EN (1U << 0)
+/** @brief  PMUSERENR_EL0 bit letting EL0 read the cycle counter */
+#define PMUSERENR_CR (1U << 2)
+
+/** @brief  Number of event counters implemented by the Cortex-A72 */
+#define PMU_NUM_COUNTERS 6U
+
+/* Common architectural event numbers (ARM ARM D7.10) */
+#define PMU_EVENT_L1I_CACHE_REFILL 0x01U
+#define PMU_EVENT_L1I_TLB_REFILL 0x02U
+#define PMU_EVENT_L1D_CACHE_REFILL 0x03U
+#define PMU_EVENT_L1D_CACHE 0x04U
+#define PMU_EVENT_L1D_TLB_REFILL 0x05U
+#define PMU_EVENT_INST_RETIRED 0x08U
+#define PMU_EVENT_EXC_TAKEN 0x09U
+#define PMU_EVENT_CPU_CYCLES 0x11U
+#define PMU_EVENT_L2D_CACHE_REFILL 0x17U
+
+/**
+ * @brief   Enable the cycle counter and reset all counters
+ * @details The counters are per core. boot.S already enables the cycle counter on every core, so calling this
+ *          again only resets the counters
+ */
+static inline void pmu_init(void) {
+  u64 pmcr;
+
+  asm volatile("mrs %0, pmcr_el0" : "=r"(pmcr));
+  pmcr |= PMCR_E | PMCR_P | PMCR_C;
+  asm volatile("msr pmcr_el0, %0" ::"r"(pmcr));
+  asm volatile("msr pmcntenset_el0, %0" ::"r"((u64)PMCNTEN_CYCLES));
+  asm volatile("isb" ::: "memory");
+}
+
+/**
+ * @brief   Let EL0 read the cycle counter of this core, for measurements taken from user tasks
+ */
+static inline void pmu_enable_user_access(void) {
+  asm volatile("msr pmuserenr_el0, %0" ::"r"((u64)(PMUSERENR_EN | PMUSERENR_CR)));
+  asm volatile("isb" ::: "memory");
+}
+
+/**
+ * @brief   Read the cycle counter
+ * @return  Current value of PMCCNTR_EL0
+ */
+static inline u64 pmu_read_cycles(void) {
+  u64 cycles;
+
+  asm volatile("isb; mrs %0, pmccntr_el0" : "=r"(cycles)::"memory");
+
+  return cycles;
+}
+
+/**
+ * @brief   Start counting an architectural event on an event counter
+ * @param   counter Event counter index (0 to PMU_NUM_COUNTERS - 1)
+ * @param   event Event number to count
+ */
+static inline void pmu_config_event(u32 counter, u32 event) {
+  asm volatile("msr pmselr_el0, %0" ::"r"((u64)counter));
+  asm volatile("isb" ::: "memory");
+  asm volatile("msr pmxevtyper_el0, %0" ::"r"((u64)event));
+  asm volatile("msr pmxevcntr_el0, xzr");
+  asm volatile("msr pmcntenset_el0, %0" ::"r"((u64)(1U << counter)));
+  asm volatile("isb" ::: "memory");
+}
+
+/**
+ * @brief   Read an event counter
+ * @param   counter Event counter index (0 to PMU_NUM_COUNTERS - 1)
+ * @return  Number of events counted since the counter was configured
+ */
+static inline u64 pmu_read_event(u32 counter) {
+  u64 value;
+
+  asm volatile("msr pmselr_el0, %0" ::"r"((u64)counter));
+  asm volatile("isb" ::: "memory");
+  asm volatile("mrs %0, pmxevcntr_el0" : "=r"(value));
+
+  return value;
+}
+
+/** @} */
@@ -36,4 +36,7 @@
 
 #define SECTION_SIZE (1 << SECTION_SHIFT)
 
+/** @brief  L1 data cache line size of the Cortex-A72 */
+#define CACHE_LINE_SIZE 64U
+
 /** @} */
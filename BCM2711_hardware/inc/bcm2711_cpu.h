@@ -36,6 +36,18 @@ extern u64 __high_memory;
 #define PAGING_MEMORY (HIGH_MEMORY - LOW_MEMORY)
 #define PAGING_PAGES (PAGING_MEMORY / PAGE_SIZE)
 
+/** @brief  Number of Cortex-A72 cores */
+#define NUM_CPUS 4U
+
+/** @brief  Spin table slot that the firmware or the QEMU boot stub polls for the entry point of a parked core */
+#define CPU_SPIN_TABLE(cpu) (0xD8UL + 8UL * (cpu))
+
+/** @brief  Entry points published to the cores parked in boot.S, indexed by CPU ID */
+extern volatile u64 cpu_release_addr[NUM_CPUS];
+
+/** @brief  Initial stack pointer of every secondary core, read by boot.S before the MMU is enabled */
+extern volatile u64 cpu_boot_stack[NUM_CPUS];
+
 /**
  * @brief   Get the current CPU ID (0-3 on RPi4)
  * @return  CPU ID (0-3)
@@ -67,4 +79,14 @@ extern void cpu_enable_irq(void);
  */
 extern void cpu_disable_irq(void);
 
+/**
+ * @brief   Release a parked secondary core
+ * @details The core starts with the MMU and caches off, so the entry point and stack are cleaned to the point of
+ *          coherency before the wakeup event is sent
+ * @param   cpu Core to start (1-3)
+ * @param   entry Physical address the core starts executing at
+ * @param   stack_top Initial stack pointer of the core
+ */
+extern void cpu_start_secondary(u32 cpu, u64 entry, u64 stack_top);
+
 /** @} */
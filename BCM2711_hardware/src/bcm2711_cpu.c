@@ -14,6 +14,13 @@
 /* Intra-component Headers */
 #include "bcm2711_cpu.h"
 
+__attribute__((aligned(8), section(".data"))) volatile u64 cpu_release_addr[NUM_CPUS] = { 0 };
+__attribute__((aligned(8), section(".data"))) volatile u64 cpu_boot_stack[NUM_CPUS] = { 0 };
+
+static inline void clean_dcache_line(volatile void *addr) {
+  asm volatile("dc civac, %0" ::"r"(addr) : "memory");
+}
+
 extern u32 get_cpu_id(void) {
   u64 mpidr;
   asm volatile("mrs %0, mpidr_el1" : "=r"(mpidr));
@@ -41,3 +48,23 @@ extern void cpu_enable_irq(void) {
 extern void cpu_disable_irq(void) {
   asm volatile("msr daifset, #2");
 }
+
+extern void cpu_start_secondary(u32 cpu, u64 entry, u64 stack_top) {
+  if (cpu == 0U || cpu >= NUM_CPUS) {
+    return;
+  }
+
+  volatile u64 *spin_table = (volatile u64 *)CPU_SPIN_TABLE(cpu);
+
+  cpu_boot_stack[cpu] = stack_top;
+  cpu_release_addr[cpu] = entry;
+  /* Cores that never reached boot.S are held by the firmware or the QEMU boot stub on the spin table instead */
+  *spin_table = entry;
+
+  clean_dcache_line(&cpu_boot_stack[cpu]);
+  clean_dcache_line(&cpu_release_addr[cpu]);
+  clean_dcache_line(spin_table);
+  asm volatile("dsb sy" ::: "memory");
+
+  wakeup_cpu();
+}
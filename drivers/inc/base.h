@@ -2,13 +2,16 @@
 
 #if RPI_VERSION == 3
 #define PBASE 0x3F000000
+#define LOCAL_PBASE 0x40000000
 
 // Low peripheral mode address
 #elif RPI_VERSION == 4
 #define PBASE 0xFE000000
+#define LOCAL_PBASE 0xFF800000
 
 #else
 #define PBASE 0
+#define LOCAL_PBASE 0
 #error "NO RPI_VERSION DEFINED"
 
 #endif
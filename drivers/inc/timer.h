@@ -24,5 +24,21 @@ void handle_timer_irq();
 u64 timer_get_ticks();
 void timer_sleep(u32 ms);
 
+// Move the next interrupt of a timer to delay ticks from now. Later interrupts keep the interval from there on
+void timer_set_next_event(u8 timer_id, u32 delay);
+
+// Per-core timer on the ARM generic timer, interval in CLOCK_HZ ticks. Only interrupts the calling core
+void local_timer_init(u32 interval, void (*handler)(void));
+void handle_local_timer_irq();
+
+// Move the next generic timer interrupt of the calling core to delay CLOCK_HZ ticks from now
+void local_timer_set_next_event(u32 delay);
+
+// Generic timer counter, synchronized across cores. A system register read, so no MMIO unlike timer_get_ticks
+u64 local_timer_get_counter();
+
+// Frequency of the generic timer counter in Hz, 54 MHz on the BCM2711
+u64 local_timer_get_frequency();
+
 #define TIMER_BASE (PBASE + 0x00003000)  // Timer register base address
 #define TIMER_REGS ((volatile TimerRegisters *)(TIMER_BASE))
\ No newline at end of file
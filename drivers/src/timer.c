@@ -1,10 +1,14 @@
 #include "timer.h"
 
+#include "bcm2711_cpu.h"
 #include "irq.h"
 #include "log.h"
 
 Timer timers[NUM_TIMERS];
 
+// Generic timer of every core, the interval is in counter ticks
+static Timer local_timers[NUM_CPUS];
+
 void timer_init(u8 timer_id, u32 interval, void (*handler)(void)) {
   if (timer_id < NUM_TIMERS) {
     timers[timer_id].interval = interval;
@@ -21,6 +25,13 @@ void timer_init(u8 timer_id, u32 interval, void (*handler)(void)) {
   }
 }
 
+void timer_set_next_event(u8 timer_id, u32 delay) {
+  if (timer_id < NUM_TIMERS) {
+    timers[timer_id].cur_val = TIMER_REGS->counter_lo + delay;
+    TIMER_REGS->compare[timer_id] = timers[timer_id].cur_val;
+  }
+}
+
 void handle_timer_irq() {
   for (int i = 0; i < NUM_TIMERS; i++) {
     if (TIMER_REGS->control_status & (1 << i)) {
@@ -35,6 +46,47 @@ void handle_timer_irq() {
   }
 }
 
+void local_timer_init(u32 interval, void (*handler)(void)) {
+  u32 cpu = get_cpu_id();
+
+  local_timers[cpu].interval = (u32)((local_timer_get_frequency() * interval) / CLOCK_HZ);
+  local_timers[cpu].handler = handler;
+
+  asm volatile("msr cntp_tval_el0, %0" ::"r"((u64)local_timers[cpu].interval));
+  asm volatile("msr cntp_ctl_el0, %0" ::"r"(1UL));  // Enabled, interrupt not masked
+  LOCAL_IRQ_REGS->timer_control[cpu] = LOCAL_IRQ_CNTPNS;
+}
+
+void handle_local_timer_irq() {
+  u32 cpu = get_cpu_id();
+
+  // Writing TVAL sets the next deadline and clears the interrupt
+  asm volatile("msr cntp_tval_el0, %0" ::"r"((u64)local_timers[cpu].interval));
+
+  if (local_timers[cpu].handler) {
+    local_timers[cpu].handler();
+  }
+}
+
+void local_timer_set_next_event(u32 delay) {
+  asm volatile("msr cntp_tval_el0, %0" ::"r"((local_timer_get_frequency() * delay) / CLOCK_HZ));
+}
+
+u64 local_timer_get_counter() {
+  u64 count;
+
+  // The isb keeps the read from being executed ahead of earlier instructions
+  asm volatile("isb\n mrs %0, cntpct_el0" : "=r"(count)::"memory");
+  return count;
+}
+
+u64 local_timer_get_frequency() {
+  u64 frequency;
+
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+  return frequency;
+}
+
 u64 timer_get_ticks() {
   u32 hi = TIMER_REGS->counter_hi;
   u32 lo = TIMER_REGS->counter_lo;
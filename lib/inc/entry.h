@@ -35,7 +35,8 @@
 #define FIQ_INVALID_EL0_32 14
 #define ERROR_INVALID_EL0_32 15
 
-#define SYSCALL_ERROR 17
+#define SYSCALL_ERROR 16
+#define DATA_ABORT_ERROR 17
 
 // This is calculated as thus:
 // x0 to 30 = 31 * 8 = 256
@@ -24,7 +24,9 @@
 
 #include "bcm2711.h"
 #ifndef __ASSEMBLER__
+#include "arm64_atomic.h"
 #include "arm64_barrier.h"
+#include "arm64_pmu.h"
 #include "bcm2711_cpu.h"
 #include "bcm2711_periph_io.h"
 #endif
@@ -76,9 +76,54 @@ typedef struct arm_irq_regs_rpi4 IRQRegisters;
 
 #define IRQ_REGS ((IRQRegisters *)(PBASE + 0x0000B200))
 
+// ARM local interrupt controller. Unlike the shared controller above, which only interrupts core 0, every core
+// has its own timer and source registers here
+#define LOCAL_IRQ_CNTPNS (1 << 1)    // Non-secure physical generic timer
+#define LOCAL_IRQ_MAILBOX0 (1 << 4)  // Mailbox 0, used to kick a core out of wfi
+
+typedef struct {
+  reg32 res0[16];
+  reg32 timer_control[4];  // Generic timer interrupt enables, one register per core
+  reg32 mailbox_control[4];
+  reg32 irq_source[4];  // Pending interrupt sources, one register per core
+  reg32 fiq_source[4];
+  reg32 mailbox_set[16];    // Write-set, four mailboxes per core
+  reg32 mailbox_clear[16];  // Read and write-clear, four mailboxes per core
+} LocalIRQRegisters;
+
+#define LOCAL_IRQ_REGS ((LocalIRQRegisters *)(LOCAL_PBASE))
+
 void irq_init_vectors();
 void irq_enable();
 void irq_disable();
-void irq_save_flags(u64 flags);
+
+/**
+ * @brief   Mask IRQs and return the previous DAIF value
+ * @return  Flags to pass to irq_restore_flags
+ */
+u64 irq_save_flags(void);
+
+/**
+ * @brief   Restore the IRQ mask saved by irq_save_flags
+ * @param   flags Value returned by irq_save_flags
+ */
 void irq_restore_flags(u64 flags);
 void enable_interrupt_controller();
+
+/**
+ * @brief   Let the calling core take reschedule IPIs
+ */
+void irq_enable_ipi(void);
+
+/**
+ * @brief   Interrupt another core so it leaves wfi and reschedules
+ * @param   cpu Target CPU ID
+ */
+void irq_send_reschedule(u32 cpu);
+
+/**
+ * @brief   Set a function the reschedule IPI calls on the calling core, after the scheduler handled it
+ * @details Runs in interrupt context. Lets benchmarks timestamp IRQ entry
+ * @param   hook Function to call, NULL to remove it
+ */
+void irq_set_ipi_hook(void (*hook)(void));
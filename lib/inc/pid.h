@@ -0,0 +1,54 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   pid.h
+ *
+ * @brief  Process ID allocator header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+
+/* Inter-component Headers */
+#include "common.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup Scheduler OS Scheduler Library
+ * @brief    Library that supports CFS, Priority/regular round-robin, EDF, First-come-first-serve
+ * scheduling algorithms
+ * @{
+ */
+
+/** @brief  Number of process IDs. PID 0 belongs to the init task and is never handed out */
+#define PID_MAX 32768U
+
+/** @brief  Returned by pid_alloc when every PID is in use */
+#define PID_NONE 0U
+
+/**
+ * @brief   Allocate a free process ID
+ * @details IDs are handed out in increasing order and wrap around at PID_MAX, so a freed ID is not
+ *          reused until the rest of the range has been tried
+ * @return  The new PID or PID_NONE if none are free
+ */
+u32 pid_alloc(void);
+
+/**
+ * @brief   Release a process ID for reuse
+ * @param   pid ID returned by pid_alloc
+ */
+void pid_free(u32 pid);
+
+/**
+ * @brief   Check whether a process ID is allocated
+ * @param   pid ID to check
+ * @return  TRUE if the ID belongs to a task
+ */
+bool pid_in_use(u32 pid);
+
+/** @} */
@@ -0,0 +1,230 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   sched_class.h
+ *
+ * @brief  Scheduling class interface header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "rbtree.h"
+#include "spinlock.h"
+
+/* Intra-component Headers */
+#include "scheduler.h"
+
+/**
+ * @defgroup Scheduler OS Scheduler Library
+ * @brief    Library that supports CFS, Priority/regular round-robin, EDF, First-come-first-serve
+ * scheduling algorithms
+ * @{
+ */
+
+/** @brief  The task is being woken up rather than preempted */
+#define ENQUEUE_WAKEUP (1U << 0)
+/** @brief  The task was just created */
+#define ENQUEUE_NEW (1U << 1)
+/** @brief  The task was moved over from the runqueue of another CPU */
+#define ENQUEUE_MIGRATED (1U << 2)
+
+/** @brief  Weight of the newest sample in the runqueue load average, 1 / 2^n */
+#define SCHED_LOAD_AVG_SHIFT 3U
+
+/** @brief  Fixed point shift of deadline bandwidth, runtime / period */
+#define DL_BW_SHIFT 20U
+
+/** @brief  Weight of a DEFAULT_PRIORITY task, vruntime advances at wall clock speed for it */
+#define NICE_0_LOAD 1024U
+
+#define NSEC_PER_USEC 1000ULL
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_SEC 1000000000ULL
+
+/**
+ * @brief   FIFO list of runnable tasks for every priority
+ * @details Bit n of the bitmap is set while list n is not empty, so the highest runnable priority is found with one clz
+ */
+struct PrioArray {
+  u64 bitmap;
+  struct TaskBlock *head[NUM_PRIORITIES];
+  struct TaskBlock *tail[NUM_PRIORITIES];
+};
+
+/**
+ * @brief   Round-robin class runqueue
+ * @details Tasks that used up their timeslice are refilled and moved to the expired array. Once the active array
+ *          empties the two are swapped, so no scheduling decision walks the task list
+ */
+struct RrRunQueue {
+  struct PrioArray arrays[2];
+  struct PrioArray *active;
+  struct PrioArray *expired;
+  u32 nr_running; /**< Tasks queued on either array */
+};
+
+/**
+ * @brief   Fair class runqueue
+ */
+struct CfsRunQueue {
+  struct RbRoot timeline; /**< Queued tasks ordered by vruntime, the leftmost runs next */
+  u64 min_vruntime;       /**< Monotonic floor of every vruntime, used to place new and woken tasks */
+  u64 load_weight;        /**< Sum of the weights of the queued tasks */
+  u32 nr_running;         /**< Tasks in the timeline */
+};
+
+/**
+ * @brief   Deadline class runqueue
+ */
+struct DlRunQueue {
+  struct RbRoot timeline;         /**< Queued tasks ordered by absolute deadline, the leftmost runs next */
+  struct TaskBlock *release_head; /**< Parked tasks, sorted by the start of their next period */
+  u64 total_bw;                   /**< Sum of runtime / period of every deadline task, in DL_BW_SHIFT fixed point */
+  u32 nr_running;                 /**< Tasks in the timeline */
+};
+
+/**
+ * @brief   Runnable tasks waiting for one CPU
+ * @details The task on the CPU is never queued. Every field is also touched from the timer IRQ and by other CPUs,
+ *          so it must only be accessed with IRQs masked and the lock held. Two runqueues are always locked in CPU
+ *          order
+ */
+struct RunQueue {
+  struct Spinlock lock;
+  struct DlRunQueue dl;
+  struct RrRunQueue rr;
+  struct CfsRunQueue cfs;
+  u32 nr_running;                            /**< Tasks queued across all classes */
+  u64 clock;                                 /**< sched_clock() at the last tick or schedule */
+  struct TaskBlock *curr;                    /**< Task on the CPU */
+  struct TaskBlock *idle;                    /**< Runs when no class has a task */
+  u32 cpu;                                   /**< CPU the runqueue belongs to */
+  u64 load_avg;                              /**< Average of the queued and running tasks, in SCHED_LOAD_SCALE units */
+  u32 balance_ticks;                         /**< Ticks left until the next periodic load balancing pass */
+  u64 idle_start;                            /**< Clock value the idle task was last switched in at */
+  u64 idle_ns;                               /**< Time spent in the idle task */
+  u64 nr_switches;                           /**< Context switches */
+  u64 nr_migrations;                         /**< Tasks pulled from other CPUs */
+  u64 nr_ticks;                              /**< Scheduler ticks taken */
+  bool tick_stopped;                         /**< The idle CPU sleeps until its next event instead of ticking */
+  u64 tick_stop_time;                        /**< Clock value the tick was stopped at */
+  bool tick_isolated;                        /**< Tick stopped while a single task runs on an isolated CPU */
+  struct SchedTimer *timers;                 /**< Timers armed on this CPU, sorted by expiry */
+  struct SchedTimer *volatile running_timer; /**< Timer whose callback runs right now */
+};
+
+/**
+ * @brief   Scheduling class operations
+ * @details Classes are chained from the highest precedence down. A class is only asked for a task once every class
+ *          above it came up empty
+ */
+struct SchedClass {
+  const struct SchedClass *next; /**< Next lower class, NULL for the last one */
+
+  /** @brief Queue a runnable task that is not on the CPU. flags holds ENQUEUE_* bits */
+  void (*enqueue_task)(struct RunQueue *rq, struct TaskBlock *p, u32 flags);
+
+  /** @brief Remove a queued task */
+  void (*dequeue_task)(struct RunQueue *rq, struct TaskBlock *p);
+
+  /** @brief Remove and return the task to run next, or NULL if the class has none */
+  struct TaskBlock *(*pick_next_task)(struct RunQueue *rq);
+
+  /** @brief Account the runtime of the task leaving the CPU and queue it again if it is still runnable.
+   *         Returns TRUE if the task was queued, a class may park a runnable task instead */
+  bool (*put_prev_task)(struct RunQueue *rq, struct TaskBlock *p, bool runnable);
+
+  /** @brief Account a tick against the running task. Returns TRUE if it should be preempted */
+  bool (*task_tick)(struct RunQueue *rq, struct TaskBlock *p);
+
+  /** @brief Check whether the class has queued tasks */
+  bool (*has_tasks)(struct RunQueue *rq);
+
+  /** @brief Prepare a task that joined the class or had its parameters changed. Called before it is queued */
+  void (*switched_to)(struct RunQueue *rq, struct TaskBlock *p);
+
+  /** @brief Release class resources of a task that is leaving the class or exiting. May be NULL.
+   *         Returns TRUE if the class had parked the runnable task, so the caller must queue it */
+  bool (*switched_from)(struct RunQueue *rq, struct TaskBlock *p);
+
+  /** @brief Remove and return a queued task that may move to dst_cpu, or NULL if there is none. Tasks still
+   *         being switched out or not allowed on dst_cpu are skipped. May be NULL if the class keeps its tasks on
+   *         one CPU */
+  struct TaskBlock *(*steal_task)(struct RunQueue *rq, u32 dst_cpu);
+};
+
+extern const struct SchedClass dl_sched_class;
+extern const struct SchedClass rr_sched_class;
+extern const struct SchedClass fair_sched_class;
+
+/** @brief  Class with the highest precedence, the start of the class chain */
+#define sched_class_highest (&dl_sched_class)
+
+/**
+ * @brief   Initialize the round-robin class runqueue
+ * @param   rq Runqueue to initialize
+ */
+void rr_init_rq(struct RunQueue *rq);
+
+/**
+ * @brief   Initialize the fair class runqueue
+ * @param   rq Runqueue to initialize
+ */
+void fair_init_rq(struct RunQueue *rq);
+
+/**
+ * @brief   Make the vruntime of a fair task that is on no runqueue relative to the runqueue it leaves
+ * @details min_vruntime of two runqueues are unrelated. The task must be enqueued with ENQUEUE_MIGRATED on the
+ *          new runqueue, which adds its min_vruntime back
+ * @param   rq Runqueue the task leaves, locked
+ * @param   p Task to move
+ */
+void fair_migrate_task(struct RunQueue *rq, struct TaskBlock *p);
+
+/**
+ * @brief   Initialize the deadline class runqueue
+ * @param   rq Runqueue to initialize
+ */
+void dl_init_rq(struct RunQueue *rq);
+
+/**
+ * @brief   Validate deadline parameters and reserve their bandwidth
+ * @details On success the parameters are stored in the task, replacing any reservation it already held
+ * @param   rq Runqueue
+ * @param   p Task to reserve for
+ * @param   attr Requested parameters
+ * @return  0 if admitted, -1 if the parameters are invalid, -2 if the bandwidth limit would be exceeded
+ */
+int dl_admit(struct RunQueue *rq, struct TaskBlock *p, const struct SchedAttr *attr);
+
+/**
+ * @brief   Take the next parked task whose period has started
+ * @details The task gets a fresh budget and deadline and must be queued by the caller
+ * @param   rq Runqueue, its clock must be current
+ * @return  Task to queue or NULL if no period has started
+ */
+struct TaskBlock *dl_pop_release(struct RunQueue *rq);
+
+/**
+ * @brief   Get the start of the earliest period a parked task waits for
+ * @param   rq Runqueue
+ * @param   release Set to the sched_clock() value of the release
+ * @return  TRUE if a task is parked, FALSE otherwise
+ */
+bool dl_next_release(struct RunQueue *rq, u64 *release);
+
+/**
+ * @brief   End the current job of a deadline task
+ * @param   rq Runqueue, its clock must be current
+ * @param   p Running deadline task
+ * @return  TRUE if the task was parked until its next period and must sleep, FALSE if that period already started
+ */
+bool dl_finish_job(struct RunQueue *rq, struct TaskBlock *p);
+
+/** @} */
@@ -0,0 +1,148 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   sched_trace.h
+ *
+ * @brief  Scheduler event tracing and latency histograms
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+
+/* Inter-component Headers */
+#include "common.h"
+
+/* Intra-component Headers */
+#include "sched_class.h"
+#include "scheduler.h"
+
+/**
+ * @defgroup Scheduler OS Scheduler Library
+ * @brief    Library that supports CFS, Priority/regular round-robin, EDF, First-come-first-serve
+ * scheduling algorithms
+ * @{
+ */
+
+/**
+ * @brief   Kinds of trace events
+ */
+typedef enum {
+  SCHED_TRACE_SWITCH,      /**< arg0: previous PID, arg1: next PID | reason << 32 */
+  SCHED_TRACE_WAKEUP,      /**< arg0: woken PID, arg1: CPU it was queued on */
+  SCHED_TRACE_TICK,        /**< arg0: running PID */
+  SCHED_TRACE_PREEMPT_OFF, /**< arg0: counter ticks preemption was disabled for, arg1: address that enabled it */
+  SCHED_TRACE_IRQ_OFF,     /**< arg0: counter ticks IRQs were masked for, arg1: address that unmasked them */
+} SchedTraceType;
+
+/**
+ * @brief   Why the previous task left the CPU in a SCHED_TRACE_SWITCH event
+ */
+typedef enum {
+  SCHED_TRACE_PREEMPT, /**< Taken off by the tick while still runnable */
+  SCHED_TRACE_YIELD,   /**< Called schedule() while still runnable */
+  SCHED_TRACE_SLEEP,   /**< Blocked or went to sleep */
+  SCHED_TRACE_EXIT,    /**< Exited */
+} SchedTraceReason;
+
+/**
+ * @brief   One binary trace record
+ */
+struct SchedTraceEvent {
+  u64 timestamp; /**< Generic timer counter value */
+  u32 type;      /**< SchedTraceType */
+  u32 arg0;      /**< Event specific, see SchedTraceType */
+  u64 arg1;      /**< Event specific, see SchedTraceType */
+};
+
+#ifdef SCHED_TRACE
+
+/** @brief  Events kept per CPU, the oldest are overwritten once the ring is full */
+#define SCHED_TRACE_ENTRIES 1024U
+
+/** @brief  Histogram buckets. Bucket n counts durations in [2^(n-1), 2^n) us, bucket 0 those below 1 us */
+#define SCHED_TRACE_BUCKETS 20U
+
+/** @brief  Preemption and IRQ off sections shorter than this are not put in the ring, only in the maximum */
+#define SCHED_TRACE_OFF_THRESHOLD_US 20U
+
+/**
+ * @brief   Record a context switch, called with the runqueue locked
+ * @param   rq Runqueue of the CPU switching
+ * @param   prev Task leaving the CPU
+ * @param   next Task taking the CPU
+ * @param   preempt TRUE if the tick took prev off the CPU
+ */
+void sched_trace_switch(struct RunQueue *rq, struct TaskBlock *prev, struct TaskBlock *next, bool preempt);
+
+/**
+ * @brief   Record a wakeup or a new task, which starts its wakeup latency measurement
+ * @param   p Woken task
+ * @param   cpu CPU it was queued on
+ */
+void sched_trace_wakeup(struct TaskBlock *p, u32 cpu);
+
+/**
+ * @brief   Record a scheduler tick
+ * @param   curr Task the tick interrupted
+ */
+void sched_trace_tick(struct TaskBlock *curr);
+
+/**
+ * @brief   Mark the start of a preemption off section, when preempt_count leaves 0
+ */
+void sched_trace_preempt_off(void);
+
+/**
+ * @brief   Mark the end of a preemption off section, when preempt_count drops back to 0
+ * @param   caller Address that enabled preemption
+ */
+void sched_trace_preempt_on(u64 caller);
+
+/**
+ * @brief   Mark the start of an IRQ off section, called by irq_disable and irq_save_flags right after masking IRQs
+ */
+void sched_trace_irqs_off(void);
+
+/**
+ * @brief   Mark the end of an IRQ off section, called by irq_enable and irq_restore_flags right before unmasking IRQs
+ * @details Masking done by exception entry is not seen, so IRQ handlers are not counted
+ * @param   caller Address that unmasked IRQs
+ */
+void sched_trace_irqs_on(u64 caller);
+
+/**
+ * @brief   Print the wakeup latency and timeslice histograms and the longest off sections over the log UART
+ */
+void sched_trace_report(void);
+
+/**
+ * @brief   Print the rings of every CPU over the log UART, for tools/sched_trace_decode.py
+ */
+void sched_trace_dump(void);
+
+/**
+ * @brief   Clear the rings and the statistics
+ */
+void sched_trace_reset(void);
+
+#else
+
+/* Normal builds compile every hook away */
+#define sched_trace_switch(rq, prev, next, preempt)
+#define sched_trace_wakeup(p, cpu)
+#define sched_trace_tick(curr)
+#define sched_trace_preempt_off()
+#define sched_trace_preempt_on(caller)
+#define sched_trace_irqs_off()
+#define sched_trace_irqs_on(caller)
+
+static inline void sched_trace_report(void) {}
+static inline void sched_trace_dump(void) {}
+static inline void sched_trace_reset(void) {}
+
+#endif
+
+/** @} */
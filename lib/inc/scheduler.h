@@ -25,12 +25,17 @@
 #define CPU_CONTEXT_OFFSET 0  // offset of cpu_context in TaskBlock
 
 #ifndef __ASSEMBLER__
+#include <stdbool.h>
+
+#include "bcm2711_cpu.h"
 #include "common.h"
+#include "rbtree.h"
 
-/** @brief  Size allocated for Task */
+/** @brief  Size of the kernel stack of every task */
 #define TASK_SIZE 4096
 
-#define NUM_TASKS 10
+/** @brief  Number of buckets in the PID lookup table */
+#define PID_HASH_SIZE 256U
 
 #define TASK_RUNNING 0L
 #define TASK_SLEEPING 1L
@@ -38,10 +43,36 @@
 #define TASK_BLOCKED 3L
 
 #define PF_KTHREAD 2UL
+#define PF_JOINABLE 4UL /**< Kept as a zombie after exiting until task_wait collects its exit code */
+
+/** @brief  Zeroed stack pages kept from exited tasks for new ones */
+#define TASK_STACK_CACHE_SIZE 8U
+
+/** @brief  Affinity mask allowing every CPU, bit n stands for CPU n */
+#define CPU_MASK_ALL ((1U << NUM_CPUS) - 1U)
+
+struct AddressSpace;
+struct Mutex;
+struct SchedClass;
+
+extern struct TaskBlock init_task;
+extern u32 nr_tasks;
+
+/**
+ * @brief   Get the task running on this CPU
+ * @details Kept in TPIDR_EL1, so the read is a single instruction and stays correct if the task is preempted and
+ *          moved to another CPU halfway through
+ */
+static inline struct TaskBlock *get_current(void) {
+  struct TaskBlock *task;
+  asm volatile("mrs %0, tpidr_el1" : "=r"(task));
+  return task;
+}
+
+#define current get_current()
 
-extern struct TaskBlock *current;
-extern struct TaskBlock *task[NUM_TASKS];
-extern u8 num_tasks;
+/** @brief  Iterate over every task except the init task, which heads the list */
+#define for_each_task(p) for (p = init_task.next_task; p != &init_task; p = p->next_task)
 
 /**
  * @brief   CPU register context to be stored and loaded during context switches
@@ -62,6 +93,38 @@ struct CPUContext {
   u64 lr;
 };
 
+/**
+ * @brief   Fair scheduling state of a task
+ */
+struct SchedEntity {
+  struct RbNode run_node;    /**< Node in the fair runqueue, ordered by vruntime */
+  u64 vruntime;              /**< Runtime in nanoseconds, scaled by NICE_0_LOAD / weight */
+  u64 exec_start;            /**< Clock value runtime was last accounted at */
+  u64 sum_exec_runtime;      /**< Total nanoseconds spent on the CPU */
+  u64 prev_sum_exec_runtime; /**< sum_exec_runtime when the task was last picked */
+  u64 weight;                /**< Load weight derived from the priority */
+};
+
+/**
+ * @brief   Deadline scheduling state of a task
+ */
+struct DlEntity {
+  struct RbNode run_node;         /**< Node in the deadline runqueue, ordered by abs_deadline */
+  struct TaskBlock *release_next; /**< Next task waiting for a period to start */
+  u64 runtime;                    /**< Budget per period in nanoseconds */
+  u64 deadline;                   /**< Relative deadline in nanoseconds */
+  u64 period;                     /**< Period in nanoseconds */
+  u64 abs_deadline;               /**< Deadline of the current job */
+  u64 next_release;               /**< Start of the next period */
+  long remaining;                 /**< Budget left in the current period */
+  u64 exec_start;                 /**< Clock value runtime was last accounted at */
+  bool throttled;                 /**< Ran out of budget and waits for the next period */
+  bool parked;                    /**< Waits on the release list, either throttled or done with its job */
+  u64 activations;                /**< Periods started */
+  u64 misses;                     /**< Jobs finished after their deadline */
+  u64 overruns;                   /**< Jobs that used up their budget before finishing */
+};
+
 /**
  * @brief   Task Storage struct to track CPU registers, state and process information
  */
@@ -72,8 +135,34 @@ struct TaskBlock {
   long priority;
   long preempt_count;
 
-  unsigned long stack;
+  unsigned long stack; /**< Kernel stack page, the saved user registers sit at its top */
   unsigned long flags;
+
+  struct AddressSpace *mm; /**< User address space, NULL for kernel threads */
+
+  struct TaskBlock *rq_next; /**< Next task in the same runqueue list */
+  bool on_rq;                /**< Queued on the runqueue. The task on the CPU is never queued */
+  volatile bool on_cpu;      /**< Running, or not yet fully switched out. No other CPU may run it until cleared */
+  u32 cpu;                   /**< CPU the task last ran on. Its runqueue while queued */
+  u32 cpus_allowed;          /**< Affinity mask, bit n is set if the task may run on CPU n */
+
+  u32 pid;                     /**< Process ID, 0 for the init task */
+  struct TaskBlock *next_task; /**< Next task in the list of all tasks */
+  struct TaskBlock *prev_task; /**< Previous task in the list of all tasks */
+  struct TaskBlock *pid_next;  /**< Next task in the same PID lookup bucket */
+
+  u32 policy;                           /**< SCHED_NORMAL, SCHED_RR or SCHED_DEADLINE */
+  const struct SchedClass *sched_class; /**< Scheduling class implementing the policy */
+  struct SchedEntity se;                /**< Fair scheduling state, used by SCHED_NORMAL */
+  struct DlEntity dl;                   /**< Deadline scheduling state, used by SCHED_DEADLINE */
+  u32 normal_policy;                    /**< Policy set with scheduler_set_attr, policy differs while boosted */
+  long normal_priority;                 /**< Priority set at creation or with scheduler_set_attr */
+  long pi_rank;                         /**< Rank inherited from mutex waiters, SCHED_PI_NONE if none */
+  struct Mutex *pi_held;                /**< Held mutexes that have waiters, kept by the mutex code */
+
+  long exit_code;           /**< Value passed to task_exit */
+  struct TaskBlock *waiter; /**< Task collecting the exit code in task_wait */
+  u64 wakeup_stamp;         /**< Counter value when it was last woken, cleared once it runs. Used by SCHED_TRACE */
 };
 
 typedef struct {
@@ -89,11 +178,145 @@ typedef struct {
 #define MIN_TIMESLICE 2
 #define STARVATION_LIMIT 100
 
+/** @brief  Number of priority levels, indexed directly by priority */
+#define NUM_PRIORITIES (MAX_PRIORITY + 1)
+
+/** @brief  Frequency of the scheduler tick, which bounds preemption granularity. Set with make SCHED_TICK_HZ=n,
+ *          up to 10000 for a 100 us tick */
+#ifndef SCHED_TICK_HZ
+#define SCHED_TICK_HZ 250
+#endif
+
+#if SCHED_TICK_HZ < 100 || SCHED_TICK_HZ > 10000
+#error "SCHED_TICK_HZ must be between 100 and 10000"
+#endif
+
+/** @brief  Ticks in one scheduling quantum of about 4 ms. Round-robin timeslices and load averages count quanta,
+ *          so a finer tick only makes preemption more precise */
+#define SCHED_QUANTUM_TICKS (SCHED_TICK_HZ >= 250 ? SCHED_TICK_HZ / 250 : 1)
+
+/** @brief  Ticks between two periodic load balancing passes of a CPU */
+#define SCHED_BALANCE_TICKS (25U * SCHED_QUANTUM_TICKS)
+
+/** @brief  Fixed point scale of load averages, the load of one task that is always runnable */
+#define SCHED_LOAD_SCALE 1024U
+
+/** @brief  Fair share scheduling, the default policy */
+#define SCHED_NORMAL 0U
+/** @brief  Round-robin by priority, runs ahead of every SCHED_NORMAL task */
+#define SCHED_RR 1U
+/** @brief  Earliest deadline first with a runtime budget per period, runs ahead of every other policy */
+#define SCHED_DEADLINE 2U
+
+/** @brief  Priority inheritance rank of a task that inherits nothing. Every real rank is higher */
+#define SCHED_PI_NONE 0L
+
+/** @brief  Share of the CPU that SCHED_DEADLINE tasks may reserve in total, in percent */
+#define SCHED_DL_BANDWIDTH_LIMIT 95U
+
+/**
+ * @brief   Scheduling parameters of a task
+ */
+struct SchedAttr {
+  u32 policy;      /**< SCHED_NORMAL, SCHED_RR or SCHED_DEADLINE */
+  long priority;   /**< Priority for SCHED_NORMAL and SCHED_RR */
+  u64 runtime_ns;  /**< SCHED_DEADLINE CPU budget for every period */
+  u64 deadline_ns; /**< SCHED_DEADLINE deadline, relative to the start of the period */
+  u64 period_ns;   /**< SCHED_DEADLINE activation period */
+};
+
+/**
+ * @brief   Scheduler statistics of one CPU
+ */
+struct SchedCpuStats {
+  u64 switches;   /**< Context switches */
+  u64 migrations; /**< Tasks pulled from other CPUs */
+  u64 idle_ns;    /**< Time spent in the idle task */
+  u64 load_avg;   /**< Average number of runnable tasks, in SCHED_LOAD_SCALE units */
+  u64 ticks;      /**< Scheduler ticks taken, ticks stopped while idle are not counted */
+};
+
+/**
+ * @brief   One-shot timer fired from the scheduler tick
+ * @details Armed on the calling CPU and fired by its tick, so the resolution is one tick. An idle CPU with its
+ *          tick stopped still wakes up for it
+ */
+struct SchedTimer {
+  struct SchedTimer *next;              /**< Next timer armed on the same CPU */
+  u64 expires;                          /**< sched_clock() value the timer fires at */
+  void (*fn)(struct SchedTimer *timer); /**< Called from the tick IRQ, without scheduler locks held */
+  void *data;                           /**< Argument for fn */
+  u32 cpu;                              /**< CPU the timer was last armed on */
+  bool pending;                         /**< Armed and not yet fired or cancelled */
+};
+
 /**
  * @brief   Initialize the task scheduler
  */
 extern void scheduler_init(void);
 
+/**
+ * @brief   Start the secondary cores
+ * @details Must be called after scheduler_init, with the MMU and data cache already enabled through mmu_init and
+ *          mmu_enable_dcache. The exclusive accesses of the locks shared between cores rely on cacheable memory.
+ *          The mailbox and DMA drivers do no cache maintenance, so their buffers must then be mapped
+ *          PAGE_KERNEL_NC. Every core gets its own runqueue, idle task and tick
+ * @return  Number of online CPUs, including the boot CPU. 1 if the data cache is off
+ */
+u32 scheduler_smp_init(void);
+
+/**
+ * @brief   Get the number of online CPUs
+ * @return  Number of CPUs that take part in scheduling
+ */
+u32 scheduler_num_online_cpus(void);
+
+/**
+ * @brief   Read the scheduler statistics of a CPU
+ * @param   cpu CPU to read
+ * @param   stats Filled in with a snapshot of the statistics
+ */
+void scheduler_get_cpu_stats(u32 cpu, struct SchedCpuStats *stats);
+
+/**
+ * @brief   Restrict the CPUs a task may run on
+ * @details A queued task moves right away, a running one by the next tick at the latest. Deadline tasks never migrate,
+ *          so their mask must include the CPU they are on
+ * @param   pid Process ID of the task, 0 for the init task
+ * @param   mask Bit n allows CPU n. While none of its CPUs is online the task runs on the online ones
+ * @return  0 on success, -1 if the task does not exist or the mask is empty or not allowed
+ */
+int task_set_affinity(u32 pid, u32 mask);
+
+/**
+ * @brief   Read the affinity mask of a task
+ * @param   pid Process ID of the task
+ * @return  Affinity mask, 0 if the task does not exist
+ */
+u32 task_get_affinity(u32 pid);
+
+/**
+ * @brief   Keep CPUs out of load balancing and general task placement
+ * @details Only tasks whose affinity allows nothing but isolated CPUs run there. Other tasks queued on a newly
+ *          isolated CPU move right away, a task running there moves once it leaves the CPU. An isolated CPU also
+ *          stops its tick while a single task runs, so the task is only interrupted by its own timers and wakeups
+ * @param   mask Bit n isolates CPU n, 0 ends isolation. At least one online CPU must stay out of it
+ * @return  0 on success, -1 if the mask would isolate every online CPU
+ */
+int scheduler_isolate_cpus(u32 mask);
+
+/**
+ * @brief   Handle a reschedule IPI, called from the IRQ handler
+ * @details Restarts the tick of an isolated CPU that stopped it, since another task was queued there
+ */
+void scheduler_handle_ipi(void);
+
+/**
+ * @brief   C entry point of a released secondary core, called from boot.S on its idle task stack
+ * @param   cpu CPU ID
+ */
+void secondary_main(u32 cpu);
+
 /**
  * @brief
  */
@@ -101,24 +324,233 @@ void schedule(void);
 extern void scheduler_tick_handler(void);
 void preempt_disable(void);
 void preempt_enable(void);
-void switch_to(struct TaskBlock *next);
+
+/**
+ * @brief   Switch to another task
+ * @param   next Task to run
+ * @return  Task that was switched out to get back here, NULL if next could not be run
+ */
+struct TaskBlock *switch_to(struct TaskBlock *next);
+
+/**
+ * @brief   Finish a context switch on the stack of the task that was switched in
+ * @details Releases prev, so other CPUs may run it from now on. Also called by every new task as it starts
+ * @param   prev Task that was switched out, may be NULL
+ */
+void schedule_tail(struct TaskBlock *prev);
+
+/**
+ * @brief   Make a sleeping or blocked task runnable again
+ * @details Safe to call from interrupt handlers and from any CPU. The task is queued on the CPU it last ran on
+ *          unless that CPU is busy and another one is idle. It runs once it is picked, no reschedule is forced
+ * @param   p Task to wake
+ */
+void scheduler_wake_task(struct TaskBlock *p);
+
+/**
+ * @brief   Change the scheduling policy and priority of a task
+ * @param   pid Process ID of the task
+ * @param   policy SCHED_NORMAL or SCHED_RR
+ * @param   priority New priority, clamped to [MIN_PRIORITY, MAX_PRIORITY]
+ * @return  0 on success, -1 if the task does not exist or the policy is unknown
+ */
+int scheduler_set_policy(u32 pid, u32 policy, long priority);
+
+/**
+ * @brief   Rank of a task for priority inheritance, comparing tasks across policies
+ * @details SCHED_DEADLINE ranks above SCHED_RR, which ranks above SCHED_NORMAL. Within a policy the priority decides
+ * @param   p Task
+ * @return  Rank of the policy and priority the task runs at right now
+ */
+long scheduler_task_pi_rank(struct TaskBlock *p);
+
+/**
+ * @brief   Set the rank a task inherits from the tasks it blocks
+ * @details The task runs at its own policy and priority or the inherited rank, whichever is higher. A SCHED_NORMAL
+ *          task that inherits from a SCHED_RR task runs as SCHED_RR, an inherited SCHED_DEADLINE rank runs as
+ *          SCHED_RR at MAX_PRIORITY. Deadline tasks keep their reservation
+ * @param   p Task to change
+ * @param   rank Inherited rank from scheduler_task_pi_rank, SCHED_PI_NONE to drop it
+ */
+void scheduler_set_pi_rank(struct TaskBlock *p, long rank);
+
+/**
+ * @brief   Check whether the current task may block
+ * @return  TRUE once the scheduler runs and preemption is enabled
+ */
+bool scheduler_may_block(void);
+
+/**
+ * @brief   Change the scheduling parameters of a task
+ * @details SCHED_DEADLINE requires runtime <= deadline <= period, and is only granted while the total
+ *          runtime / period of all deadline tasks stays within SCHED_DL_BANDWIDTH_LIMIT. The first period
+ *          starts immediately
+ * @param   pid Process ID of the task
+ * @param   attr New parameters
+ * @return  0 on success, -1 if the task does not exist or the parameters are invalid,
+ *          -2 if admission control rejected the deadline reservation
+ */
+int scheduler_set_attr(u32 pid, const struct SchedAttr *attr);
+
+/**
+ * @brief   End the current job of a SCHED_DEADLINE task
+ * @details The task sleeps until its next period starts, with a fresh budget. A job that finishes after its
+ *          deadline is counted as a miss. Other tasks just yield the CPU
+ */
+void sched_wait_next_period(void);
+
+/**
+ * @brief   Tune the fair scheduling class
+ * @details Every runnable task gets a turn within the target latency, which is stretched once there are
+ *          more than latency / min_granularity tasks so no slice drops below the minimum granularity
+ * @param   latency_ns Target scheduling latency in nanoseconds
+ * @param   min_granularity_ns Minimum slice in nanoseconds
+ */
+void scheduler_set_fair_tunables(u64 latency_ns, u64 min_granularity_ns);
+
+/**
+ * @brief   Read the scheduler clock
+ * @return  Nanoseconds since boot
+ */
+u64 sched_clock(void);
+
+/**
+ * @brief   Initialize a timer
+ * @param   timer Timer storage
+ * @param   fn Callback, runs in IRQ context and must not sleep
+ * @param   data Argument for the callback
+ */
+void sched_timer_init(struct SchedTimer *timer, void (*fn)(struct SchedTimer *timer), void *data);
+
+/**
+ * @brief   Arm a timer on the calling CPU, or move it if it is already armed
+ * @details A timer must not be armed from two CPUs at the same time
+ * @param   timer Initialized timer
+ * @param   expires sched_clock() value to fire at
+ */
+void sched_timer_arm(struct SchedTimer *timer, u64 expires);
+
+/**
+ * @brief   Disarm a timer
+ * @details Waits for a callback that already started on another CPU, so the timer may be freed afterwards
+ * @param   timer Timer to cancel
+ * @return  TRUE if the timer was armed, FALSE if it already fired or was never armed
+ */
+bool sched_timer_cancel(struct SchedTimer *timer);
+
+/**
+ * @brief   Sleep until the scheduler clock reaches a point in time
+ * @details The task gives up the CPU and is woken by the tick once the time passed. Before the scheduler runs,
+ *          or with preemption disabled, this busy-waits instead
+ * @param   wake_ns sched_clock() value to sleep until
+ */
+void sleep_until(u64 wake_ns);
+
+/**
+ * @brief   Sleep for at least a number of microseconds, rounded up to the next tick
+ * @param   us Microseconds to sleep
+ */
+void usleep(u64 us);
+
+/**
+ * @brief   Sleep for at least a number of milliseconds, rounded up to the next tick
+ * @param   ms Milliseconds to sleep
+ */
+void msleep(u64 ms);
 
 extern u64 get_cpu_new_task_addr(void);
 int scheduler_create_task(u64 clone_flags, u64 func, u64 arg, long priority);
-int move_task_to_user_mode(u64 func);
+
+/**
+ * @brief   Create a task and report its process ID
+ * @details Same as scheduler_create_task. Exited tasks are reaped here, so their PIDs and memory are reused
+ * @param   pid Set to the PID of the new task on success, may be NULL
+ * @return  0 on success, 1 if the scheduler is not initialized, 2 if no PID is free, 3 or 4 if the task could
+ *          not be allocated, 5 if the address space could not be cloned
+ */
+int scheduler_create_task_pid(u64 clone_flags, u64 func, u64 arg, long priority, u32 *pid);
+
+/**
+ * @brief   Create a task that may only run on some CPUs
+ * @details Same as scheduler_create_task_pid, which gives the new task the affinity of the current task
+ * @param   cpus_allowed Affinity mask, bit n allows CPU n
+ * @return  0 on success, 6 if the mask allows no CPU, otherwise as scheduler_create_task_pid
+ */
+int scheduler_create_task_affinity(u64 clone_flags, u64 func, u64 arg, long priority, u32 cpus_allowed, u32 *pid);
+
+/**
+ * @brief   Look up a task by process ID
+ * @details Nothing keeps the task alive once this returns. An exited task is freed, so the pointer is only safe for
+ *          a task the caller knows is still running or has not been waited for yet
+ * @param   pid Process ID
+ * @return  Pointer to the task or NULL if no live task has this ID
+ */
+struct TaskBlock *scheduler_find_task(u32 pid);
+
+/**
+ * @brief   Move the current task to EL0 in a new address space
+ * @details The code in [start, start + size) is copied to USER_VA_START, so it must be position
+ *          independent and only reference memory within that range
+ * @param   start Start of the user code
+ * @param   size Size of the user code in bytes
+ * @param   pc Entry point, within [start, start + size)
+ * @return  0 on success, -1 if the address space could not be created
+ */
+int move_task_to_user_mode(u64 start, u64 size, u64 pc);
+
+/**
+ * @brief   End the current task with exit code 0
+ */
 void scheduler_exit_task();
+
+/**
+ * @brief   End the current task
+ * @details Never returns. The stack and task block are freed once no CPU runs on them anymore, by the next task
+ *          creation, task_wait or an idle CPU. A PF_JOINABLE task keeps its task block and PID until it is waited for
+ * @param   exit_code Value reported to task_wait
+ */
+void task_exit(long exit_code);
+
+/**
+ * @brief   Wait for a PF_JOINABLE task to exit and release it
+ * @param   pid Process ID of the task
+ * @param   exit_code Set to the value the task passed to task_exit, may be NULL
+ * @return  0 on success, -1 if there is no such joinable task, it is the current task or another task waits for it
+ */
+int task_wait(u32 pid, long *exit_code);
 ProcessStateRegisters *get_current_pstate(struct TaskBlock *task);
-void cpu_context_switch(struct TaskBlock *prev, struct TaskBlock *next);
-
-#define INIT_TASK /* CpuContext */             \
-  {                                            \
-    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, \
-    0, /* state */                             \
-    0, /* counter */                           \
-    1, /* priority */                          \
-    0, /* preempt_count */                     \
-    0, /* stack */                             \
-    0  /* flags */                             \
+struct TaskBlock *cpu_context_switch(struct TaskBlock *prev, struct TaskBlock *next);
+
+#define INIT_TASK /* CpuContext */                                     \
+  {                                                                    \
+    { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 },                         \
+    0, /* state */                                                     \
+    0, /* counter */                                                   \
+    1, /* priority */                                                  \
+    0, /* preempt_count */                                             \
+    0, /* stack */                                                     \
+    0, /* flags */                                                     \
+    0, /* mm */                                                        \
+    0, /* rq_next */                                                   \
+    0, /* on_rq */                                                     \
+    0, /* on_cpu */                                                    \
+    0, /* cpu */                                                       \
+    CPU_MASK_ALL, /* cpus_allowed */                                   \
+    0, /* pid */                                                       \
+    0, /* next_task */                                                 \
+    0, /* prev_task */                                                 \
+    0, /* pid_next */                                                  \
+    0, /* policy */                                                    \
+    0, /* sched_class */                                               \
+    { { 0, 0, 0, 0 }, 0, 0, 0, 0, 0 }, /* se */                        \
+    { { 0, 0, 0, 0 }, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0 }, /* dl */ \
+    0, /* normal_policy */                                             \
+    1, /* normal_priority */                                           \
+    0, /* pi_rank */                                                   \
+    0, /* pi_held */                                                   \
+    0, /* exit_code */                                                 \
+    0, /* waiter */                                                    \
+    0, /* wakeup_stamp */                                              \
   }
 
 #endif
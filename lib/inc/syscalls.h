@@ -1,17 +1,19 @@
 #pragma once
 
-#define NUM_SYSCALLS 4
+#define NUM_SYSCALLS 5
 
 #define SYS_WRITE_NUMBER 0
 #define SYS_MALLOC_NUMBER 1
 #define SYS_CREATE_TASK_NUMBER 2
 #define SYS_EXIT_NUMBER 3
+#define SYS_GETPID_NUMBER 4
 
 #ifndef __ASSEMBLER__
 
-void call_sys_write(void);
-void call_sys_malloc(void);
-void call_sys_create_task(void);
-void call_sys_exit(void);
+void call_sys_write(char *buf);
+unsigned long call_sys_malloc(void);
+int call_sys_create_task(void (*func)(void *), void *arg);
+void call_sys_exit(long exit_code);
+int call_sys_getpid(void);
 
 #endif
@@ -9,10 +9,51 @@
 #define SCTLR_D_CACHE_DISABLED (0 << 2)
 #define SCTLR_MMU_DISABLED (0 << 0)  // Disable memory management unit (MMU)
 #define SCTLR_MMU_ENABLED (1 << 0)   // Enable memory management unit (MMU)
+#define SCTLR_D_CACHE_ENABLED (1 << 2)
+#define SCTLR_I_CACHE_ENABLED (1 << 12)
 
 #define SCTLR_VALUE_MMU_DISABLED \
   (SCTLR_RESERVED | SCTLR_EE_LITTLE_ENDIAN | SCTLR_I_CACHE_DISABLED | SCTLR_D_CACHE_DISABLED | SCTLR_MMU_DISABLED)
 
+// MAIR_EL1, Memory Attribute Indirection Register (EL1)
+// Each attribute index used by a descriptor (AttrIndx) selects one byte of MAIR_EL1
+
+#define MT_DEVICE_nGnRnE 0  // Peripherals
+#define MT_NORMAL_NC 1      // Normal memory, non-cacheable (buffers shared with the VideoCore/DMA)
+#define MT_NORMAL 2         // Normal memory, write-back cacheable
+
+#define MT_DEVICE_nGnRnE_FLAGS 0x00
+#define MT_NORMAL_NC_FLAGS 0x44
+#define MT_NORMAL_FLAGS 0xFF
+#define MAIR_VALUE \
+  ((MT_DEVICE_nGnRnE_FLAGS << (8 * MT_DEVICE_nGnRnE)) | (MT_NORMAL_NC_FLAGS << (8 * MT_NORMAL_NC)) | \
+   (MT_NORMAL_FLAGS << (8 * MT_NORMAL)))
+
+// TCR_EL1, Translation Control Register (EL1)
+// 39-bit virtual addresses in both halves, 4 KB granule, translation starts at level 1
+
+#define TCR_T0SZ (64 - 39)
+#define TCR_T1SZ ((64 - 39) << 16)
+#define TCR_IRGN0_WBWA (1UL << 8)  // Table walks through the inner write-back cache
+#define TCR_ORGN0_WBWA (1UL << 10)
+#define TCR_SH0_INNER (3UL << 12)
+#define TCR_TG0_4K (0UL << 14)
+#define TCR_IRGN1_WBWA (1UL << 24)
+#define TCR_ORGN1_WBWA (1UL << 26)
+#define TCR_SH1_INNER (3UL << 28)
+#define TCR_TG1_4K (2UL << 30)
+#define TCR_IPS_36BIT (1UL << 32)  // 64 GB physical address space
+#define TCR_AS_16BIT (1UL << 36)   // 16-bit ASIDs, only if ID_AA64MMFR0_EL1 reports support
+#define TCR_VALUE                                                                                                        \
+  (TCR_T0SZ | TCR_T1SZ | TCR_IRGN0_WBWA | TCR_ORGN0_WBWA | TCR_SH0_INNER | TCR_TG0_4K | TCR_IRGN1_WBWA | TCR_ORGN1_WBWA | \
+   TCR_SH1_INNER | TCR_TG1_4K | TCR_IPS_36BIT)
+
+// ID_AA64MMFR0_EL1, Memory Model Feature Register 0
+
+#define ID_AA64MMFR0_ASID_SHIFT 4
+#define ID_AA64MMFR0_ASID_MASK 0xF
+#define ID_AA64MMFR0_ASID_16BIT 2
+
 // HCR_EL2, Hypervisor Configuration Register (EL2), Page 2487 of AArch64-Reference-Manual
 
 #define HCR_RW (1 << 31)  // When this is set to 0, it puts EL2 in AArch32
@@ -34,6 +75,14 @@
 // ESR_EL1, Exception syndrome register (EL1) Page 2431 of AArch64-Reference-Manual
 #define ESR_EL1_EC_SHIFT 26
 #define ESR_EL1_EC_SVC64 0x15
+#define ESR_EL1_EC_IABT_LOW 0x20  // Instruction abort from EL0
+#define ESR_EL1_EC_DABT_LOW 0x24  // Data abort from EL0
+#define ESR_EL1_EC_DABT_CUR 0x25  // Data abort from EL1
+#define ESR_EL1_WNR (1 << 6)      // Data abort caused by a write
+#define ESR_EL1_FSC_TYPE_MASK 0x3C
+#define ESR_EL1_FSC_TRANSLATION 0x04
+#define ESR_EL1_FSC_ACCESS 0x08  // Access flag fault
+#define ESR_EL1_FSC_PERMISSION 0x0C
 
 // PSR bits
 #define PSR_MODE_EL0t 0x00000000
@@ -43,3 +92,4 @@
 #define PSR_MODE_EL2h 0x00000009
 #define PSR_MODE_EL3t 0x0000000C
 #define PSR_MODE_EL3h 0x0000000D
+#define PSR_I_BIT_SHIFT 7  // Set while IRQs are masked
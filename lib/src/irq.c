@@ -1,15 +1,22 @@
 #include "irq.h"
 
 #include "aux_reg.h"
+#include "bcm2711_cpu.h"
 #include "entry.h"
 #include "gpio.h"
 #include "log.h"
 #include "mini_uart.h"
+#include "scheduler.h"
 #include "timer.h"
 #include "uart.h"
 #include "utils.h"
 
-const char entry_error_messages[17][32] = {
+static void (*ipi_hooks[NUM_CPUS])(void);
+
+/* Images that never unmask UART0 interrupts link without a handler of their own */
+__attribute__((weak)) void handle_uart0_irq() {}
+
+const char entry_error_messages[18][32] = {
   "SYNC_INVALID_EL1t",   "IRQ_INVALID_EL1t",   "FIQ_INVALID_EL1t",   "ERROR_INVALID_EL1T",
 
   "SYNC_INVALID_EL1h",   "IRQ_INVALID_EL1h",   "FIQ_INVALID_EL1h",   "ERROR_INVALID_EL1h",
@@ -18,7 +25,7 @@ const char entry_error_messages[17][32] = {
 
   "SYNC_INVALID_EL0_32", "IRQ_INVALID_EL0_32", "FIQ_INVALID_EL0_32", "ERROR_INVALID_EL0_32",
 
-  "SYSCALL_ERROR",
+  "SYSCALL_ERROR",       "DATA_ABORT_ERROR",
 };
 
 void show_invalid_entry_message(u32 type, u64 esr, u64 address, u64 fault_addr_reg, u64 stack_pointer) {
@@ -55,9 +62,40 @@ void enable_interrupt_controller() {
 #endif
 }
 
+void irq_enable_ipi(void) {
+  LOCAL_IRQ_REGS->mailbox_control[get_cpu_id()] = 1U;  // Mailbox 0 IRQ
+}
+
+void irq_send_reschedule(u32 cpu) {
+  LOCAL_IRQ_REGS->mailbox_set[cpu * 4U] = 1U;
+}
+
+void irq_set_ipi_hook(void (*hook)(void)) {
+  ipi_hooks[get_cpu_id()] = hook;
+}
+
 void handle_irq() {
   u32 irq_pending_0;
   u32 irq_pending_1;
+  u32 cpu = get_cpu_id();
+
+  // Every core takes its own generic timer through the local controller. The shared controller only interrupts core 0
+  if (LOCAL_IRQ_REGS->irq_source[cpu] & LOCAL_IRQ_CNTPNS) {
+    handle_local_timer_irq();
+  }
+
+  // A reschedule IPI carries no data. The interrupted idle task schedules once it resumes, a busy isolated CPU
+  // gets its tick back
+  if (LOCAL_IRQ_REGS->irq_source[cpu] & LOCAL_IRQ_MAILBOX0) {
+    LOCAL_IRQ_REGS->mailbox_clear[cpu * 4U] = 0xFFFFFFFF;
+    scheduler_handle_ipi();
+    if (ipi_hooks[cpu]) {
+      ipi_hooks[cpu]();
+    }
+  }
+  if (cpu != 0) {
+    return;
+  }
 
 #if RPI_VERSION == 4
   irq_pending_0 = IRQ_REGS->irq0_pending_0;  // Interrupts 0-31
@@ -2,29 +2,37 @@
 
 #include "log.h"
 #include "mem_utils.h"
+#include "spinlock.h"
 
 #define MAX_MANAGED_PAGES 512
 static u8 mem_map[MAX_MANAGED_PAGES] = { 0 };
 
+// Task stacks are allocated and freed from every core
+static struct Spinlock mem_map_lock = SPIN_LOCK_INIT;
+
 void *get_free_page() {
-  for (u32 i = 0; i < PAGING_PAGES; i++) {
+  spin_lock(&mem_map_lock);
+  for (u32 i = 0; i < MAX_MANAGED_PAGES; i++) {
     if (mem_map[i] == 0) {
       mem_map[i] = 1;
       u64 page_addr = LOW_MEMORY + i * PAGE_SIZE;
 
       if (page_addr < LOW_MEMORY || page_addr >= (MAX_MANAGED_PAGES * PAGE_SIZE + LOW_MEMORY)) {
-        log("Error: Invalid page address calculated: 0x%ld\n\r", page_addr);
         mem_map[i] = 0;
+        spin_unlock(&mem_map_lock);
+        log("Error: Invalid page address calculated: 0x%ld\n\r", page_addr);
         return 0;
       }
+      spin_unlock(&mem_map_lock);
       return (void *)page_addr;
     }
   }
+  spin_unlock(&mem_map_lock);
   return 0;
 }
 
 void free_page(u64 p) {
-  if (p < LOW_MEMORY || p >= MAX_MANAGED_PAGES * PAGE_SIZE) {
+  if (p < LOW_MEMORY || p >= LOW_MEMORY + MAX_MANAGED_PAGES * PAGE_SIZE) {
     log("Error: Attempting to free invalid page: 0x%ld\n\r", p);
     return;
   }
@@ -35,5 +43,7 @@ void free_page(u64 p) {
     return;
   }
 
+  spin_lock(&mem_map_lock);
   mem_map[index] = 0;
+  spin_unlock(&mem_map_lock);
 }
@@ -0,0 +1,72 @@
+/*******************************************************************************************************************************
+ * @file   pid.c
+ *
+ * @brief  Process ID allocator source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "spinlock.h"
+
+/* Intra-component Headers */
+#include "pid.h"
+
+#define PID_WORDS (PID_MAX / 64U)
+
+static struct Spinlock pid_lock = SPIN_LOCK_INIT;
+
+/* Bit 0 is set so PID 0 stays with the init task */
+static u64 pid_bitmap[PID_WORDS] = { 1U };
+
+/* Last PID handed out. The search starts after it, which delays reuse and keeps allocation O(1) on average */
+static u32 last_pid = 0U;
+
+u32 pid_alloc(void) {
+  spin_lock(&pid_lock);
+
+  u32 start = (last_pid + 1U) % PID_MAX;
+  u32 word = start / 64U;
+
+  // The first word is checked twice, once from the search start and once in full after wrapping around
+  u64 mask = ~0ULL << (start % 64U);
+
+  for (u32 i = 0U; i <= PID_WORDS; i++) {
+    u64 free = ~pid_bitmap[word] & mask;
+
+    if (free) {
+      u32 pid = word * 64U + (u32)__builtin_ctzll(free);
+      pid_bitmap[word] |= (1ULL << (pid % 64U));
+      last_pid = pid;
+      spin_unlock(&pid_lock);
+      return pid;
+    }
+
+    word = (word + 1U) % PID_WORDS;
+    mask = ~0ULL;
+  }
+
+  spin_unlock(&pid_lock);
+  return PID_NONE;
+}
+
+void pid_free(u32 pid) {
+  if (pid == PID_NONE || pid >= PID_MAX) {
+    return;
+  }
+
+  spin_lock(&pid_lock);
+  pid_bitmap[pid / 64U] &= ~(1ULL << (pid % 64U));
+  spin_unlock(&pid_lock);
+}
+
+bool pid_in_use(u32 pid) {
+  if (pid >= PID_MAX) {
+    return false;
+  }
+
+  return (pid_bitmap[pid / 64U] >> (pid % 64U)) & 1U;
+}
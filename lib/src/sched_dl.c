@@ -0,0 +1,283 @@
+/*******************************************************************************************************************************
+ * @file   sched_dl.c
+ *
+ * @brief  Earliest deadline first scheduling class source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stddef.h>
+
+/* Inter-component Headers */
+
+/* Intra-component Headers */
+#include "sched_class.h"
+
+#define task_of(node) rb_entry(node, struct TaskBlock, dl.run_node)
+
+/* Clock values wrap, so order by the signed distance instead of the raw value */
+static inline bool dl_time_before(u64 a, u64 b) {
+  return (long)(a - b) < 0;
+}
+
+static inline u64 dl_bandwidth(u64 runtime, u64 period) {
+  return (runtime << DL_BW_SHIFT) / period;
+}
+
+static void timeline_insert(struct DlRunQueue *dl_rq, struct TaskBlock *p) {
+  struct RbNode **link = &dl_rq->timeline.node;
+  struct RbNode *parent = NULL;
+  bool leftmost = true;
+
+  while (*link) {
+    parent = *link;
+    if (dl_time_before(p->dl.abs_deadline, task_of(parent)->dl.abs_deadline)) {
+      link = &parent->left;
+    } else {
+      link = &parent->right;
+      leftmost = false;
+    }
+  }
+
+  rb_insert(&dl_rq->timeline, &p->dl.run_node, parent, link, leftmost);
+  dl_rq->nr_running++;
+}
+
+static void timeline_remove(struct DlRunQueue *dl_rq, struct TaskBlock *p) {
+  rb_erase(&dl_rq->timeline, &p->dl.run_node);
+  dl_rq->nr_running--;
+}
+
+/* Park a task until its next period. The list is short, one entry per deadline task at most */
+static void release_insert(struct DlRunQueue *dl_rq, struct TaskBlock *p) {
+  struct TaskBlock **link = &dl_rq->release_head;
+
+  while (*link && !dl_time_before(p->dl.next_release, (*link)->dl.next_release)) {
+    link = &(*link)->dl.release_next;
+  }
+
+  p->dl.release_next = *link;
+  *link = p;
+  p->dl.parked = true;
+}
+
+static void release_remove(struct DlRunQueue *dl_rq, struct TaskBlock *p) {
+  struct TaskBlock **link = &dl_rq->release_head;
+
+  while (*link && *link != p) {
+    link = &(*link)->dl.release_next;
+  }
+
+  if (*link) {
+    *link = p->dl.release_next;
+  }
+
+  p->dl.release_next = NULL;
+  p->dl.parked = false;
+}
+
+/* Start a new period at the given time with a full budget */
+static void replenish(struct TaskBlock *p, u64 release) {
+  p->dl.remaining = (long)p->dl.runtime;
+  p->dl.abs_deadline = release + p->dl.deadline;
+  p->dl.next_release = release + p->dl.period;
+  p->dl.throttled = false;
+  p->dl.activations++;
+}
+
+/* Start the period that was due at next_release. A task that overran by more than a period restarts now
+ * instead of queueing up missed deadlines */
+static void start_next_period(struct RunQueue *rq, struct TaskBlock *p) {
+  u64 release = p->dl.next_release;
+
+  if (dl_time_before(release + p->dl.deadline, rq->clock)) {
+    release = rq->clock;
+  }
+  replenish(p, release);
+}
+
+static void update_curr_dl(struct RunQueue *rq, struct TaskBlock *p) {
+  u64 delta = rq->clock - p->dl.exec_start;
+
+  if ((long)delta <= 0) {
+    return;
+  }
+
+  p->dl.exec_start = rq->clock;
+  p->dl.remaining -= (long)delta;
+  p->se.sum_exec_runtime += delta;
+}
+
+static void enqueue_task_dl(struct RunQueue *rq, struct TaskBlock *p, u32 flags) {
+  // Woken early while waiting for its next period, the task keeps its current deadline
+  if (p->dl.parked) {
+    release_remove(&rq->dl, p);
+  }
+
+  // A task woken after its deadline would carry a stale deadline into the queue, so it starts a new period
+  if ((flags & ENQUEUE_WAKEUP) && dl_time_before(p->dl.abs_deadline, rq->clock)) {
+    replenish(p, rq->clock);
+  }
+
+  timeline_insert(&rq->dl, p);
+}
+
+static void dequeue_task_dl(struct RunQueue *rq, struct TaskBlock *p) {
+  timeline_remove(&rq->dl, p);
+}
+
+static struct TaskBlock *pick_next_task_dl(struct RunQueue *rq) {
+  struct RbNode *leftmost = rb_first(&rq->dl.timeline);
+
+  if (!leftmost) {
+    return NULL;
+  }
+
+  struct TaskBlock *p = task_of(leftmost);
+  timeline_remove(&rq->dl, p);
+
+  p->dl.exec_start = rq->clock;
+  return p;
+}
+
+static bool put_prev_task_dl(struct RunQueue *rq, struct TaskBlock *p, bool runnable) {
+  update_curr_dl(rq, p);
+
+  // Budget enforcement. The task stays runnable but waits for its next period
+  if (p->dl.remaining <= 0 && !p->dl.throttled && !p->dl.parked) {
+    p->dl.throttled = true;
+    p->dl.overruns++;
+  }
+
+  // Only a runnable task waits on the release list. One that blocks or exits stays marked, enqueue_task_dl starts
+  // a new period if it is woken after its deadline
+  if (p->dl.throttled) {
+    if (runnable && !p->dl.parked) {
+      release_insert(&rq->dl, p);
+    }
+    return false;
+  }
+
+  if (runnable) {
+    timeline_insert(&rq->dl, p);
+  }
+  return runnable;
+}
+
+static bool task_tick_dl(struct RunQueue *rq, struct TaskBlock *p) {
+  update_curr_dl(rq, p);
+
+  if (p->dl.remaining <= 0) {
+    return true;
+  }
+
+  // A released task with an earlier deadline preempts
+  struct RbNode *leftmost = rb_first(&rq->dl.timeline);
+  return leftmost && dl_time_before(task_of(leftmost)->dl.abs_deadline, p->dl.abs_deadline);
+}
+
+static bool has_tasks_dl(struct RunQueue *rq) {
+  return rq->dl.nr_running > 0;
+}
+
+static void switched_to_dl(struct RunQueue *rq, struct TaskBlock *p) {
+  if (p->dl.parked) {
+    release_remove(&rq->dl, p);
+  }
+
+  replenish(p, rq->clock);
+  p->dl.exec_start = rq->clock;
+}
+
+static bool switched_from_dl(struct RunQueue *rq, struct TaskBlock *p) {
+  rq->dl.total_bw -= dl_bandwidth(p->dl.runtime, p->dl.period);
+
+  bool parked = p->dl.parked;
+  if (parked) {
+    release_remove(&rq->dl, p);
+  }
+  p->dl.throttled = false;
+
+  return parked;
+}
+
+void dl_init_rq(struct RunQueue *rq) {
+  rq->dl.timeline = (struct RbRoot)RB_ROOT_INIT;
+  rq->dl.release_head = NULL;
+  rq->dl.total_bw = 0U;
+  rq->dl.nr_running = 0U;
+}
+
+int dl_admit(struct RunQueue *rq, struct TaskBlock *p, const struct SchedAttr *attr) {
+  if (attr->runtime_ns == 0U || attr->runtime_ns > attr->deadline_ns || attr->deadline_ns > attr->period_ns) {
+    return -1;
+  }
+
+  u64 limit = ((u64)SCHED_DL_BANDWIDTH_LIMIT << DL_BW_SHIFT) / 100U;
+  u64 new_bw = dl_bandwidth(attr->runtime_ns, attr->period_ns);
+  u64 old_bw = (p->policy == SCHED_DEADLINE) ? dl_bandwidth(p->dl.runtime, p->dl.period) : 0U;
+
+  if (rq->dl.total_bw - old_bw + new_bw > limit) {
+    return -2;
+  }
+
+  rq->dl.total_bw = rq->dl.total_bw - old_bw + new_bw;
+  p->dl.runtime = attr->runtime_ns;
+  p->dl.deadline = attr->deadline_ns;
+  p->dl.period = attr->period_ns;
+  return 0;
+}
+
+struct TaskBlock *dl_pop_release(struct RunQueue *rq) {
+  struct TaskBlock *p = rq->dl.release_head;
+
+  if (!p || dl_time_before(rq->clock, p->dl.next_release)) {
+    return NULL;
+  }
+
+  release_remove(&rq->dl, p);
+  start_next_period(rq, p);
+
+  return p;
+}
+
+bool dl_next_release(struct RunQueue *rq, u64 *release) {
+  if (!rq->dl.release_head) {
+    return false;
+  }
+
+  *release = rq->dl.release_head->dl.next_release;
+  return true;
+}
+
+bool dl_finish_job(struct RunQueue *rq, struct TaskBlock *p) {
+  update_curr_dl(rq, p);
+
+  if (dl_time_before(p->dl.abs_deadline, rq->clock)) {
+    p->dl.misses++;
+  }
+
+  if (!dl_time_before(rq->clock, p->dl.next_release)) {
+    start_next_period(rq, p);
+    return false;
+  }
+
+  release_insert(&rq->dl, p);
+  return true;
+}
+
+const struct SchedClass dl_sched_class = {
+  .next = &rr_sched_class,
+  .enqueue_task = enqueue_task_dl,
+  .dequeue_task = dequeue_task_dl,
+  .pick_next_task = pick_next_task_dl,
+  .put_prev_task = put_prev_task_dl,
+  .task_tick = task_tick_dl,
+  .has_tasks = has_tasks_dl,
+  .switched_to = switched_to_dl,
+  .switched_from = switched_from_dl,
+  /* Bandwidth is admitted per CPU, so deadline tasks never migrate */
+  .steal_task = NULL,
+};
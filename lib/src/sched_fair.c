@@ -0,0 +1,257 @@
+/*******************************************************************************************************************************
+ * @file   sched_fair.c
+ *
+ * @brief  Completely fair scheduling class source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stddef.h>
+
+/* Inter-component Headers */
+
+/* Intra-component Headers */
+#include "sched_class.h"
+
+static u64 sched_latency_ns = 20U * NSEC_PER_MSEC;
+static u64 sched_min_granularity_ns = 4U * NSEC_PER_MSEC;
+
+/* Each priority step is worth about 1.25x the CPU time, the same ratio as one Linux nice level */
+static const u64 prio_to_weight[NUM_PRIORITIES] = { 0, 420, 524, 655, 820, 1024, 1280, 1600, 2000, 2500, 3125 };
+
+#define task_of(node) rb_entry(node, struct TaskBlock, se.run_node)
+
+/* vruntime wraps, so order by the signed distance instead of the raw value */
+static inline bool vruntime_before(u64 a, u64 b) {
+  return (long)(a - b) < 0;
+}
+
+static inline u64 vruntime_max(u64 a, u64 b) {
+  return vruntime_before(a, b) ? b : a;
+}
+
+static inline u64 calc_delta_fair(u64 delta, struct SchedEntity *se) {
+  return (delta * NICE_0_LOAD) / se->weight;
+}
+
+static u64 sched_period(u32 nr_running) {
+  if (nr_running > sched_latency_ns / sched_min_granularity_ns) {
+    return nr_running * sched_min_granularity_ns;
+  }
+
+  return sched_latency_ns;
+}
+
+/* Wall clock share of the period for a task. on_cpu counts the task as well as the queued ones */
+static u64 sched_slice(struct CfsRunQueue *cfs, struct SchedEntity *se, bool on_cpu) {
+  u32 nr_running = cfs->nr_running + (on_cpu ? 1U : 0U);
+  u64 load = cfs->load_weight + (on_cpu ? se->weight : 0U);
+
+  return (sched_period(nr_running) * se->weight) / load;
+}
+
+static void update_min_vruntime(struct CfsRunQueue *cfs, struct SchedEntity *curr) {
+  struct RbNode *leftmost = rb_first(&cfs->timeline);
+  u64 vruntime;
+
+  if (curr && leftmost) {
+    vruntime = curr->vruntime;
+    if (vruntime_before(task_of(leftmost)->se.vruntime, vruntime)) {
+      vruntime = task_of(leftmost)->se.vruntime;
+    }
+  } else if (curr) {
+    vruntime = curr->vruntime;
+  } else if (leftmost) {
+    vruntime = task_of(leftmost)->se.vruntime;
+  } else {
+    return;
+  }
+
+  cfs->min_vruntime = vruntime_max(cfs->min_vruntime, vruntime);
+}
+
+static void update_curr(struct RunQueue *rq, struct TaskBlock *p) {
+  struct SchedEntity *se = &p->se;
+  u64 delta = rq->clock - se->exec_start;
+
+  if ((long)delta <= 0) {
+    return;
+  }
+
+  se->exec_start = rq->clock;
+  se->sum_exec_runtime += delta;
+  se->vruntime += calc_delta_fair(delta, se);
+
+  update_min_vruntime(&rq->cfs, se);
+}
+
+static void timeline_insert(struct CfsRunQueue *cfs, struct TaskBlock *p) {
+  struct SchedEntity *se = &p->se;
+  struct RbNode **link = &cfs->timeline.node;
+  struct RbNode *parent = NULL;
+  bool leftmost = true;
+
+  // The weight is refreshed on every insert, so priority changes apply from the next time the task is queued
+  se->weight = prio_to_weight[p->priority];
+
+  while (*link) {
+    parent = *link;
+    if (vruntime_before(se->vruntime, task_of(parent)->se.vruntime)) {
+      link = &parent->left;
+    } else {
+      link = &parent->right;
+      leftmost = false;
+    }
+  }
+
+  rb_insert(&cfs->timeline, &se->run_node, parent, link, leftmost);
+  cfs->load_weight += se->weight;
+  cfs->nr_running++;
+}
+
+static void timeline_remove(struct CfsRunQueue *cfs, struct TaskBlock *p) {
+  rb_erase(&cfs->timeline, &p->se.run_node);
+  cfs->load_weight -= p->se.weight;
+  cfs->nr_running--;
+}
+
+static void place_entity(struct CfsRunQueue *cfs, struct TaskBlock *p, u32 flags) {
+  struct SchedEntity *se = &p->se;
+  u64 vruntime = cfs->min_vruntime;
+
+  if (flags & ENQUEUE_NEW) {
+    // New tasks start one slice behind, so a task that keeps forking cannot hold on to the CPU
+    se->weight = prio_to_weight[p->priority];
+    se->vruntime = vruntime + calc_delta_fair(sched_slice(cfs, se, true), se);
+    return;
+  }
+
+  // Sleepers get up to half a latency period of credit, but never move back in time
+  vruntime -= sched_latency_ns / 2U;
+  se->vruntime = vruntime_max(se->vruntime, vruntime);
+}
+
+static void enqueue_task_fair(struct RunQueue *rq, struct TaskBlock *p, u32 flags) {
+  // steal_task_fair and fair_migrate_task left the vruntime relative to the min_vruntime of the old runqueue
+  if (flags & ENQUEUE_MIGRATED) {
+    p->se.vruntime += rq->cfs.min_vruntime;
+  }
+
+  if (flags & (ENQUEUE_NEW | ENQUEUE_WAKEUP)) {
+    place_entity(&rq->cfs, p, flags);
+  }
+
+  timeline_insert(&rq->cfs, p);
+}
+
+static void dequeue_task_fair(struct RunQueue *rq, struct TaskBlock *p) {
+  timeline_remove(&rq->cfs, p);
+  update_min_vruntime(&rq->cfs, NULL);
+}
+
+static struct TaskBlock *pick_next_task_fair(struct RunQueue *rq) {
+  struct RbNode *leftmost = rb_first(&rq->cfs.timeline);
+
+  if (!leftmost) {
+    return NULL;
+  }
+
+  struct TaskBlock *p = task_of(leftmost);
+  timeline_remove(&rq->cfs, p);
+
+  p->se.exec_start = rq->clock;
+  p->se.prev_sum_exec_runtime = p->se.sum_exec_runtime;
+  return p;
+}
+
+static bool put_prev_task_fair(struct RunQueue *rq, struct TaskBlock *p, bool runnable) {
+  update_curr(rq, p);
+
+  if (runnable) {
+    timeline_insert(&rq->cfs, p);
+  }
+  return runnable;
+}
+
+static bool task_tick_fair(struct RunQueue *rq, struct TaskBlock *p) {
+  struct SchedEntity *se = &p->se;
+
+  update_curr(rq, p);
+
+  if (rq->cfs.nr_running == 0) {
+    return false;
+  }
+
+  u64 delta_exec = se->sum_exec_runtime - se->prev_sum_exec_runtime;
+  u64 ideal_runtime = sched_slice(&rq->cfs, se, true);
+
+  if (delta_exec > ideal_runtime) {
+    return true;
+  }
+
+  // Do not switch before the minimum granularity, however far ahead the task is
+  if (delta_exec < sched_min_granularity_ns) {
+    return false;
+  }
+
+  struct SchedEntity *leftmost = &task_of(rb_first(&rq->cfs.timeline))->se;
+  return (long)(se->vruntime - leftmost->vruntime) > (long)ideal_runtime;
+}
+
+static bool has_tasks_fair(struct RunQueue *rq) {
+  return rq->cfs.nr_running > 0;
+}
+
+static struct TaskBlock *steal_task_fair(struct RunQueue *rq, u32 dst_cpu) {
+  for (struct RbNode *node = rb_first(&rq->cfs.timeline); node; node = rb_next(node)) {
+    struct TaskBlock *p = task_of(node);
+    if (p->on_cpu || !(p->cpus_allowed & (1U << dst_cpu))) {
+      continue;
+    }
+
+    // min_vruntime of two runqueues are unrelated, so only the lag behind it moves with the task
+    timeline_remove(&rq->cfs, p);
+    p->se.vruntime -= rq->cfs.min_vruntime;
+    update_min_vruntime(&rq->cfs, NULL);
+    return p;
+  }
+
+  return NULL;
+}
+
+static void switched_to_fair(struct RunQueue *rq, struct TaskBlock *p) {
+  p->se.weight = prio_to_weight[p->priority];
+  p->se.exec_start = rq->clock;
+  p->se.vruntime = vruntime_max(p->se.vruntime, rq->cfs.min_vruntime);
+}
+
+void fair_migrate_task(struct RunQueue *rq, struct TaskBlock *p) {
+  p->se.vruntime -= rq->cfs.min_vruntime;
+}
+
+void fair_init_rq(struct RunQueue *rq) {
+  rq->cfs.timeline = (struct RbRoot)RB_ROOT_INIT;
+  rq->cfs.min_vruntime = 0U;
+  rq->cfs.load_weight = 0U;
+  rq->cfs.nr_running = 0U;
+}
+
+void scheduler_set_fair_tunables(u64 latency_ns, u64 min_granularity_ns) {
+  sched_min_granularity_ns = max(min_granularity_ns, (u64)NSEC_PER_USEC);
+  sched_latency_ns = max(latency_ns, sched_min_granularity_ns);
+}
+
+const struct SchedClass fair_sched_class = {
+  .next = NULL,
+  .enqueue_task = enqueue_task_fair,
+  .dequeue_task = dequeue_task_fair,
+  .pick_next_task = pick_next_task_fair,
+  .put_prev_task = put_prev_task_fair,
+  .task_tick = task_tick_fair,
+  .has_tasks = has_tasks_fair,
+  .switched_to = switched_to_fair,
+  .switched_from = NULL,
+  .steal_task = steal_task_fair,
+};
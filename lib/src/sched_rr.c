@@ -0,0 +1,187 @@
+/*******************************************************************************************************************************
+ * @file   sched_rr.c
+ *
+ * @brief  Round-robin priority scheduling class source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stddef.h>
+
+/* Inter-component Headers */
+
+/* Intra-component Headers */
+#include "sched_class.h"
+
+/* The counter is in ticks, the timeslice sizes are in quanta so they do not depend on the tick frequency */
+static void refill_timeslice(struct TaskBlock *p) {
+  // Half of the unused timeslice carries over, which favours tasks that slept
+  long new_counter = (p->counter >> 1) + p->priority * SCHED_QUANTUM_TICKS;
+  p->counter = max(MIN_TIMESLICE * SCHED_QUANTUM_TICKS, new_counter);
+
+  // Cap the counter to priority based maximum
+  p->counter = min(p->counter, p->priority * 2 * SCHED_QUANTUM_TICKS);
+}
+
+static void prio_array_add(struct PrioArray *array, struct TaskBlock *p) {
+  long prio = p->priority;
+
+  p->rq_next = NULL;
+  if (array->tail[prio]) {
+    array->tail[prio]->rq_next = p;
+  } else {
+    array->head[prio] = p;
+  }
+  array->tail[prio] = p;
+  array->bitmap |= (1ULL << prio);
+}
+
+static bool prio_array_remove(struct PrioArray *array, struct TaskBlock *p) {
+  long prio = p->priority;
+  struct TaskBlock *prev = NULL;
+  struct TaskBlock *cur = array->head[prio];
+
+  while (cur && cur != p) {
+    prev = cur;
+    cur = cur->rq_next;
+  }
+
+  if (!cur) {
+    return false;
+  }
+
+  if (prev) {
+    prev->rq_next = p->rq_next;
+  } else {
+    array->head[prio] = p->rq_next;
+  }
+
+  if (array->tail[prio] == p) {
+    array->tail[prio] = prev;
+  }
+  if (!array->head[prio]) {
+    array->bitmap &= ~(1ULL << prio);
+  }
+
+  p->rq_next = NULL;
+  return true;
+}
+
+static void enqueue_task_rr(struct RunQueue *rq, struct TaskBlock *p, u32 flags) {
+  if (flags & ENQUEUE_WAKEUP) {
+    refill_timeslice(p);
+  }
+
+  prio_array_add(rq->rr.active, p);
+  rq->rr.nr_running++;
+}
+
+static void dequeue_task_rr(struct RunQueue *rq, struct TaskBlock *p) {
+  if (!prio_array_remove(rq->rr.active, p)) {
+    prio_array_remove(rq->rr.expired, p);
+  }
+  rq->rr.nr_running--;
+}
+
+static struct TaskBlock *pick_next_task_rr(struct RunQueue *rq) {
+  if (rq->rr.nr_running == 0) {
+    return NULL;
+  }
+
+  // Every active task used up its timeslice. The expired tasks were refilled when they were queued
+  if (rq->rr.active->bitmap == 0) {
+    struct PrioArray *swap = rq->rr.active;
+    rq->rr.active = rq->rr.expired;
+    rq->rr.expired = swap;
+  }
+
+  struct PrioArray *array = rq->rr.active;
+  long prio = 63 - __builtin_clzll(array->bitmap);
+  struct TaskBlock *p = array->head[prio];
+
+  array->head[prio] = p->rq_next;
+  if (!array->head[prio]) {
+    array->tail[prio] = NULL;
+    array->bitmap &= ~(1ULL << prio);
+  }
+
+  p->rq_next = NULL;
+  rq->rr.nr_running--;
+  return p;
+}
+
+static bool put_prev_task_rr(struct RunQueue *rq, struct TaskBlock *p, bool runnable) {
+  if (!runnable) {
+    return false;
+  }
+
+  if (p->counter > 0) {
+    prio_array_add(rq->rr.active, p);
+  } else {
+    refill_timeslice(p);
+    prio_array_add(rq->rr.expired, p);
+  }
+  rq->rr.nr_running++;
+  return true;
+}
+
+static bool task_tick_rr(struct RunQueue *rq, struct TaskBlock *p) {
+  if (--p->counter > 0) {
+    return false;
+  }
+
+  p->counter = 0;
+  return true;
+}
+
+static bool has_tasks_rr(struct RunQueue *rq) {
+  return rq->rr.nr_running > 0;
+}
+
+/* The highest priority task that waits gets the other CPU, active tasks before expired ones */
+static struct TaskBlock *steal_task_rr(struct RunQueue *rq, u32 dst_cpu) {
+  struct PrioArray *arrays[2] = { rq->rr.active, rq->rr.expired };
+
+  for (u32 i = 0U; i < 2U; i++) {
+    u64 bitmap = arrays[i]->bitmap;
+
+    while (bitmap) {
+      long prio = 63 - __builtin_clzll(bitmap);
+      bitmap &= ~(1ULL << prio);
+
+      for (struct TaskBlock *p = arrays[i]->head[prio]; p; p = p->rq_next) {
+        if (!p->on_cpu && (p->cpus_allowed & (1U << dst_cpu))) {
+          prio_array_remove(arrays[i], p);
+          rq->rr.nr_running--;
+          return p;
+        }
+      }
+    }
+  }
+
+  return NULL;
+}
+
+static void switched_to_rr(struct RunQueue *rq, struct TaskBlock *p) {
+  refill_timeslice(p);
+}
+
+void rr_init_rq(struct RunQueue *rq) {
+  rq->rr.active = &rq->rr.arrays[0];
+  rq->rr.expired = &rq->rr.arrays[1];
+}
+
+const struct SchedClass rr_sched_class = {
+  .next = &fair_sched_class,
+  .enqueue_task = enqueue_task_rr,
+  .dequeue_task = dequeue_task_rr,
+  .pick_next_task = pick_next_task_rr,
+  .put_prev_task = put_prev_task_rr,
+  .task_tick = task_tick_rr,
+  .has_tasks = has_tasks_rr,
+  .switched_to = switched_to_rr,
+  .switched_from = NULL,
+  .steal_task = steal_task_rr,
+};
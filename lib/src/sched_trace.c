@@ -0,0 +1,284 @@
+/*******************************************************************************************************************************
+ * @file   sched_trace.c
+ *
+ * @brief  Scheduler event tracing source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "bcm2711_cpu.h"
+#include "log.h"
+#include "mem_utils.h"
+#include "timer.h"
+
+/* Intra-component Headers */
+#include "sched_trace.h"
+
+#ifdef SCHED_TRACE
+
+/** @brief  Width of the histogram bars in the report */
+#define SCHED_TRACE_BAR_WIDTH 40U
+
+/* Every CPU only writes its own state, so recording needs no lock, only IRQs masked */
+typedef struct {
+  struct SchedTraceEvent ring[SCHED_TRACE_ENTRIES];
+  u64 written; /**< Events ever recorded, the ring holds the last SCHED_TRACE_ENTRIES */
+
+  u64 slice_start;       /**< Counter value when the running task got the CPU */
+  u64 preempt_off_start; /**< Counter value when preemption was disabled, 0 if enabled */
+  u64 irq_off_start;     /**< Counter value when IRQs were masked, 0 if unmasked */
+
+  u64 max_preempt_off; /**< Longest preemption off section, in counter ticks */
+  u64 max_irq_off;     /**< Longest IRQ off section, in counter ticks */
+  u64 max_preempt_off_caller;
+  u64 max_irq_off_caller;
+
+  u64 wakeup_hist[SCHED_TRACE_BUCKETS]; /**< Wakeup to running latency */
+  u64 slice_hist[SCHED_TRACE_BUCKETS];  /**< Time a task ran before leaving the CPU */
+} __attribute__((aligned(64))) SchedTraceCpu;
+
+static SchedTraceCpu trace_cpus[NUM_CPUS];
+
+/* irq_save_flags and irq_restore_flags call back into the tracer, so it masks IRQs by hand */
+static inline u64 trace_irq_save(void) {
+  u64 flags;
+  asm volatile("mrs %0, daif\n msr daifset, #2" : "=r"(flags)::"memory");
+  return flags;
+}
+
+static inline void trace_irq_restore(u64 flags) {
+  asm volatile("msr daif, %0" ::"r"(flags) : "memory");
+}
+
+static u64 ticks_to_us(u64 ticks) {
+  return (ticks * 1000000U) / local_timer_get_frequency();
+}
+
+/* Bucket n holds durations in [2^(n-1), 2^n) us, the last one everything longer */
+static u32 hist_bucket(u64 ticks) {
+  u64 us = ticks_to_us(ticks);
+  if (us == 0U) {
+    return 0U;
+  }
+
+  u32 bucket = 64U - (u32)__builtin_clzll(us);
+  return min(bucket, SCHED_TRACE_BUCKETS - 1U);
+}
+
+/* Must be called with IRQs masked */
+static void trace_record(SchedTraceCpu *tc, u64 timestamp, u32 type, u32 arg0, u64 arg1) {
+  struct SchedTraceEvent *event = &tc->ring[tc->written % SCHED_TRACE_ENTRIES];
+
+  event->timestamp = timestamp;
+  event->type = type;
+  event->arg0 = arg0;
+  event->arg1 = arg1;
+  tc->written++;
+}
+
+void sched_trace_switch(struct RunQueue *rq, struct TaskBlock *prev, struct TaskBlock *next, bool preempt) {
+  u64 flags = trace_irq_save();
+  SchedTraceCpu *tc = &trace_cpus[get_cpu_id()];
+  u64 now = local_timer_get_counter();
+
+  u32 reason;
+  if (prev->state == TASK_ZOMBIE) {
+    reason = SCHED_TRACE_EXIT;
+  } else if (prev->state != TASK_RUNNING) {
+    reason = SCHED_TRACE_SLEEP;
+  } else {
+    reason = preempt ? SCHED_TRACE_PREEMPT : SCHED_TRACE_YIELD;
+  }
+
+  // Time spent idle is not a timeslice
+  if (prev != rq->idle && tc->slice_start != 0U) {
+    tc->slice_hist[hist_bucket(now - tc->slice_start)]++;
+  }
+  tc->slice_start = now;
+
+  if (next->wakeup_stamp != 0U) {
+    tc->wakeup_hist[hist_bucket(now - next->wakeup_stamp)]++;
+    next->wakeup_stamp = 0U;
+  }
+
+  trace_record(tc, now, SCHED_TRACE_SWITCH, prev->pid, ((u64)reason << 32) | next->pid);
+  trace_irq_restore(flags);
+}
+
+void sched_trace_wakeup(struct TaskBlock *p, u32 cpu) {
+  u64 flags = trace_irq_save();
+  SchedTraceCpu *tc = &trace_cpus[get_cpu_id()];
+  u64 now = local_timer_get_counter();
+
+  p->wakeup_stamp = now;
+  trace_record(tc, now, SCHED_TRACE_WAKEUP, p->pid, cpu);
+  trace_irq_restore(flags);
+}
+
+void sched_trace_tick(struct TaskBlock *curr) {
+  u64 flags = trace_irq_save();
+  SchedTraceCpu *tc = &trace_cpus[get_cpu_id()];
+
+  // IRQs were unmasked when the tick was taken, so an IRQ off section still open here was left behind by a task that
+  // switched out with IRQs masked, and resumed a task that returns through an eret instead
+  tc->irq_off_start = 0U;
+
+  trace_record(tc, local_timer_get_counter(), SCHED_TRACE_TICK, curr->pid, 0U);
+  trace_irq_restore(flags);
+}
+
+void sched_trace_preempt_off(void) {
+  u64 flags = trace_irq_save();
+  trace_cpus[get_cpu_id()].preempt_off_start = local_timer_get_counter();
+  trace_irq_restore(flags);
+}
+
+void sched_trace_preempt_on(u64 caller) {
+  u64 flags = trace_irq_save();
+  SchedTraceCpu *tc = &trace_cpus[get_cpu_id()];
+  u64 now = local_timer_get_counter();
+
+  if (tc->preempt_off_start != 0U) {
+    u64 ticks = now - tc->preempt_off_start;
+    if (ticks > tc->max_preempt_off) {
+      tc->max_preempt_off = ticks;
+      tc->max_preempt_off_caller = caller;
+    }
+    if (ticks_to_us(ticks) >= SCHED_TRACE_OFF_THRESHOLD_US) {
+      trace_record(tc, now, SCHED_TRACE_PREEMPT_OFF, (u32)min(ticks, 0xFFFFFFFFULL), caller);
+    }
+    tc->preempt_off_start = 0U;
+  }
+
+  trace_irq_restore(flags);
+}
+
+/* Called from irq.S with IRQs already masked */
+void sched_trace_irqs_off(void) {
+  trace_cpus[get_cpu_id()].irq_off_start = local_timer_get_counter();
+}
+
+/* Called from irq.S with IRQs still masked */
+void sched_trace_irqs_on(u64 caller) {
+  SchedTraceCpu *tc = &trace_cpus[get_cpu_id()];
+  u64 now = local_timer_get_counter();
+
+  if (tc->irq_off_start == 0U) {
+    return;
+  }
+
+  u64 ticks = now - tc->irq_off_start;
+  if (ticks > tc->max_irq_off) {
+    tc->max_irq_off = ticks;
+    tc->max_irq_off_caller = caller;
+  }
+  if (ticks_to_us(ticks) >= SCHED_TRACE_OFF_THRESHOLD_US) {
+    trace_record(tc, now, SCHED_TRACE_IRQ_OFF, (u32)min(ticks, 0xFFFFFFFFULL), caller);
+  }
+  tc->irq_off_start = 0U;
+}
+
+/* Upper bound of the bucket holding the given percentile, in us */
+static u64 hist_percentile(const u64 *hist, u64 total, u64 percent) {
+  u64 seen = 0U;
+  for (u32 bucket = 0U; bucket < SCHED_TRACE_BUCKETS; bucket++) {
+    seen += hist[bucket];
+    if (seen * 100U >= total * percent) {
+      return 1ULL << bucket;
+    }
+  }
+
+  return 1ULL << (SCHED_TRACE_BUCKETS - 1U);
+}
+
+static void print_histogram(char *name, size_t offset) {
+  u64 hist[SCHED_TRACE_BUCKETS] = { 0 };
+  u64 total = 0U;
+  u64 peak = 0U;
+
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    const u64 *cpu_hist = (const u64 *)((const u8 *)&trace_cpus[cpu] + offset);
+    for (u32 bucket = 0U; bucket < SCHED_TRACE_BUCKETS; bucket++) {
+      hist[bucket] += cpu_hist[bucket];
+    }
+  }
+  for (u32 bucket = 0U; bucket < SCHED_TRACE_BUCKETS; bucket++) {
+    total += hist[bucket];
+    peak = max(peak, hist[bucket]);
+  }
+
+  log("\n\r%s: %ld samples", name, total);
+  if (total == 0U) {
+    log("\n\r");
+    return;
+  }
+  log(", p50 < %ld us, p99 < %ld us\n\r", hist_percentile(hist, total, 50U), hist_percentile(hist, total, 99U));
+
+  for (u32 bucket = 0U; bucket < SCHED_TRACE_BUCKETS; bucket++) {
+    if (hist[bucket] == 0U) {
+      continue;
+    }
+
+    char bar[SCHED_TRACE_BAR_WIDTH + 1U];
+    u32 width = (u32)max((hist[bucket] * SCHED_TRACE_BAR_WIDTH) / peak, 1U);
+    memset(bar, '#', width);
+    bar[width] = '\0';
+
+    u64 low = bucket ? 1ULL << (bucket - 1U) : 0U;
+    log("  %ld-%ld us\t%ld\t%s\n\r", low, 1ULL << bucket, hist[bucket], bar);
+  }
+}
+
+void sched_trace_report(void) {
+  log("\n\r===== SCHEDULER TRACE REPORT =====\n\r");
+
+  print_histogram("Wakeup to run latency", offsetof(SchedTraceCpu, wakeup_hist));
+  print_histogram("Timeslice length", offsetof(SchedTraceCpu, slice_hist));
+
+  log("\n\rLongest off sections (us, ending at):\n\r");
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    SchedTraceCpu *tc = &trace_cpus[cpu];
+    if (tc->written == 0U) {
+      continue;
+    }
+    log("  cpu%d  preempt %ld at %lx  irq %ld at %lx  events %ld\n\r", cpu, ticks_to_us(tc->max_preempt_off),
+        tc->max_preempt_off_caller, ticks_to_us(tc->max_irq_off), tc->max_irq_off_caller, tc->written);
+  }
+}
+
+void sched_trace_dump(void) {
+  log("SCHED_TRACE BEGIN freq=%ld cpus=%d\n\r", local_timer_get_frequency(), NUM_CPUS);
+
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    SchedTraceCpu *tc = &trace_cpus[cpu];
+    u64 written = tc->written;
+    u64 first = written > SCHED_TRACE_ENTRIES ? written - SCHED_TRACE_ENTRIES : 0U;
+
+    if (first != 0U) {
+      log("D %d %ld\n\r", cpu, first);
+    }
+
+    // Oldest first. The CPU keeps recording meanwhile, so a busy one may overwrite entries before they are printed
+    for (u64 i = first; i < written; i++) {
+      struct SchedTraceEvent *event = &tc->ring[i % SCHED_TRACE_ENTRIES];
+      log("E %d %lx %d %x %lx\n\r", cpu, event->timestamp, event->type, event->arg0, event->arg1);
+    }
+  }
+
+  log("SCHED_TRACE END\n\r");
+}
+
+void sched_trace_reset(void) {
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    u64 flags = trace_irq_save();
+    memset(&trace_cpus[cpu], 0, sizeof(trace_cpus[cpu]));
+    trace_irq_restore(flags);
+  }
+}
+
+#endif
@@ -3,196 +3,1452 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "address_space.h"
+#include "arm64_atomic.h"
+#include "arm64_barrier.h"
+#include "bcm2711_cpu.h"
+#include "buddy.h"
 #include "entry.h"
 #include "irq.h"
+#include "kernel_malloc.h"
 #include "log.h"
 #include "mem.h"
 #include "mem_utils.h"
+#include "mmu.h"
+#include "pid.h"
+#include "sched_class.h"
+#include "sched_trace.h"
+#include "spinlock.h"
 #include "sysregs.h"
 #include "timer.h"
+#include "wait_queue.h"
+
+/** @brief  Time a secondary core gets to come online, in timer ticks */
+#define SMP_BOOT_TIMEOUT (CLOCK_HZ / 10)
+
+/** @brief  Period of the scheduler tick, in timer ticks */
+#define TICK_INTERVAL (CLOCK_HZ / SCHED_TICK_HZ)
+
+/** @brief  Longest an idle CPU sleeps with its tick stopped, in timer ticks. Bounds the catch-up work once it wakes
+ *          and stays well inside the 32-bit timer registers */
+#define NOHZ_MAX_SLEEP CLOCK_HZ
 
 struct TaskBlock init_task = INIT_TASK;
 static bool is_initialized = false;
+static struct RunQueue runqueues[NUM_CPUS];
+
+/* Bit n is set once CPU n schedules tasks. Cores come up one at a time, so only one writer at once */
+static volatile u32 cpu_online_mask = 0U;
+
+/* Bit n is set while CPU n sleeps with its tick stopped. Each CPU only adds or subtracts its own bit */
+static volatile u64 nohz_idle_mask = 0U;
+
+/* Bit n keeps CPU n out of load balancing and general task placement */
+static volatile u32 cpu_isolated_mask = 0U;
+
+__attribute__((aligned(8), section(".data"))) u32 nr_tasks = 0;
+
+/* Protects the task list, the PID lookup table and the zombie list */
+static struct Spinlock tasklist_lock = SPIN_LOCK_INIT;
+
+static struct TaskBlock *pid_hash[PID_HASH_SIZE];
+
+/* Exited tasks still own their stack until another task frees it, linked through rq_next */
+static struct TaskBlock *zombies = NULL;
+
+/* Stacks of reaped tasks, zeroed when they are put here. Protected by tasklist_lock */
+static u64 stack_cache[TASK_STACK_CACHE_SIZE];
+static u32 stack_cache_count = 0U;
+
+/* Woken whenever a joinable task exits */
+static WaitQueue task_exit_wq = WAIT_QUEUE_INIT;
+
+extern void secondary_entry(void);
+
+static void push_task(struct TaskBlock *p, bool switched_out);
+static struct TaskBlock *find_task(u32 pid);
+
+#define cpu_rq(cpu) (&runqueues[(cpu)])
+
+/* Only stable while the caller cannot move to another CPU, with IRQs masked or preemption disabled */
+#define this_rq() cpu_rq(get_cpu_id())
+
+static inline bool cpu_online(u32 cpu) {
+  return (cpu_online_mask & (1U << cpu)) != 0U;
+}
+
+static inline bool cpu_isolated(u32 cpu) {
+  return (cpu_isolated_mask & (1U << cpu)) != 0U;
+}
+
+/* CPUs a task may be placed on. Isolated CPUs only take tasks that allow nothing else, and a mask without an
+ * online CPU falls back to the online ones, since the task has to run somewhere */
+static u32 task_allowed_cpus(struct TaskBlock *p) {
+  u32 online = p->cpus_allowed & cpu_online_mask;
+  if (online == 0U) {
+    online = cpu_online_mask;
+  }
+
+  u32 housekeeping = online & ~cpu_isolated_mask;
+  return housekeeping ? housekeeping : online;
+}
+
+static inline void set_current(struct TaskBlock *p) {
+  asm volatile("msr tpidr_el1, %0" ::"r"(p) : "memory");
+}
+
+static inline long clamp_priority(long priority) {
+  if (priority < MIN_PRIORITY) return MIN_PRIORITY;
+  if (priority > MAX_PRIORITY) return MAX_PRIORITY;
+  return priority;
+}
+
+void preempt_disable(void) {
+  if (is_initialized == false) {
+    return;
+  }
+  current->preempt_count++;
+  if (current->preempt_count == 1) {
+    sched_trace_preempt_off();
+  }
+}
+
+void preempt_enable(void) {
+  if (is_initialized == false) {
+    return;
+  }
+  if (current->preempt_count == 1) {
+    sched_trace_preempt_on((u64)__builtin_return_address(0));
+  }
+  current->preempt_count--;
+}
+
+struct TaskBlock *switch_to(struct TaskBlock *next) {
+  if (current == next) {
+    return NULL;
+  }
+
+  if ((next->cpu_context.sp & 15) != 0) {
+    log("ERROR: Stack pointer not 16-byte aligned\n");
+    return NULL;
+  }
+
+  if ((next->cpu_context.lr & 3) != 0) {
+    log("ERROR: Link register not 4-byte aligned\n");
+    return NULL;
+  }
+
+  struct TaskBlock *prev = current;
+  set_current(next);
+  /* Kernel threads keep running on the previous address space, which holds the same kernel mappings */
+  address_space_switch(next->mm);
+  return cpu_context_switch(prev, next);
+}
+
+void schedule_tail(struct TaskBlock *prev) {
+  if (!prev) {
+    return;
+  }
+
+  // Every register of prev must be saved before another CPU can pick it up
+  dmb();
+  prev->on_cpu = false;
+
+  // Still runnable but no longer allowed here, after task_set_affinity or scheduler_isolate_cpus
+  if (prev->state == TASK_RUNNING && !(task_allowed_cpus(prev) & (1U << prev->cpu))) {
+    push_task(prev, true);
+  }
+}
+
+u64 sched_clock(void) {
+  u64 count = local_timer_get_counter();
+  u64 frequency = local_timer_get_frequency();
+
+  // Split in whole seconds and the rest, a single multiplication would overflow after a few minutes at 54 MHz
+  return (count / frequency) * NSEC_PER_SEC + ((count % frequency) * NSEC_PER_SEC) / frequency;
+}
+
+/* Lock the runqueue a timer is armed on. timer->cpu only changes with that runqueue locked */
+static struct RunQueue *timer_rq_lock(struct SchedTimer *timer) {
+  while (1) {
+    struct RunQueue *rq = cpu_rq(timer->cpu);
+    spin_lock(&rq->lock);
+    if (rq == cpu_rq(timer->cpu)) {
+      return rq;
+    }
+    spin_unlock(&rq->lock);
+  }
+}
+
+/* Lock the runqueue of a task. p->cpu only changes with that runqueue locked, so it is checked again once held */
+static struct RunQueue *task_rq_lock(struct TaskBlock *p) {
+  while (1) {
+    struct RunQueue *rq = cpu_rq(p->cpu);
+    spin_lock(&rq->lock);
+    if (rq == cpu_rq(p->cpu)) {
+      return rq;
+    }
+    spin_unlock(&rq->lock);
+  }
+}
+
+/* Runqueues are locked in CPU order, so two CPUs balancing against each other cannot deadlock */
+static void double_rq_lock(struct RunQueue *a, struct RunQueue *b) {
+  if (a->cpu < b->cpu) {
+    spin_lock(&a->lock);
+    spin_lock(&b->lock);
+  } else {
+    spin_lock(&b->lock);
+    spin_lock(&a->lock);
+  }
+}
+
+/* Restart the tick of an isolated CPU that stopped it for a lone task. Must run on that CPU with its runqueue locked */
+static void tick_nohz_full_exit(struct RunQueue *rq) {
+  if (!rq->tick_isolated) {
+    return;
+  }
+
+  rq->tick_isolated = false;
+  local_timer_set_next_event(TICK_INTERVAL);
+}
+
+/* The runqueue is also touched from the timer IRQ and other CPUs, so every caller must hold its lock with IRQs masked */
+static void enqueue_task(struct RunQueue *rq, struct TaskBlock *p, u32 flags) {
+  p->sched_class->enqueue_task(rq, p, flags);
+  p->on_rq = true;
+  rq->nr_running++;
+
+  // The running task has to share its CPU now. Callers send an IPI to other CPUs, which restarts the tick there
+  if (rq->tick_isolated && rq->cpu == get_cpu_id()) {
+    tick_nohz_full_exit(rq);
+  }
+}
+
+static void dequeue_task(struct RunQueue *rq, struct TaskBlock *p) {
+  p->sched_class->dequeue_task(rq, p);
+  p->on_rq = false;
+  rq->nr_running--;
+}
+
+static struct TaskBlock *pick_next_task(struct RunQueue *rq) {
+  for (const struct SchedClass *class = sched_class_highest; class; class = class->next) {
+    struct TaskBlock *p = class->pick_next_task(rq);
+    if (p) {
+      p->on_rq = false;
+      rq->nr_running--;
+      return p;
+    }
+  }
+
+  return rq->idle;
+}
+
+/* Accounts the outgoing task and queues it again unless it is blocking or exiting */
+static void put_prev_task(struct RunQueue *rq, struct TaskBlock *prev) {
+  if (prev == rq->idle || prev->on_rq) {
+    return;
+  }
+
+  bool runnable = (prev->state == TASK_RUNNING);
+
+  // Leaving for a CPU it is allowed on. It cannot be queued there before it is off this CPU, schedule_tail does that
+  if (runnable && prev->policy != SCHED_DEADLINE && !(task_allowed_cpus(prev) & (1U << rq->cpu))) {
+    runnable = false;
+  }
+
+  if (prev->sched_class->put_prev_task(rq, prev, runnable)) {
+    prev->on_rq = true;
+    rq->nr_running++;
+  }
+}
+
+/* Exponential moving average of the queued and running tasks, sampled every quantum */
+static void update_load_avg(struct RunQueue *rq) {
+  u64 load = (u64)(rq->nr_running + (rq->curr != rq->idle ? 1U : 0U)) * SCHED_LOAD_SCALE;
+
+  rq->load_avg += (u64)((long)(load - rq->load_avg) >> SCHED_LOAD_AVG_SHIFT);
+}
+
+/* Catch up on quanta skipped while idle, as if each had sampled no load */
+static void decay_load_avg(struct RunQueue *rq, u64 quanta) {
+  for (u64 i = 0U; i < quanta && rq->load_avg > 0U; i++) {
+    rq->load_avg += (u64)(-(long)rq->load_avg >> SCHED_LOAD_AVG_SHIFT);
+  }
+}
+
+/* Move one queued task from src to dst, trying the classes in order. Both runqueues must be locked */
+static struct TaskBlock *migrate_task(struct RunQueue *dst, struct RunQueue *src) {
+  for (const struct SchedClass *class = sched_class_highest; class; class = class->next) {
+    if (!class->steal_task) {
+      continue;
+    }
+
+    struct TaskBlock *p = class->steal_task(src, dst->cpu);
+    if (p) {
+      src->nr_running--;
+      p->cpu = dst->cpu;
+      p->sched_class->enqueue_task(dst, p, ENQUEUE_MIGRATED);
+      dst->nr_running++;
+      dst->nr_migrations++;
+      return p;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Find the runqueue to pull a task from
+ * @details The counters of other CPUs are read without their locks. That only makes the choice stale, the
+ *          migration itself happens with both runqueues locked
+ * @param   this_rq Runqueue that wants a task
+ * @param   idle Pick the CPU with the most queued tasks, for a CPU about to go idle. Otherwise only a CPU whose
+ *          load average is more than one task above this one is picked
+ * @return  Busiest runqueue, NULL if no CPU qualifies
+ */
+static struct RunQueue *find_busiest_queue(struct RunQueue *this_rq, bool idle) {
+  struct RunQueue *busiest = NULL;
+
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    struct RunQueue *rq = cpu_rq(cpu);
+    if (rq == this_rq || !cpu_online(cpu) || cpu_isolated(cpu) || rq->nr_running == 0U) {
+      continue;
+    }
+
+    if (idle) {
+      if (!busiest || rq->nr_running > busiest->nr_running) {
+        busiest = rq;
+      }
+    } else if (rq->load_avg > this_rq->load_avg + SCHED_LOAD_SCALE) {
+      if (!busiest || rq->load_avg > busiest->load_avg) {
+        busiest = rq;
+      }
+    }
+  }
+
+  return busiest;
+}
+
+/* Pull one task over from the busiest CPU. this_rq must be locked, it is dropped briefly to lock both in order */
+static bool load_balance(struct RunQueue *this_rq, bool idle) {
+  // Isolated CPUs neither give nor take work
+  if (cpu_isolated(this_rq->cpu)) {
+    return false;
+  }
+
+  struct RunQueue *busiest = find_busiest_queue(this_rq, idle);
+  if (!busiest) {
+    return false;
+  }
+
+  if (busiest->cpu < this_rq->cpu) {
+    spin_unlock(&this_rq->lock);
+    double_rq_lock(this_rq, busiest);
+  } else {
+    spin_lock(&busiest->lock);
+  }
+
+  bool pulled = migrate_task(this_rq, busiest) != NULL;
+  spin_unlock(&busiest->lock);
+
+  return pulled;
+}
+
+static bool cpu_is_idle(u32 cpu) {
+  struct RunQueue *rq = cpu_rq(cpu);
+  return rq->curr == rq->idle && rq->nr_running == 0U;
+}
+
+/* The CPU a task last ran on may still hold its cache lines, so it is kept unless it is busy while another allowed
+ * CPU idles. Deadline tasks stay on the CPU that admitted their bandwidth */
+static u32 select_task_rq(struct TaskBlock *p) {
+  u32 prev_cpu = p->cpu;
+  u32 allowed = task_allowed_cpus(p);
+  bool prev_allowed = (allowed & (1U << prev_cpu)) != 0U;
+
+  if (p->policy == SCHED_DEADLINE || p->on_cpu || (prev_allowed && cpu_is_idle(prev_cpu))) {
+    return prev_cpu;
+  }
+
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    if ((allowed & (1U << cpu)) && cpu_is_idle(cpu)) {
+      return cpu;
+    }
+  }
+
+  return prev_allowed ? prev_cpu : (u32)__builtin_ctz(allowed);
+}
+
+/* A new task has no cache footprint yet, so it starts on the allowed CPU with the fewest runnable tasks */
+static u32 select_task_rq_fork(u32 allowed) {
+  u32 this_cpu = get_cpu_id();
+  u32 best_cpu = this_cpu;
+  u32 best_load = ~0U;
+
+  for (u32 i = 0U; i < NUM_CPUS; i++) {
+    // Start at this CPU, so it wins ties
+    u32 cpu = (this_cpu + i) % NUM_CPUS;
+    struct RunQueue *rq = cpu_rq(cpu);
+    if (!(allowed & (1U << cpu))) {
+      continue;
+    }
+
+    u32 load = rq->nr_running + (rq->curr != rq->idle ? 1U : 0U);
+    if (load < best_load) {
+      best_cpu = cpu;
+      best_load = load;
+    }
+  }
+
+  return best_cpu;
+}
+
+/**
+ * @brief   Move a runnable task off a CPU its affinity no longer allows
+ * @details Must be called with IRQs masked and no runqueue locked
+ * @param   p Task to move
+ * @param   switched_out p was just switched out by schedule_tail, which put_prev_task left off the runqueue.
+ *          Otherwise only a queued task is moved
+ */
+static void push_task(struct TaskBlock *p, bool switched_out) {
+  struct RunQueue *rq = task_rq_lock(p);
+  u32 allowed = task_allowed_cpus(p);
 
-__attribute__((aligned(8), section(".data"))) struct TaskBlock *current = NULL;
-__attribute__((aligned(8), section(".data"))) struct TaskBlock *task[NUM_TASKS] = { NULL };
-__attribute__((aligned(8), section(".data"))) u8 num_tasks = 0;
+  if (p->on_cpu || p->state != TASK_RUNNING || p->policy == SCHED_DEADLINE || (allowed & (1U << rq->cpu)) ||
+      (!p->on_rq && !switched_out)) {
+    spin_unlock(&rq->lock);
+    return;
+  }
+
+  u32 cpu = select_task_rq_fork(allowed);
+  struct RunQueue *target = cpu_rq(cpu);
+
+  // Off every runqueue but still TASK_RUNNING, so nothing else queues it while the locks are retaken in order
+  if (p->on_rq) {
+    dequeue_task(rq, p);
+  }
+  if (target->cpu < rq->cpu) {
+    spin_unlock(&rq->lock);
+    double_rq_lock(rq, target);
+  } else {
+    spin_lock(&target->lock);
+  }
+  p->cpu = cpu;
+  u32 enqueue_flags = ENQUEUE_WAKEUP;
+  if (p->sched_class == &fair_sched_class) {
+    fair_migrate_task(rq, p);
+    enqueue_flags |= ENQUEUE_MIGRATED;
+  }
+  spin_unlock(&rq->lock);
+
+  // Placed like a wakeup, after its lag behind the old runqueue moved over to the new one
+  target->clock = sched_clock();
+  enqueue_task(target, p, enqueue_flags);
+  spin_unlock(&target->lock);
+
+  if (cpu != get_cpu_id()) {
+    irq_send_reschedule(cpu);
+  }
+}
+
+void _schedule(bool preempt) {
+  preempt_disable();
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = this_rq();
+  struct TaskBlock *prev = current;
+
+  spin_lock(&rq->lock);
+  rq->clock = sched_clock();
+  put_prev_task(rq, prev);
+
+  // The lone task of an isolated CPU is leaving or sharing it, so the tick runs until it finds a lone task again
+  tick_nohz_full_exit(rq);
+
+  // Rather than going idle, take over a task that waits on a busier CPU
+  if (rq->nr_running == 0U) {
+    load_balance(rq, true);
+  }
+
+  struct TaskBlock *next = pick_next_task(rq);
+
+  // Without an idle task there is nothing to switch to, so the current task keeps the CPU
+  if (!next || next == prev) {
+    spin_unlock(&rq->lock);
+  } else {
+    if (prev == rq->idle) {
+      rq->idle_ns += rq->clock - rq->idle_start;
+    }
+    if (next == rq->idle) {
+      rq->idle_start = rq->clock;
+    }
+
+    sched_trace_switch(rq, prev, next, preempt);
+    rq->curr = next;
+    rq->nr_switches++;
+    next->cpu = rq->cpu;
+    next->on_cpu = true;
+    spin_unlock(&rq->lock);
+
+    // Returns on the stack of the task switched back in, which releases the task it replaced
+    schedule_tail(switch_to(next));
+  }
+
+  irq_restore_flags(flags);
+  preempt_enable();
+}
+
+void schedule() {
+  if (is_initialized == false) {
+    return;
+  }
+  if (current->preempt_count > 0) {
+    return;
+  }
+
+  current->counter = 0;
+  _schedule(false);
+}
+
+void scheduler_wake_task(struct TaskBlock *p) {
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = task_rq_lock(p);
+
+  // Runnable tasks are either queued, on a CPU or parked by their class until they may run again
+  if (p->state == TASK_RUNNING) {
+    spin_unlock(&rq->lock);
+    irq_restore_flags(flags);
+    return;
+  }
+
+  p->state = TASK_RUNNING;
+
+  // Still on its CPU on the way to sleep, put_prev_task queues it again
+  if (p->on_rq || rq->curr == p) {
+    spin_unlock(&rq->lock);
+    irq_restore_flags(flags);
+    return;
+  }
+
+  u32 cpu = select_task_rq(p);
+  struct RunQueue *target = cpu_rq(cpu);
+  u32 enqueue_flags = ENQUEUE_WAKEUP;
+  if (target != rq) {
+    // p->cpu changes with both runqueues locked, which have to be taken in CPU order
+    if (target->cpu < rq->cpu) {
+      spin_unlock(&rq->lock);
+      double_rq_lock(rq, target);
+    } else {
+      spin_lock(&target->lock);
+    }
+    p->cpu = cpu;
+    if (p->sched_class == &fair_sched_class) {
+      fair_migrate_task(rq, p);
+      enqueue_flags |= ENQUEUE_MIGRATED;
+    }
+    spin_unlock(&rq->lock);
+  }
+
+  target->clock = sched_clock();
+  sched_trace_wakeup(p, cpu);
+  enqueue_task(target, p, enqueue_flags);
+  spin_unlock(&target->lock);
+
+  // An idle CPU sleeps in wfi, possibly with its tick stopped. A busy one notices the task by its next tick at the latest
+  if (cpu != get_cpu_id()) {
+    irq_send_reschedule(cpu);
+  }
+
+  irq_restore_flags(flags);
+}
+
+static const struct SchedClass *policy_class(u32 policy) {
+  switch (policy) {
+    case SCHED_NORMAL:
+      return &fair_sched_class;
+    case SCHED_RR:
+      return &rr_sched_class;
+    case SCHED_DEADLINE:
+      return &dl_sched_class;
+    default:
+      return NULL;
+  }
+}
+
+static long pi_rank(u32 policy, long priority) {
+  switch (policy) {
+    case SCHED_DEADLINE:
+      return 2L * NUM_PRIORITIES + MAX_PRIORITY;
+    case SCHED_RR:
+      return NUM_PRIORITIES + priority;
+    default:
+      return priority;
+  }
+}
+
+/* Must be called with the task's runqueue locked. Takes the task out under its old priority and class, then
+ * queues it under the new ones */
+static void change_sched(struct RunQueue *rq, struct TaskBlock *p, u32 policy, long priority) {
+  const struct SchedClass *class = policy_class(policy);
+
+  bool queued = p->on_rq;
+  bool running = (rq->curr == p);
+  if (queued) {
+    dequeue_task(rq, p);
+  } else if (running) {
+    p->sched_class->put_prev_task(rq, p, false);
+  }
+
+  if (p->sched_class != class && p->sched_class->switched_from) {
+    queued = p->sched_class->switched_from(rq, p) || queued;
+  }
+
+  p->priority = clamp_priority(priority);
+  p->policy = policy;
+  p->sched_class = class;
+  class->switched_to(rq, p);
+
+  if (queued && !running) {
+    enqueue_task(rq, p, 0U);
+  }
+}
+
+/* Must be called with the task's runqueue locked. Applies the higher of the task's own rank and the inherited one */
+static void update_effective_sched(struct RunQueue *rq, struct TaskBlock *p) {
+  u32 policy = p->normal_policy;
+  long priority = p->normal_priority;
+
+  // A deadline reservation already runs ahead of everything an owner could inherit
+  if (policy != SCHED_DEADLINE && p->pi_rank > pi_rank(policy, priority)) {
+    if (p->pi_rank >= NUM_PRIORITIES) {
+      policy = SCHED_RR;
+      priority = min(p->pi_rank - NUM_PRIORITIES, (long)MAX_PRIORITY);
+    } else {
+      priority = p->pi_rank;
+    }
+  }
+
+  if (policy != p->policy || clamp_priority(priority) != p->priority) {
+    change_sched(rq, p, policy, priority);
+  }
+}
+
+int scheduler_set_attr(u32 pid, const struct SchedAttr *attr) {
+  if (!policy_class(attr->policy)) {
+    return -1;
+  }
+
+  // Holding the task list lock keeps the task from being reaped while it is changed
+  u64 flags = irq_save_flags();
+  spin_lock(&tasklist_lock);
+  struct TaskBlock *p = find_task(pid);
+  if (!p || p->state == TASK_ZOMBIE) {
+    spin_unlock(&tasklist_lock);
+    irq_restore_flags(flags);
+    return -1;
+  }
+
+  struct RunQueue *rq = task_rq_lock(p);
+  rq->clock = sched_clock();
+
+  // Deadline bandwidth is reserved on the CPU the task is on, deadline tasks never migrate
+  if (attr->policy == SCHED_DEADLINE) {
+    int res = dl_admit(rq, p, attr);
+    if (res != 0) {
+      spin_unlock(&rq->lock);
+      spin_unlock(&tasklist_lock);
+      irq_restore_flags(flags);
+      return res;
+    }
+  }
+
+  // A task boosted by priority inheritance keeps the boost until it is dropped, on top of its new parameters
+  p->normal_policy = attr->policy;
+  p->normal_priority = clamp_priority(attr->priority);
+  change_sched(rq, p, attr->policy, attr->priority);
+  update_effective_sched(rq, p);
+
+  spin_unlock(&rq->lock);
+  spin_unlock(&tasklist_lock);
+  irq_restore_flags(flags);
+  return 0;
+}
+
+long scheduler_task_pi_rank(struct TaskBlock *p) {
+  return pi_rank(p->policy, p->priority);
+}
+
+void scheduler_set_pi_rank(struct TaskBlock *p, long rank) {
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = task_rq_lock(p);
+  rq->clock = sched_clock();
+
+  p->pi_rank = rank;
+  update_effective_sched(rq, p);
+
+  spin_unlock(&rq->lock);
+  irq_restore_flags(flags);
+}
+
+bool scheduler_may_block(void) {
+  return is_initialized && current->preempt_count == 0;
+}
+
+int scheduler_set_policy(u32 pid, u32 policy, long priority) {
+  if (policy == SCHED_DEADLINE) {
+    return -1;
+  }
+
+  struct SchedAttr attr = { .policy = policy, .priority = priority };
+  return scheduler_set_attr(pid, &attr);
+}
+
+void sched_wait_next_period(void) {
+  if (is_initialized == false) {
+    return;
+  }
+
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = this_rq();
+  spin_lock(&rq->lock);
+  rq->clock = sched_clock();
+
+  // Sleep until the class releases the task at the start of its next period
+  if (current->policy == SCHED_DEADLINE && dl_finish_job(rq, current)) {
+    current->state = TASK_SLEEPING;
+  }
+
+  spin_unlock(&rq->lock);
+  irq_restore_flags(flags);
+  schedule();
+}
+
+/* Must be called with the runqueue locked. Timers with the same expiry fire in the order they were armed */
+static void timer_insert(struct RunQueue *rq, struct SchedTimer *timer) {
+  struct SchedTimer **link = &rq->timers;
+
+  while (*link && (*link)->expires <= timer->expires) {
+    link = &(*link)->next;
+  }
+
+  timer->next = *link;
+  *link = timer;
+  timer->pending = true;
+}
+
+/* Must be called with the runqueue locked */
+static void timer_remove(struct RunQueue *rq, struct SchedTimer *timer) {
+  struct SchedTimer **link = &rq->timers;
+
+  while (*link && *link != timer) {
+    link = &(*link)->next;
+  }
+  if (*link) {
+    *link = timer->next;
+  }
+
+  timer->next = NULL;
+  timer->pending = false;
+}
+
+/* Fire the expired timers of this CPU. The callbacks run without the runqueue lock, so they may wake tasks */
+static void run_timers(struct RunQueue *rq) {
+  spin_lock(&rq->lock);
+  rq->clock = sched_clock();
+
+  struct SchedTimer *timer;
+  while ((timer = rq->timers) != NULL && timer->expires <= rq->clock) {
+    timer_remove(rq, timer);
+    rq->running_timer = timer;
+    spin_unlock(&rq->lock);
+
+    timer->fn(timer);
+
+    spin_lock(&rq->lock);
+    rq->running_timer = NULL;
+  }
+
+  spin_unlock(&rq->lock);
+}
+
+void sched_timer_init(struct SchedTimer *timer, void (*fn)(struct SchedTimer *timer), void *data) {
+  timer->next = NULL;
+  timer->expires = 0U;
+  timer->fn = fn;
+  timer->data = data;
+  timer->cpu = get_cpu_id();
+  timer->pending = false;
+}
+
+void sched_timer_arm(struct SchedTimer *timer, u64 expires) {
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = timer_rq_lock(timer);
+  if (timer->pending) {
+    timer_remove(rq, timer);
+  }
+  spin_unlock(&rq->lock);
+
+  // The tick of the arming CPU fires the timer, it is running so its tick is too
+  rq = this_rq();
+  spin_lock(&rq->lock);
+  timer->cpu = rq->cpu;
+  timer->expires = expires;
+  timer_insert(rq, timer);
+  spin_unlock(&rq->lock);
+  irq_restore_flags(flags);
+}
+
+bool sched_timer_cancel(struct SchedTimer *timer) {
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = timer_rq_lock(timer);
+  bool pending = timer->pending;
+  if (pending) {
+    timer_remove(rq, timer);
+  }
+  spin_unlock(&rq->lock);
+
+  // A callback on this CPU cannot be interrupted by the caller, so only another CPU can still be in it
+  if (rq->cpu != get_cpu_id()) {
+    while (rq->running_timer == timer) {
+    }
+  }
+
+  irq_restore_flags(flags);
+  return pending;
+}
 
-static inline long clamp_priority(long priority) {
-  if (priority < MIN_PRIORITY) return MIN_PRIORITY;
-  if (priority > MAX_PRIORITY) return MAX_PRIORITY;
-  return priority;
+static void sleep_timer_fn(struct SchedTimer *timer) {
+  scheduler_wake_task(timer->data);
 }
 
-void preempt_disable(void) {
-  if (is_initialized == false) {
+void sleep_until(u64 wake_ns) {
+  // Without the scheduler, or unable to switch, the CPU cannot go to another task
+  if (is_initialized == false || current->preempt_count > 0) {
+    while (sched_clock() < wake_ns) {
+    }
     return;
   }
-  current->preempt_count++;
+
+  struct SchedTimer timer;
+  sched_timer_init(&timer, sleep_timer_fn, current);
+
+  // IRQs stay masked from setting the state until the switch, so the tick cannot catch the task half way to sleep.
+  // Woken early, the task simply goes back to sleep
+  u64 flags = irq_save_flags();
+  while (sched_clock() < wake_ns) {
+    current->state = TASK_SLEEPING;
+    sched_timer_arm(&timer, wake_ns);
+    schedule();
+  }
+  irq_restore_flags(flags);
+
+  sched_timer_cancel(&timer);
 }
 
-void preempt_enable(void) {
-  if (is_initialized == false) {
-    return;
+void usleep(u64 us) {
+  sleep_until(sched_clock() + us * NSEC_PER_USEC);
+}
+
+void msleep(u64 ms) {
+  sleep_until(sched_clock() + ms * NSEC_PER_MSEC);
+}
+
+/* Timer ticks until the next timed event of a CPU, the earliest armed timer or deadline task release, at most
+ * NOHZ_MAX_SLEEP. Must be called with the runqueue locked and its clock updated */
+static u64 tick_next_event(struct RunQueue *rq) {
+  u64 next = rq->clock + (u64)NOHZ_MAX_SLEEP * (NSEC_PER_SEC / CLOCK_HZ);
+  u64 release;
+  if (dl_next_release(rq, &release) && release < next) {
+    next = release;
   }
-  current->preempt_count--;
+  if (rq->timers && rq->timers->expires < next) {
+    next = rq->timers->expires;
+  }
+
+  return (next > rq->clock) ? (next - rq->clock) / (NSEC_PER_SEC / CLOCK_HZ) : 0U;
+}
+
+/* Called by the tick of an isolated CPU. With a single task there is nothing to preempt it for, so the timer is
+ * programmed for the next timed event instead. Anything queued here restarts the tick */
+static void tick_nohz_full_enter(struct RunQueue *rq) {
+  spin_lock(&rq->lock);
+
+  if (rq->nr_running == 0U && rq->curr != rq->idle) {
+    u64 delay = tick_next_event(rq);
+    if (delay > TICK_INTERVAL) {
+      local_timer_set_next_event((u32)delay);
+      rq->tick_isolated = true;
+    }
+  }
+
+  spin_unlock(&rq->lock);
 }
 
-void switch_to(struct TaskBlock *next) {
-  if (current != next) {
-    if ((next->cpu_context.sp & 15) != 0) {
-      log("ERROR: Stack pointer not 16-byte aligned\n");
-      return;
+void scheduler_tick_handler() {
+  if (!current || is_initialized == false) {
+    return;
+  }
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = this_rq();
+  struct TaskBlock *curr = current;
+
+  // Tasks woken by a timer are queued before the preemption check below
+  run_timers(rq);
+
+  spin_lock(&rq->lock);
+  rq->clock = sched_clock();
+  rq->nr_ticks++;
+
+  // The timer that fired was reloaded with the regular interval
+  rq->tick_isolated = false;
+  sched_trace_tick(curr);
+
+  // Deadline tasks whose period started are runnable again, whether they slept or were throttled
+  struct TaskBlock *released;
+  while ((released = dl_pop_release(rq)) != NULL) {
+    released->state = TASK_RUNNING;
+    if (released != curr) {
+      enqueue_task(rq, released, 0U);
+    }
+  }
+
+  if (rq->nr_ticks % SCHED_QUANTUM_TICKS == 0U) {
+    update_load_avg(rq);
+  }
+
+  // Idle CPUs pull work whenever they schedule, busy ones even out their load averages every few ticks
+  if (--rq->balance_ticks == 0U) {
+    rq->balance_ticks = SCHED_BALANCE_TICKS;
+    load_balance(rq, false);
+  }
+
+  // The idle task has no timeslice, it only gives way once something is runnable
+  bool expired;
+  if (curr == rq->idle) {
+    expired = rq->nr_running > 0;
+  } else {
+    expired = curr->sched_class->task_tick(rq, curr);
+
+    // A task of a higher class became runnable since the last tick
+    for (const struct SchedClass *class = sched_class_highest; class != curr->sched_class; class = class->next) {
+      expired = expired || class->has_tasks(rq);
     }
 
-    if ((next->cpu_context.lr & 3) != 0) {
-      log("ERROR: Link register not 4-byte aligned\n");
-      return;
+    // Its affinity changed while it ran, it moves on as it leaves the CPU
+    expired = expired || (curr->policy != SCHED_DEADLINE && !(task_allowed_cpus(curr) & (1U << rq->cpu)));
+  }
+
+  // CPUs with their tick stopped do not balance, so one is woken to pull the tasks waiting here
+  u64 idle_mask = nohz_idle_mask & ~(u64)cpu_isolated_mask;
+  bool kick = idle_mask != 0U && (rq->cfs.nr_running + rq->rr.nr_running) > 0U;
+
+  spin_unlock(&rq->lock);
+
+  if (kick) {
+    irq_send_reschedule((u32)__builtin_ctzll(idle_mask));
+  }
+
+  if (!expired || curr->preempt_count > 0) {
+    if (cpu_isolated(rq->cpu) && curr != rq->idle) {
+      tick_nohz_full_enter(rq);
     }
+    irq_restore_flags(flags);
+    return;
+  }
+
+  _schedule(true);
+  irq_restore_flags(flags);
+}
+
+/* Called by the idle task with IRQs masked. Instead of ticking through the sleep, the timer is programmed for the
+ * next timed event, the earliest armed timer or deadline task release. Tasks queued from elsewhere come with an IPI */
+static void tick_nohz_idle_enter(struct RunQueue *rq) {
+  spin_lock(&rq->lock);
+  rq->clock = sched_clock();
+  u64 delay = tick_next_event(rq);
+
+  // An event due within the next tick is caught by that tick anyway
+  if (delay > TICK_INTERVAL) {
+    local_timer_set_next_event((u32)delay);
+    rq->tick_stopped = true;
+    rq->tick_stop_time = rq->clock;
+    atomic_add_return(&nohz_idle_mask, 1ULL << rq->cpu);
+  }
+
+  spin_unlock(&rq->lock);
+}
+
+/* Restart the periodic tick once the idle CPU woke up, whether for its event or for any other interrupt */
+static void tick_nohz_idle_exit(struct RunQueue *rq) {
+  if (!rq->tick_stopped) {
+    return;
+  }
+
+  atomic_add_return(&nohz_idle_mask, -(1ULL << rq->cpu));
+  local_timer_set_next_event(TICK_INTERVAL);
+
+  spin_lock(&rq->lock);
+  rq->clock = sched_clock();
+  rq->tick_stopped = false;
+  decay_load_avg(rq, (rq->clock - rq->tick_stop_time) / ((NSEC_PER_SEC / SCHED_TICK_HZ) * SCHED_QUANTUM_TICKS));
+  spin_unlock(&rq->lock);
+}
+
+/* Must be called with tasklist_lock held */
+static void link_task(struct TaskBlock *p) {
+  p->next_task = &init_task;
+  p->prev_task = init_task.prev_task;
+  init_task.prev_task->next_task = p;
+  init_task.prev_task = p;
+
+  u32 bucket = p->pid % PID_HASH_SIZE;
+  p->pid_next = pid_hash[bucket];
+  pid_hash[bucket] = p;
+
+  nr_tasks++;
+}
 
-    struct TaskBlock *prev = current;
-    current = next;
-    cpu_context_switch(prev, next);
+/* Must be called with tasklist_lock held */
+static void unlink_task(struct TaskBlock *p) {
+  p->prev_task->next_task = p->next_task;
+  p->next_task->prev_task = p->prev_task;
+
+  struct TaskBlock **link = &pid_hash[p->pid % PID_HASH_SIZE];
+  while (*link != p) {
+    link = &(*link)->pid_next;
+  }
+  *link = p->pid_next;
+
+  nr_tasks--;
+}
+
+/* Stacks come from the buddy allocator, so the number of tasks is only limited by memory */
+static u64 alloc_task_stack(void) {
+  struct Page *page = buddy_alloc_pages(0U);
+  if (!page) {
+    return 0U;
   }
+
+  u64 stack = (u64)page_to_virt(page);
+  memzero(stack, PAGE_SIZE);
+
+  return stack;
+}
+
+static void free_task_stack(u64 stack) {
+  buddy_free_pages(virt_to_page((void *)stack));
 }
 
-static void update_task_timeslices(void) {
-  struct TaskBlock *p;
+/* Must be called with tasklist_lock held. The page is zeroed here, so taking it for a new task costs nothing */
+static void put_task_stack(u64 stack) {
+  if (stack_cache_count == TASK_STACK_CACHE_SIZE) {
+    free_task_stack(stack);
+    return;
+  }
 
-  for (int i = 0; i < NUM_TASKS; i++) {
-    p = task[i];
-    if (!p) continue;
+  memzero(stack, PAGE_SIZE);
+  stack_cache[stack_cache_count++] = stack;
+}
 
-    // Calculate new counter values
-    long new_counter = (p->counter >> 1) + p->priority;
-    p->counter = max(MIN_TIMESLICE, new_counter);
+static u64 get_task_stack(void) {
+  u64 stack = 0U;
 
-    // Cap the counter to priority based maximum
-    p->counter = min(p->counter, p->priority * 2);
+  spin_lock(&tasklist_lock);
+  if (stack_cache_count > 0U) {
+    stack = stack_cache[--stack_cache_count];
   }
+  spin_unlock(&tasklist_lock);
+
+  return stack ? stack : alloc_task_stack();
 }
 
-static int pick_next_task(void) {
-  int next = 0;
-  int max_counter = -1;
-  volatile struct TaskBlock *p;
-  bool found = false;
+/* Must be called with tasklist_lock held. A zombie whose CPU has not switched away from its stack yet is left for
+ * the next call. A joinable zombie gives back its stack, but keeps its task block and PID until it is waited for */
+static void reap_zombies(void) {
+  struct TaskBlock **link = &zombies;
 
-  for (int i = 0; i < NUM_TASKS; i++) {
-    p = task[i];
-    if (!p || p->state != TASK_RUNNING || p->counter == 0) {
+  while (*link) {
+    struct TaskBlock *p = *link;
+    if (p->on_cpu) {
+      link = &p->rq_next;
       continue;
     }
-    if (p->counter > max_counter) {
-      max_counter = p->counter;
-      next = i;
-      found = true;
+
+    if (p->stack) {
+      put_task_stack(p->stack);
+      p->stack = 0U;
+    }
+    if (p->flags & PF_JOINABLE) {
+      link = &p->rq_next;
+      continue;
     }
-  }
 
-  if (found) {
-    return next;
+    *link = p->rq_next;
+    unlink_task(p);
+    pid_free(p->pid);
+    kfree(p);
   }
+}
 
-  update_task_timeslices();
+static void idle_task(u64 arg) {
+  // The idle task never migrates, so its runqueue is fixed
+  struct RunQueue *rq = this_rq();
 
-  for (int i = 0; i < NUM_TASKS; i++) {
-    p = task[i];
-    if (!p || p->state != TASK_RUNNING) {
-      continue;
+  while (1) {
+    // Free exited tasks while there is nothing else to do, rather than on the next task creation
+    if (zombies && rq->nr_running == 0U) {
+      preempt_disable();
+      spin_lock(&tasklist_lock);
+      reap_zombies();
+      spin_unlock(&tasklist_lock);
+      preempt_enable();
     }
-    if (p->counter > max_counter) {
-      max_counter = p->counter;
-      next = i;
+
+    // Checked with IRQs masked. An IRQ that queues a task after the check stays pending, which ends the wfi,
+    // and is taken once IRQs are unmasked again
+    irq_disable();
+    if (rq->nr_running == 0U) {
+      tick_nohz_idle_enter(rq);
+      // Sleeping in wfi is not an IRQ off section, pending IRQs end it right away
+      sched_trace_irqs_on((u64)idle_task);
+      cpu_wait_for_interrupt();
+      sched_trace_irqs_off();
+      tick_nohz_idle_exit(rq);
+    }
+    irq_enable();
+    schedule();
+  }
+}
+
+/* Must be called with tasklist_lock held. A zombie is returned too, the caller decides whether it wants one */
+static struct TaskBlock *find_task(u32 pid) {
+  for (struct TaskBlock *p = pid_hash[pid % PID_HASH_SIZE]; p; p = p->pid_next) {
+    if (p->pid == pid) {
+      return p;
     }
   }
 
-  return (max_counter > 0) ? next : -1;
+  return NULL;
 }
 
-void _schedule(void) {
+struct TaskBlock *scheduler_find_task(u32 pid) {
   preempt_disable();
-  int next;
+  spin_lock(&tasklist_lock);
+  struct TaskBlock *p = find_task(pid);
+  if (p && p->state == TASK_ZOMBIE) {
+    p = NULL;
+  }
+  spin_unlock(&tasklist_lock);
+  preempt_enable();
 
-  while (1) {
-    next = pick_next_task();
-    if (next >= 0) {
-      break;
+  return p;
+}
+
+/* The idle task is not in the task list, it is only picked when its runqueue is empty */
+static struct TaskBlock *create_idle_task(u32 cpu) {
+  struct TaskBlock *idle = kzalloc(sizeof(struct TaskBlock));
+  u64 idle_stack = alloc_task_stack();
+
+  if (!idle || !idle_stack) {
+    log("ERROR: Failed to allocate the idle task of CPU %d\n\r", cpu);
+    if (idle_stack) {
+      free_task_stack(idle_stack);
     }
-    update_task_timeslices();
+    kfree(idle);
+    return NULL;
   }
 
-  if (task[next] != current) {
-    switch_to(task[next]);
+  idle->stack = idle_stack;
+  idle->state = TASK_RUNNING;
+  idle->priority = MIN_PRIORITY;
+  idle->normal_priority = MIN_PRIORITY;
+  idle->preempt_count = 1;
+  idle->flags = PF_KTHREAD;
+  idle->cpu = cpu;
+  idle->cpus_allowed = 1U << cpu;
+  idle->cpu_context.x19 = (u64)&idle_task;
+  idle->cpu_context.sp = (u64)get_current_pstate(idle);
+  idle->cpu_context.lr = get_cpu_new_task_addr();
+
+  return idle;
+}
+
+void scheduler_init() {
+  set_current(&init_task);
+  init_task.next_task = &init_task;
+  init_task.prev_task = &init_task;
+  pid_hash[0] = &init_task;
+
+  nr_tasks = 1;
+
+  memzero((u64)runqueues, sizeof(runqueues));
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    struct RunQueue *rq = cpu_rq(cpu);
+    rq->cpu = cpu;
+    rq->balance_ticks = SCHED_BALANCE_TICKS;
+    dl_init_rq(rq);
+    rr_init_rq(rq);
+    fair_init_rq(rq);
+    rq->clock = sched_clock();
   }
 
-  preempt_enable();
+  struct RunQueue *rq = this_rq();
+
+  init_task.policy = SCHED_NORMAL;
+  init_task.normal_policy = SCHED_NORMAL;
+  init_task.sched_class = &fair_sched_class;
+  fair_sched_class.switched_to(rq, &init_task);
+  init_task.cpu = rq->cpu;
+  init_task.on_cpu = true;
+  rq->curr = &init_task;
+
+  // The boot CPU starts its idle task like a kernel thread, the first time it is picked
+  rq->idle = create_idle_task(rq->cpu);
+
+  cpu_online_mask = 1U << rq->cpu;
+  // Every CPU ticks from its own generic timer, which leaves the shared system timer to drivers
+  local_timer_init(TICK_INTERVAL, scheduler_tick_handler);
+  irq_enable_ipi();
+
+  is_initialized = true;
 }
 
-void schedule() {
+u32 scheduler_smp_init(void) {
   if (is_initialized == false) {
-    return;
+    return 1U;
   }
-  if (current->preempt_count > 0) {
-    return;
+
+  // The caller decides on the cache, since drivers that share buffers with the VideoCore need to know
+  if (!mmu_dcache_enabled()) {
+    log("ERROR: Enable the MMU and data cache before starting the secondary cores\n\r");
+    return 1U;
   }
 
-  current->counter = 0;
-  _schedule();
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    struct RunQueue *rq = cpu_rq(cpu);
+    if (cpu_online(cpu) || rq->idle) {
+      continue;
+    }
+
+    // A secondary core boots straight into its idle task, on the idle task's stack
+    rq->idle = create_idle_task(cpu);
+    if (!rq->idle) {
+      continue;
+    }
+    rq->idle->on_cpu = true;
+    rq->curr = rq->idle;
+
+    cpu_start_secondary(cpu, (u64)&secondary_entry, (u64)get_current_pstate(rq->idle));
+
+    // Cores that do not exist, such as with fewer QEMU cores, never come online
+    u64 start = timer_get_ticks();
+    while (!cpu_online(cpu) && timer_get_ticks() - start < SMP_BOOT_TIMEOUT) {
+    }
+
+    if (!cpu_online(cpu)) {
+      log("CPU %d did not come online\n\r", cpu);
+    }
+  }
+
+  return scheduler_num_online_cpus();
 }
 
-void scheduler_tick_handler() {
-  if (!current) {
-    return;
+void secondary_main(u32 cpu) {
+  struct RunQueue *rq = cpu_rq(cpu);
+  struct TaskBlock *idle = rq->idle;
+
+  mmu_init_secondary();
+  irq_init_vectors();
+
+  set_current(idle);
+  idle->preempt_count = 0;
+
+  spin_lock(&rq->lock);
+  rq->clock = sched_clock();
+  rq->idle_start = rq->clock;
+  spin_unlock(&rq->lock);
+
+  local_timer_init(TICK_INTERVAL, scheduler_tick_handler);
+  irq_enable_ipi();
+
+  // Other CPUs start placing tasks here once the CPU is marked online
+  dmb();
+  cpu_online_mask |= 1U << cpu;
+
+  irq_enable();
+  idle_task(0);
+}
+
+u32 scheduler_num_online_cpus(void) {
+  return (u32)__builtin_popcount(cpu_online_mask);
+}
+
+int task_set_affinity(u32 pid, u32 mask) {
+  mask &= CPU_MASK_ALL;
+  if (mask == 0U) {
+    return -1;
   }
-  volatile u64 flags = 0;
-  irq_save_flags(flags);
-  if (--current->counter > 0 || current->preempt_count > 0) {
+
+  // Holding the task list lock keeps the task from being reaped while it is changed
+  u64 flags = irq_save_flags();
+  spin_lock(&tasklist_lock);
+  struct TaskBlock *p = find_task(pid);
+  if (!p || p->state == TASK_ZOMBIE) {
+    spin_unlock(&tasklist_lock);
     irq_restore_flags(flags);
-    return;
+    return -1;
   }
-  irq_disable();
 
-  current->counter = 0;
-  _schedule();
+  struct RunQueue *rq = task_rq_lock(p);
+
+  // Deadline bandwidth was admitted on the CPU the task is on
+  if (p->policy == SCHED_DEADLINE && !(mask & (1U << rq->cpu))) {
+    spin_unlock(&rq->lock);
+    spin_unlock(&tasklist_lock);
+    irq_restore_flags(flags);
+    return -1;
+  }
+
+  p->cpus_allowed = mask;
+  spin_unlock(&rq->lock);
+
+  push_task(p, false);
+  spin_unlock(&tasklist_lock);
   irq_restore_flags(flags);
-  irq_enable();
+
+  // Running tasks move once they leave the CPU, which the current task can do right away
+  if (p == current && !(task_allowed_cpus(p) & (1U << get_cpu_id()))) {
+    schedule();
+  }
+
+  return 0;
 }
 
-void scheduler_init() {
-  current = (struct TaskBlock *)get_free_page();
-  current = &init_task;
-  task[0] = current;
+u32 task_get_affinity(u32 pid) {
+  u32 mask = 0U;
 
-  num_tasks = 1;
+  preempt_disable();
+  spin_lock(&tasklist_lock);
+  struct TaskBlock *p = find_task(pid);
+  if (p && p->state != TASK_ZOMBIE) {
+    mask = p->cpus_allowed;
+  }
+  spin_unlock(&tasklist_lock);
+  preempt_enable();
 
-  timer_init(3, (CLOCK_HZ / 10), scheduler_tick_handler);
+  return mask;
+}
 
-  is_initialized = true;
+int scheduler_isolate_cpus(u32 mask) {
+  mask &= CPU_MASK_ALL;
+  if ((cpu_online_mask & ~mask) == 0U) {
+    return -1;
+  }
+
+  // Queued tasks that may no longer stay where they are move now, a running one moves once it leaves its CPU
+  u64 flags = irq_save_flags();
+  spin_lock(&tasklist_lock);
+  cpu_isolated_mask = mask;
+
+  struct TaskBlock *p = &init_task;
+  do {
+    if (p->on_rq && (mask & (1U << p->cpu))) {
+      push_task(p, false);
+    }
+    p = p->next_task;
+  } while (p != &init_task);
+
+  spin_unlock(&tasklist_lock);
+  irq_restore_flags(flags);
+  return 0;
+}
+
+void scheduler_handle_ipi(void) {
+  if (is_initialized == false) {
+    return;
+  }
+
+  struct RunQueue *rq = this_rq();
+  spin_lock(&rq->lock);
+  tick_nohz_full_exit(rq);
+  spin_unlock(&rq->lock);
+}
+
+void scheduler_get_cpu_stats(u32 cpu, struct SchedCpuStats *stats) {
+  if (cpu >= NUM_CPUS) {
+    memzero((u64)stats, sizeof(*stats));
+    return;
+  }
+
+  struct RunQueue *rq = cpu_rq(cpu);
+  u64 flags = irq_save_flags();
+  spin_lock(&rq->lock);
+
+  stats->switches = rq->nr_switches;
+  stats->migrations = rq->nr_migrations;
+  stats->idle_ns = rq->idle_ns;
+  stats->load_avg = rq->load_avg;
+  stats->ticks = rq->nr_ticks;
+
+  // Include the idle period the CPU is in right now
+  if (rq->idle && rq->curr == rq->idle) {
+    stats->idle_ns += sched_clock() - rq->idle_start;
+  }
+
+  spin_unlock(&rq->lock);
+  irq_restore_flags(flags);
 }
 
 int scheduler_create_task(u64 clone_flags, u64 func, u64 arg, long priority) {
+  return scheduler_create_task_pid(clone_flags, func, arg, priority, NULL);
+}
+
+int scheduler_create_task_pid(u64 clone_flags, u64 func, u64 arg, long priority, u32 *pid) {
   if (is_initialized == false) {
     return 1;
   }
-  if (num_tasks >= NUM_TASKS) {
-    return 2;
+
+  return scheduler_create_task_affinity(clone_flags, func, arg, priority, current->cpus_allowed, pid);
+}
+
+int scheduler_create_task_affinity(u64 clone_flags, u64 func, u64 arg, long priority, u32 cpus_allowed, u32 *pid) {
+  if (is_initialized == false) {
+    return 1;
+  }
+
+  cpus_allowed &= CPU_MASK_ALL;
+  if (cpus_allowed == 0U) {
+    return 6;
   }
 
   preempt_disable();
-  struct TaskBlock *p;
+  spin_lock(&tasklist_lock);
+  reap_zombies();
+  spin_unlock(&tasklist_lock);
 
-  p = (struct TaskBlock *)get_free_page();
-  if (!p) return 3;
+  struct TaskBlock *p = kzalloc(sizeof(struct TaskBlock));
+  if (!p) {
+    preempt_enable();
+    return 3;
+  }
 
-  if ((unsigned long)p < LOW_MEMORY || (unsigned long)p >= HIGH_MEMORY) {
+  p->stack = get_task_stack();
+  if (!p->stack) {
+    kfree(p);
     preempt_enable();
     return 4;
   }
 
+  p->pid = pid_alloc();
+  if (p->pid == PID_NONE) {
+    free_task_stack(p->stack);
+    kfree(p);
+    preempt_enable();
+    return 2;
+  }
+
   ProcessStateRegisters *childregs = get_current_pstate(p);
   memzero((u64)childregs, sizeof(ProcessStateRegisters));
-  memzero((u64)p, sizeof(struct TaskBlock));
 
   if (clone_flags & PF_KTHREAD) {
     p->cpu_context.x19 = func;
@@ -201,67 +1457,195 @@ int scheduler_create_task(u64 clone_flags, u64 func, u64 arg, long priority) {
     ProcessStateRegisters *cur_regs = get_current_pstate(current);
     *childregs = *cur_regs;
     childregs->regs[0] = 0;
-    // childregs->sp = stack + PAGE_SIZE;
-    // p->stack = stack;
+
+    // Fork: the child shares every page copy-on-write, including the user stack
+    if (current->mm) {
+      p->mm = address_space_clone(current->mm);
+      if (!p->mm) {
+        pid_free(p->pid);
+        free_task_stack(p->stack);
+        kfree(p);
+        preempt_enable();
+        return 5;
+      }
+    }
   }
 
   p->state = TASK_RUNNING;
-  p->priority = priority;
-  p->counter = priority;
+  p->flags = clone_flags;
+  p->priority = clamp_priority(priority);
+  p->counter = p->priority * SCHED_QUANTUM_TICKS;
   p->preempt_count = 1;
 
+  // Children take the parent's own policy, not one it inherited. A deadline reservation belongs to one task, so
+  // children fall back to fair scheduling
+  p->policy = current->normal_policy;
+  if (p->policy == SCHED_DEADLINE) {
+    p->policy = SCHED_NORMAL;
+  }
+  p->sched_class = policy_class(p->policy);
+  p->normal_policy = p->policy;
+  p->normal_priority = p->priority;
+  p->pi_rank = SCHED_PI_NONE;
+  p->pi_held = NULL;
+
   // Get the actual runtime address of cpu_new_task
   u64 new_task_addr = get_cpu_new_task_addr();
 
   p->cpu_context.x19 = func;
   p->cpu_context.x20 = arg;
-  p->cpu_context.sp = ((u64)p + TASK_SIZE) & ~15ULL;
+  // The kernel stack starts below the saved user registers, so kernel_exit finds them at sp
+  p->cpu_context.sp = (u64)childregs;
   p->cpu_context.lr = new_task_addr;
+  p->cpus_allowed = cpus_allowed;
+  p->cpu = select_task_rq_fork(task_allowed_cpus(p));
+
+  spin_lock(&tasklist_lock);
+  link_task(p);
+  spin_unlock(&tasklist_lock);
+  if (pid) {
+    *pid = p->pid;
+  }
+
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = task_rq_lock(p);
+  rq->clock = sched_clock();
+  sched_trace_wakeup(p, rq->cpu);
+  enqueue_task(rq, p, ENQUEUE_NEW);
+  spin_unlock(&rq->lock);
+
+  if (rq->cpu != get_cpu_id()) {
+    irq_send_reschedule(rq->cpu);
+  }
+  irq_restore_flags(flags);
 
-  u8 pid = num_tasks++;
-  task[pid] = p;
   preempt_enable();
   return 0;
 }
 
-int move_task_to_user_mode(u64 func) {
+int move_task_to_user_mode(u64 start, u64 size, u64 pc) {
+  struct AddressSpace *mm = address_space_create();
+  if (!mm) {
+    return -1;
+  }
+
+  // Copy the user code page by page. The pages are mapped read-only and executable for EL0
+  for (u64 offset = 0; offset < size; offset += PAGE_SIZE) {
+    u8 *page = address_space_alloc_page(mm, USER_VA_START + offset, PAGE_USER_EXEC);
+    if (!page) {
+      address_space_destroy(mm);
+      return -1;
+    }
+    memcpy(page, (void *)(start + offset), min(size - offset, (u64)PAGE_SIZE));
+    mmu_sync_icache_range((u64)page, PAGE_SIZE);
+  }
+
+  // The heap starts empty right after the code and the stack is only reserved. Both are backed on first touch
+  u64 code_end = USER_VA_START + ((size + PAGE_SIZE - 1) & ~((u64)PAGE_SIZE - 1));
+  bool regions_ok = address_space_add_region(mm, USER_VA_START, code_end, VM_READ | VM_EXEC) != NULL;
+
+  mm->heap = address_space_add_region(mm, code_end, code_end, VM_READ | VM_WRITE);
+  regions_ok = regions_ok && mm->heap != NULL;
+  regions_ok = regions_ok && address_space_add_region(mm, USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_TOP,
+                                                      VM_READ | VM_WRITE) != NULL;
+  if (!regions_ok) {
+    address_space_destroy(mm);
+    return -1;
+  }
+
   ProcessStateRegisters *regs = get_current_pstate(current);
   memzero((u64)regs, sizeof(*regs));
   // Points to the function that needs to be executed next in user mode.
   // Kernel_exit will copy PC to the ELR_EL1 register, ensuring that we return to this function
-  regs->pc = func;
+  regs->pc = USER_VA_START + (pc - start);
 
   // This is copied to spsr_el1 by kernel_exit and becomes the new state of the processor after
   // leaving.
   regs->pstate = PSR_MODE_EL0t;
+  regs->sp = USER_STACK_TOP;
 
-  // New user stack
-  u64 stack = (u64)get_free_page();
-  if (!stack) {
-    return -1;
-  }
-
-  regs->sp = stack + PAGE_SIZE;
-  current->stack = stack;
+  current->mm = mm;
+  address_space_switch(mm);
   return 0;
 }
 
 ProcessStateRegisters *get_current_pstate(struct TaskBlock *task) {
   // We will save the ProcessStateRegisters at the top of the stack
-  u64 p = (u64)task + TASK_SIZE - sizeof(ProcessStateRegisters);
+  u64 p = task->stack + TASK_SIZE - sizeof(ProcessStateRegisters);
   return (ProcessStateRegisters *)p;
 }
 
 void scheduler_exit_task() {
+  task_exit(0);
+}
+
+void task_exit(long exit_code) {
   preempt_disable();
-  for (u8 i = 0; i < NUM_TASKS; i++) {
-    if (task[i] == current) {
-      current->state = TASK_ZOMBIE;
-    }
+  current->exit_code = exit_code;
+
+  u64 flags = irq_save_flags();
+  struct RunQueue *rq = this_rq();
+  spin_lock(&rq->lock);
+  current->state = TASK_ZOMBIE;
+  if (current->sched_class && current->sched_class->switched_from) {
+    rq->clock = sched_clock();
+    current->sched_class->switched_from(rq, current);
+  }
+  // The last schedule() hands the task to its class once more, the deadline class must not park it for a next period
+  if (current->sched_class == &dl_sched_class) {
+    current->policy = SCHED_RR;
+    current->sched_class = &rr_sched_class;
+  }
+  spin_unlock(&rq->lock);
+  irq_restore_flags(flags);
+
+  if (current->mm) {
+    address_space_switch_kernel();
+    address_space_destroy(current->mm);
+    current->mm = NULL;
+  }
+
+  // The task is still running on its stack, so it is freed by the next task creation instead. The init task is static
+  if (current != &init_task) {
+    spin_lock(&tasklist_lock);
+    current->rq_next = zombies;
+    zombies = current;
+    spin_unlock(&tasklist_lock);
   }
-  if (current->stack) {
-    free_page(current->stack);
+
+  if (current->flags & PF_JOINABLE) {
+    wake_up_all(&task_exit_wq);
   }
   preempt_enable();
   schedule();
 }
+
+int task_wait(u32 pid, long *exit_code) {
+  // Claiming the task under the lock keeps a second waiter from freeing it under the first one
+  preempt_disable();
+  spin_lock(&tasklist_lock);
+  struct TaskBlock *p = find_task(pid);
+  if (!p || p == current || !(p->flags & PF_JOINABLE) || p->waiter) {
+    spin_unlock(&tasklist_lock);
+    preempt_enable();
+    return -1;
+  }
+  p->waiter = current;
+  spin_unlock(&tasklist_lock);
+  preempt_enable();
+
+  // The task block stays valid until the joinable flag is cleared below
+  wait_event(&task_exit_wq, p->state == TASK_ZOMBIE);
+
+  preempt_disable();
+  spin_lock(&tasklist_lock);
+  if (exit_code) {
+    *exit_code = p->exit_code;
+  }
+  p->flags &= ~PF_JOINABLE;
+  reap_zombies();
+  spin_unlock(&tasklist_lock);
+  preempt_enable();
+
+  return 0;
+}
@@ -2,6 +2,7 @@
 
 #include <stddef.h>
 
+#include "address_space.h"
 #include "entry.h"
 #include "log.h"
 #include "mem.h"
@@ -12,20 +13,30 @@ void sys_call_write(char *buf) {
   log(buf);
 }
 
-int sys_call_clone_task(unsigned long stack) {
-  return scheduler_create_task(0, 0, 0, stack);
+int sys_call_clone_task() {
+  // The child returns from this syscall with 0, the parent gets the child's PID
+  u32 pid;
+  if (scheduler_create_task_pid(0, 0, 0, current->priority, &pid) != 0) {
+    return -1;
+  }
+  return pid;
 }
 
 unsigned long sys_call_malloc() {
-  u64 addr = (u64)get_free_page();
+  // Grow the heap by a page. The page is only backed once the task touches it
+  u64 addr = current->mm ? address_space_brk(current->mm, PAGE_SIZE) : 0;
   if (!addr) {
     return -1;
   }
   return addr;
 }
 
-void sys_call_exit() {
-  scheduler_exit_task();
+void sys_call_exit(long exit_code) {
+  task_exit(exit_code);
+}
+
+int sys_call_getpid() {
+  return current->pid;
 }
 
-void *const sys_call_table[] = { sys_call_write, sys_call_malloc, sys_call_clone_task, sys_call_exit };
+void *const sys_call_table[] = { sys_call_write, sys_call_malloc, sys_call_clone_task, sys_call_exit, sys_call_getpid };
@@ -0,0 +1,208 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   address_space.h
+ *
+ * @brief  Per-task address space and ASID management header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+#include "spinlock.h"
+
+/* Intra-component Headers */
+#include "mmu.h"
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/** @brief  Start of the user part of TTBR0. Everything below is the shared kernel identity map */
+#define USER_VA_START IDENTITY_MAP_END
+/** @brief  End of the user part of TTBR0 */
+#define USER_VA_END (1UL << VA_BITS)
+/** @brief  Initial user stack pointer */
+#define USER_STACK_TOP USER_VA_END
+/** @brief  Address space reserved for the user stack. Pages are only backed once touched */
+#define USER_STACK_SIZE (1UL << 20)
+/** @brief  Unmapped gap below the stack region, so an overflow faults instead of running into other memory */
+#define USER_STACK_GUARD_SIZE PAGE_SIZE
+
+/* Region flags */
+#define VM_READ (1U << 0)
+#define VM_WRITE (1U << 1)
+#define VM_EXEC (1U << 2)
+
+/** @brief  ASID field of TTBR0_EL1 */
+#define TTBR_ASID_SHIFT 48
+
+/**
+ * @brief   Reserved range of a user address space
+ * @details Pages inside a region are allocated on first touch by the fault handler
+ */
+struct VmRegion {
+  u64 start;             /**< First address of the region */
+  u64 end;               /**< Address just past the region */
+  u32 flags;             /**< VM_READ, VM_WRITE and VM_EXEC */
+  struct VmRegion *next; /**< Next region, sorted by address */
+};
+
+/**
+ * @brief   Translation tables of one user address space
+ * @details The kernel identity map entries are copied into every root table, so kernel code keeps
+ *          running after TTBR0 is switched. They are global, while user pages are tagged with the ASID
+ */
+struct AddressSpace {
+  u64 *pgd;                  /**< Root (level 1) table */
+  u64 context_id;            /**< ASID generation in the upper bits, ASID in the lower mmu_asid_bits() bits */
+  struct VmRegion *regions;  /**< Reserved regions, sorted by address */
+  struct VmRegion *heap;     /**< Region grown by address_space_brk, NULL until one is set up */
+  u32 rss_pages;             /**< Pages currently backed by memory (the zero page is not counted) */
+  u32 swap_pages;            /**< Pages compressed into zram */
+  struct Spinlock lock;      /**< Guards the user page tables against the swap clock, see address_space_lock */
+  struct AddressSpace *next; /**< Next address space, for the swap clock */
+};
+
+/**
+ * @brief   Create an empty user address space
+ * @details The MMU is enabled if this is the first address space
+ * @return  Pointer to the address space or NULL if no memory can be allocated
+ */
+struct AddressSpace *address_space_create(void);
+
+/**
+ * @brief   Free an address space, its tables and every page mapped or swapped out in it
+ * @details Must not be the active address space. The ASID is not reused until the next generation
+ *          rollover, which flushes the TLB, so no stale translation can be hit
+ * @param   as Address space to destroy
+ */
+void address_space_destroy(struct AddressSpace *as);
+
+/**
+ * @brief   Duplicate an address space for a forked task
+ * @details Only the tables are copied. Every page is shared and its reference count raised, and
+ *          writable pages become read-only in both address spaces. The first write to one of them
+ *          copies the page (see do_mem_abort). Swapped out pages share their zram slot until one of the
+ *          address spaces swaps its copy back in. Must not be preempted by a task sharing the pages
+ * @param   parent Address space to duplicate
+ * @return  Pointer to the new address space or NULL if no memory can be allocated
+ */
+struct AddressSpace *address_space_clone(struct AddressSpace *parent);
+
+/**
+ * @brief   Iterate over every live address space
+ * @details Must be called with the address space list locked
+ * @param   as Current address space, NULL to start at the first one
+ * @return  The next address space, NULL after the last one
+ */
+struct AddressSpace *address_space_next(struct AddressSpace *as);
+
+/**
+ * @brief   Lock the address space list
+ * @details No address space on the list can be destroyed while it is held. Also guards the swap clock hand.
+ *          Taken before any address_space_lock. Preemption stays disabled until it is released
+ */
+void address_space_list_lock(void);
+
+/**
+ * @brief   Unlock the address space list
+ */
+void address_space_list_unlock(void);
+
+/**
+ * @brief   Lock the user page tables of an address space
+ * @details Held by the fault handler, fork and the swap clock while they change user entries. Reclaim takes it
+ *          too, so no user page may be allocated while it is held. Preemption stays disabled until it is released
+ * @param   as Address space
+ */
+void address_space_lock(struct AddressSpace *as);
+
+/**
+ * @brief   Unlock the user page tables of an address space
+ * @param   as Address space
+ */
+void address_space_unlock(struct AddressSpace *as);
+
+/**
+ * @brief   Drop a reference to a mapped user page
+ * @details The page is returned to the buddy allocator with its last reference. The zero page is ignored
+ * @param   pa Physical address of the page
+ */
+void address_space_put_page(u64 pa);
+
+/**
+ * @brief   Invalidate the TLB entries of an address space
+ * @details Only its ASID is invalidated. Nothing needs to be done if it holds no ASID from the
+ *          current generation, since a rollover invalidated the whole TLB
+ * @param   as Address space
+ */
+void address_space_flush_tlb(struct AddressSpace *as);
+
+/**
+ * @brief   Allocate a zeroed page and map it into an address space
+ * @param   as Address space
+ * @param   va Page aligned user virtual address
+ * @param   attrs Descriptor attributes (PAGE_USER or PAGE_USER_EXEC)
+ * @return  Kernel pointer to the page or NULL if no memory can be allocated or va is already mapped
+ */
+void *address_space_alloc_page(struct AddressSpace *as, u64 va, u64 attrs);
+
+/**
+ * @brief   Reserve a region without backing it
+ * @param   as Address space
+ * @param   start Page aligned start address
+ * @param   end Page aligned end address. May equal start for a region that is grown later (the heap)
+ * @param   flags VM_READ, VM_WRITE and VM_EXEC
+ * @return  Pointer to the region or NULL if it overlaps another region or no memory can be allocated
+ */
+struct VmRegion *address_space_add_region(struct AddressSpace *as, u64 start, u64 end, u32 flags);
+
+/**
+ * @brief   Find the region containing an address
+ * @param   as Address space
+ * @param   va Virtual address
+ * @return  Pointer to the region or NULL if the address is not reserved
+ */
+struct VmRegion *address_space_find_region(struct AddressSpace *as, u64 va);
+
+/**
+ * @brief   Grow the heap region
+ * @details Only reserves address space. The new pages are backed on first touch
+ * @param   as Address space with a heap region
+ * @param   increment Number of bytes to grow by, rounded up to whole pages
+ * @return  Previous end of the heap, 0 if there is no heap or it would run into the next region
+ */
+u64 address_space_brk(struct AddressSpace *as, u64 increment);
+
+/**
+ * @brief   Descriptor attributes for pages of a region
+ * @param   region Region
+ * @return  PAGE_USER, PAGE_USER_EXEC or a read-only PAGE_USER
+ */
+u64 address_space_region_attrs(struct VmRegion *region);
+
+/**
+ * @brief   Make an address space the active TTBR0 translation
+ * @details A new ASID is only allocated if the address space has none from the current generation.
+ *          Otherwise this is a single TTBR0_EL1 write with no TLB maintenance
+ * @param   as Address space to activate. NULL keeps the current translation (kernel threads)
+ */
+void address_space_switch(struct AddressSpace *as);
+
+/**
+ * @brief   Switch TTBR0 back to the kernel identity map
+ */
+void address_space_switch_kernel(void);
+
+/** @} */
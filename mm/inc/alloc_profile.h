@@ -0,0 +1,105 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   alloc_profile.h
+ *
+ * @brief  Allocation-site profiler header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/**
+ * @brief   Sort keys for the allocation-site report
+ */
+typedef enum {
+  ALLOC_PROFILE_SORT_CYCLES,     /**< Cumulative cycles spent in the allocator */
+  ALLOC_PROFILE_SORT_LIVE_BYTES, /**< Bytes currently owned by the call site */
+  ALLOC_PROFILE_SORT_PEAK_BYTES, /**< Highest number of bytes owned at once */
+  ALLOC_PROFILE_SORT_ALLOCS,     /**< Number of allocations */
+} AllocProfileSort;
+
+#ifdef ALLOC_PROFILE
+
+/** @brief  Number of distinct call sites tracked. Further sites are folded into slot 0 */
+#define ALLOC_PROFILE_SITES 128U
+
+/**
+ * @brief   Per-call-site allocation statistics
+ */
+struct AllocSite {
+  u64 caller;     /**< Return address of the allocator call */
+  u64 allocs;     /**< Number of allocations made by this site */
+  u64 frees;      /**< Number of frees made by this site */
+  u64 live_bytes; /**< Bytes allocated by this site that are not yet freed */
+  u64 peak_bytes; /**< Highest value of live_bytes */
+  u64 cycles;     /**< Cycles spent in the allocator on behalf of this site */
+};
+
+/** @brief  Capture the return address of the profiled allocator entry point */
+#define ALLOC_PROFILE_CALLER() ((u64)__builtin_return_address(0))
+
+/** @brief  Start timing an allocator entry point */
+#define ALLOC_PROFILE_BEGIN() u64 __alloc_profile_start = pmu_read_cycles()
+
+/** @brief  Cycles elapsed since ALLOC_PROFILE_BEGIN() */
+#define ALLOC_PROFILE_ELAPSED() (pmu_read_cycles() - __alloc_profile_start)
+
+/**
+ * @brief   Record an allocation against a call site
+ * @param   caller Return address of the allocator call
+ * @param   bytes Number of bytes handed out
+ * @param   cycles Cycles spent servicing the allocation
+ * @return  Site handle to store with the allocation, passed back to alloc_profile_record_free
+ */
+u32 alloc_profile_record_alloc(u64 caller, u64 bytes, u64 cycles);
+
+/**
+ * @brief   Record a free
+ * @details The freed bytes are taken off the owning site, while the count and cycles are charged to the caller
+ * @param   owner Site handle returned when the memory was allocated
+ * @param   caller Return address of the free call
+ * @param   bytes Number of bytes released
+ * @param   cycles Cycles spent servicing the free
+ */
+void alloc_profile_record_free(u32 owner, u64 caller, u64 bytes, u64 cycles);
+
+/**
+ * @brief   Print the per-call-site table over the log UART, sorted in descending order
+ * @param   sort Column to sort by
+ */
+void alloc_profile_report(AllocProfileSort sort);
+
+/**
+ * @brief   Clear all collected statistics
+ */
+void alloc_profile_reset(void);
+
+#else
+
+/* Normal builds compile every hook away */
+#define ALLOC_PROFILE_BEGIN()
+
+static inline void alloc_profile_report(AllocProfileSort sort) {}
+static inline void alloc_profile_reset(void) {}
+
+#endif
+
+/** @} */
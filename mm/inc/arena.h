@@ -0,0 +1,113 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   arena.h
+ *
+ * @brief  Region (arena) allocator header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+
+/* Intra-component Headers */
+#include "buddy.h"
+#include "page_alloc.h"
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/** @brief  Default alignment of arena allocations */
+#define ARENA_DEFAULT_ALIGN 8U
+
+/** @brief  Chunks double in size up to 2^4 pages = 64 KB */
+#define ARENA_MAX_CHUNK_ORDER 4U
+
+/**
+ * @brief   Arena chunk header
+ * @details Stored at the start of every buddy block owned by the arena
+ */
+struct ArenaChunk {
+  struct ArenaChunk *next; /**< Next chunk in the arena */
+  struct Page *page;       /**< Buddy block backing this chunk */
+};
+
+/**
+ * @brief   Arena object
+ * @details Stored in the first chunk, directly after its chunk header
+ */
+struct Arena {
+  struct ArenaChunk *head;    /**< First chunk, kept across resets */
+  struct ArenaChunk *current; /**< Chunk being bumped */
+  u64 ptr;                    /**< Next free byte in the current chunk */
+  u64 end;                    /**< End of the current chunk */
+  u64 reset_ptr;              /**< First usable byte of the head chunk */
+  u32 next_order;             /**< Order of the next chunk to allocate */
+};
+
+/**
+ * @brief   Create an arena backed by buddy pages
+ * @param   initial_size Bytes to reserve up front. The first chunk is at least one page
+ * @return  Pointer to the arena or NULL if no memory can be allocated
+ */
+struct Arena *arena_create(size_t initial_size);
+
+/**
+ * @brief   Allocate from a new chunk when the current one is exhausted
+ * @details Called by arena_alloc, not intended to be used directly
+ * @param   arena Pointer to the arena
+ * @param   size Number of bytes to allocate
+ * @param   align Power of two alignment
+ * @return  Pointer to the allocated memory or NULL if no memory can be allocated
+ */
+void *arena_alloc_slow(struct Arena *arena, size_t size, size_t align);
+
+/**
+ * @brief   Allocate memory from an arena
+ * @details Memory is never freed individually, only by arena_reset or arena_destroy
+ * @param   arena Pointer to the arena
+ * @param   size Number of bytes to allocate
+ * @param   align Power of two alignment, 0 for ARENA_DEFAULT_ALIGN
+ * @return  Pointer to the allocated memory or NULL if no memory can be allocated
+ */
+static inline void *arena_alloc(struct Arena *arena, size_t size, size_t align) {
+  if (align == 0U) {
+    align = ARENA_DEFAULT_ALIGN;
+  }
+
+  u64 ptr = (arena->ptr + align - 1U) & ~((u64)align - 1U);
+
+  if (ptr + size <= arena->end) {
+    arena->ptr = ptr + size;
+    return (void *)ptr;
+  }
+
+  return arena_alloc_slow(arena, size, align);
+}
+
+/**
+ * @brief   Release every allocation made from an arena
+ * @details The first chunk is kept and every other chunk is returned to the buddy allocator as a whole block.
+ *          The cost does not depend on the number of allocations
+ * @param   arena Pointer to the arena
+ */
+void arena_reset(struct Arena *arena);
+
+/**
+ * @brief   Release every allocation and all memory owned by an arena
+ * @param   arena Pointer to the arena, invalid after this call
+ */
+void arena_destroy(struct Arena *arena);
+
+/** @} */
@@ -51,6 +51,34 @@ struct Page *buddy_alloc_pages(u32 order);
  */
 void buddy_free_pages(struct Page *page);
 
+/**
+ * @brief   Allocate pages without an allocation-site record
+ * @details For the slab and direct kmalloc paths, which already charge their own caller. Going through
+ *          buddy_alloc_pages would count the same memory a second time
+ * @param   order Power of two order 2 ^ order
+ * @return  Pointer to the allocated memory page
+ *          NULL if no memory can be allocated
+ */
+struct Page *buddy_alloc_pages_untracked(u32 order);
+
+/**
+ * @brief   Deallocate pages taken with buddy_alloc_pages_untracked
+ * @param   page Pointer to the page information stored in the memory map
+ */
+void buddy_free_pages_untracked(struct Page *page);
+
+/**
+ * @brief   Grow an allocated block in place by absorbing its free upper buddies
+ * @details The block keeps its first page, so any address handed out for it stays valid.
+ *          Fails without side effects if any of the upper buddies are allocated or split
+ * @param   page First page of the allocated block
+ * @param   new_order Order the block should grow to
+ * @return  SUCCESS if the block now spans 2 ^ new_order pages
+ *          ERR_GEN_INVALID_PARAM if new_order is not larger than the current order
+ *          ERR_MEM_OUT_OF_MEMORY if the neighbouring pages are not free
+ */
+ErrorCode buddy_expand_pages(struct Page *page, u32 new_order);
+
 /**
  * @brief   Split the first free block of a given order into 2 buddies
  * @return  SUCCESS if split succesfully
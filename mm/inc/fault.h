@@ -0,0 +1,41 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   fault.h
+ *
+ * @brief  User page fault handler header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/**
+ * @brief   Resolve an instruction or data abort on a user address
+ * @details Called from the exception vectors. Translation faults inside a region are backed on
+ *          demand: reads map the shared zero page, writes allocate a zeroed page. A write to the zero
+ *          page or to a page shared by address_space_clone replaces it with a private copy, unless
+ *          this address space holds the last reference. Pages swapped out to zram are decompressed, and
+ *          access flag faults from the swap clock just mark the page as used again. A user task touching
+ *          an address outside its regions (including the guard gap below the stack) is terminated.
+ *          Runs with IRQs unmasked, unless the faulting kernel code had them masked
+ * @param   far Faulting virtual address (FAR_EL1)
+ * @param   esr Exception syndrome (ESR_EL1)
+ * @return  0 if the access can be retried, non-zero if the fault cannot be handled
+ */
+int do_mem_abort(u64 far, u64 esr);
+
+/** @} */
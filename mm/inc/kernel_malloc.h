@@ -33,6 +33,15 @@
  */
 void *kmalloc(size_t size);
 
+/**
+ * @brief   Allocate cache-line aligned kernel memory
+ * @details Use for hot objects smaller than a cache line that must not share or straddle lines.
+ *          Allocations of SLAB_ALIGN_MIN_SIZE bytes and up are already aligned by kmalloc
+ * @param   size Number of bytes to allocate
+ * @return  Pointer to allocated memory or NULL on failure
+ */
+void *kmalloc_cache_aligned(size_t size);
+
 /**
  * @brief   Free kernel memory
  * @param   ptr Pointer to memory to free
@@ -46,4 +55,15 @@ void kfree(void *ptr);
  */
 void *kzalloc(size_t size);
 
+/**
+ * @brief   Resize kernel memory
+ * @details Slab objects are resized in place while the new size fits their size class. Direct
+ *          allocations grow in place when the neighbouring buddy blocks are free. Otherwise the
+ *          data is copied into a new allocation and the old one is freed
+ * @param   ptr Pointer to memory to resize, NULL behaves like kmalloc
+ * @param   new_size New size in bytes, 0 behaves like kfree
+ * @return  Pointer to the resized memory or NULL on failure (ptr is left untouched)
+ */
+void *krealloc(void *ptr, size_t new_size);
+
 /** @} */
@@ -0,0 +1,92 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   mempool.h
+ *
+ * @brief  Interrupt-safe reserved memory pool header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+#include "spinlock.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/**
+ * @brief   Reserved memory pool
+ * @details Free objects form a lock-free singly linked list. The link is stored in the first 8 bytes
+ *          of each free object
+ */
+struct Mempool {
+  volatile u64 free_list;      /**< Address of the first free object, 0 if empty */
+  volatile u64 available;      /**< Number of objects on the free list */
+  u32 obj_size;                /**< Size of each object */
+  u32 min_reserved;            /**< Number of objects refill tops the pool up to */
+  u32 total;                   /**< Number of objects owned by the pool */
+  struct Spinlock refill_lock; /**< Serializes refill and destroy, never taken in IRQ context */
+};
+
+/**
+ * @brief   Create a pool and fill it with reserved objects
+ * @details Must be called from process context
+ * @param   obj_size Size of each object in bytes
+ * @param   min_reserved Number of objects kept in reserve
+ * @return  Pointer to the pool or NULL if the reserve cannot be allocated
+ */
+struct Mempool *mempool_create(u32 obj_size, u32 min_reserved);
+
+/**
+ * @brief   Take an object from the pool
+ * @details Lock-free and safe in IRQ context. Never calls into the general allocator
+ * @param   pool Pointer to the pool
+ * @return  Pointer to the object or NULL if the reserve is exhausted
+ */
+void *mempool_alloc(struct Mempool *pool);
+
+/**
+ * @brief   Return an object to the pool
+ * @details Lock-free and safe in IRQ context
+ * @param   pool Pointer to the pool
+ * @param   obj Pointer to an object taken from this pool
+ */
+void mempool_free(struct Mempool *pool, void *obj);
+
+/**
+ * @brief   Top the pool back up to its reserve using kmalloc
+ * @details Must be called from process context
+ * @param   pool Pointer to the pool
+ * @return  SUCCESS if at least min_reserved objects are available
+ *          ERR_MEM_OUT_OF_MEMORY if kmalloc failed before the reserve was restored
+ */
+ErrorCode mempool_refill(struct Mempool *pool);
+
+/**
+ * @brief   Check whether the pool has dropped below its reserve
+ * @param   pool Pointer to the pool
+ * @return  TRUE if mempool_refill should be called
+ */
+bool mempool_needs_refill(struct Mempool *pool);
+
+/**
+ * @brief   Free the pool and every object it owns
+ * @details Must be called from process context once every object has been returned
+ * @param   pool Pointer to the pool, invalid after this call
+ */
+void mempool_destroy(struct Mempool *pool);
+
+/** @} */
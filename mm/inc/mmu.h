@@ -0,0 +1,259 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   mmu.h
+ *
+ * @brief  Page table and MMU management header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+#include "sysregs.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/** @brief  Virtual address bits in both translation regions */
+#define VA_BITS 39
+
+/** @brief  Number of descriptors in one translation table */
+#define PTRS_PER_TABLE (1U << TABLE_SHIFT)
+
+/* Translation starts at level 1 with a 39-bit address space */
+#define L1_SHIFT (PAGE_SHIFT + 2 * TABLE_SHIFT)
+#define L2_SHIFT (PAGE_SHIFT + TABLE_SHIFT)
+#define L3_SHIFT PAGE_SHIFT
+#define L1_BLOCK_SIZE (1UL << L1_SHIFT)
+#define L2_BLOCK_SIZE (1UL << L2_SHIFT)
+
+#define L1_INDEX(va) (((va) >> L1_SHIFT) & (PTRS_PER_TABLE - 1U))
+#define L2_INDEX(va) (((va) >> L2_SHIFT) & (PTRS_PER_TABLE - 1U))
+#define L3_INDEX(va) (((va) >> L3_SHIFT) & (PTRS_PER_TABLE - 1U))
+
+/** @brief  Size of a huge page, mapped by a single level 2 block descriptor */
+#define HUGE_PAGE_SIZE L2_BLOCK_SIZE
+/** @brief  Buddy allocator order of a huge page */
+#define HUGE_PAGE_ORDER (L2_SHIFT - PAGE_SHIFT)
+
+/* Descriptor bits */
+#define PTE_VALID (1UL << 0)
+#define PTE_TABLE (1UL << 1) /**< Table descriptor at levels 1 and 2 */
+#define PTE_PAGE (1UL << 1)  /**< Page descriptor at level 3 */
+#define PTE_BLOCK (0UL << 1) /**< Block descriptor at levels 1 and 2 */
+#define PTE_TYPE_MASK (3UL << 0)
+#define PTE_ATTR_INDX(mt) ((u64)(mt) << 2)
+#define PTE_USER (1UL << 6)   /**< AP[1]: accessible from EL0 */
+#define PTE_RDONLY (1UL << 7) /**< AP[2]: read only */
+#define PTE_SH_INNER (3UL << 8)
+#define PTE_AF (1UL << 10) /**< Access flag */
+#define PTE_NG (1UL << 11) /**< Not global: tagged with the current ASID */
+#define PTE_PXN (1UL << 53)
+#define PTE_UXN (1UL << 54)
+#define PTE_ADDR_MASK 0x0000FFFFFFFFF000UL
+
+/* Attribute sets for mappings */
+#define PAGE_KERNEL (PTE_AF | PTE_SH_INNER | PTE_ATTR_INDX(MT_NORMAL) | PTE_UXN | PTE_PXN)
+#define PAGE_KERNEL_EXEC (PTE_AF | PTE_SH_INNER | PTE_ATTR_INDX(MT_NORMAL) | PTE_UXN)
+#define PAGE_KERNEL_NC (PTE_AF | PTE_ATTR_INDX(MT_NORMAL_NC) | PTE_UXN | PTE_PXN)
+#define PAGE_DEVICE (PTE_AF | PTE_ATTR_INDX(MT_DEVICE_nGnRnE) | PTE_UXN | PTE_PXN)
+
+/* User mappings are not global, so their TLB entries are tagged with the address space ASID */
+#define PAGE_USER (PTE_AF | PTE_SH_INNER | PTE_ATTR_INDX(MT_NORMAL) | PTE_USER | PTE_NG | PTE_UXN | PTE_PXN)
+#define PAGE_USER_EXEC (PTE_AF | PTE_SH_INNER | PTE_ATTR_INDX(MT_NORMAL) | PTE_USER | PTE_NG | PTE_RDONLY | PTE_PXN)
+
+/** @brief  Start of the upper (TTBR1) kernel address space */
+#define KERNEL_VA_BASE (~((1UL << VA_BITS) - 1UL))
+
+/** @brief  Physical memory is identity mapped through TTBR0 up to this address */
+#define IDENTITY_MAP_END 0x100000000UL
+/** @brief  Start of the peripheral window within the identity map */
+#define DEVICE_MAP_START 0xFC000000UL
+
+/** @brief  Above this many pages a range flush invalidates the whole TLB instead */
+#define TLB_FLUSH_PAGE_LIMIT 64U
+
+/**
+ * @brief   Build the kernel page tables and enable the MMU and instruction cache
+ * @details Physical memory is identity mapped through TTBR0 so execution continues seamlessly. TTBR1
+ *          holds the kernel upper address space, which starts out empty. The data cache is left off
+ *          until mmu_enable_dcache is called, since the mailbox and DMA drivers do no cache maintenance
+ * @return  SUCCESS if the MMU is enabled
+ */
+ErrorCode mmu_init(void);
+
+/**
+ * @brief   Enable the MMU of a secondary core with the tables built by mmu_init
+ * @details Does nothing if the boot core has not enabled the MMU. The data cache is enabled as well if the boot
+ *          core enabled it first
+ */
+void mmu_init_secondary(void);
+
+/**
+ * @brief   Enable the data cache
+ * @details Buffers shared with the VideoCore or DMA engines must then be mapped PAGE_KERNEL_NC. Only affects the
+ *          calling core and the secondary cores started after it
+ */
+void mmu_enable_dcache(void);
+
+/**
+ * @brief   Get the MMU status
+ * @return  TRUE if mmu_init has enabled translation
+ */
+bool mmu_is_enabled(void);
+
+/**
+ * @brief   Get the data cache status
+ * @return  TRUE once mmu_enable_dcache has been called
+ */
+bool mmu_dcache_enabled(void);
+
+/**
+ * @brief   Get the ASID width selected by mmu_init
+ * @return  16 if the core supports 16-bit ASIDs, otherwise 8
+ */
+u32 mmu_asid_bits(void);
+
+/**
+ * @brief   Get the shared page of zeroes
+ * @details Mapped read-only wherever untouched anonymous memory is read. It is never freed
+ * @return  Physical address of the page
+ */
+u64 mmu_zero_page(void);
+
+/**
+ * @brief   Get the root table of the kernel upper address space (TTBR1)
+ * @return  Pointer to the level 1 table
+ */
+u64 *mmu_kernel_pgd(void);
+
+/**
+ * @brief   Get the root table of the identity map (TTBR0)
+ * @return  Pointer to the level 1 table
+ */
+u64 *mmu_identity_pgd(void);
+
+/**
+ * @brief   Find the level 3 descriptor for a virtual address
+ * @details Callers must serialize updates to the same set of tables
+ * @param   pgd Root (level 1) table
+ * @param   va Virtual address
+ * @param   alloc Allocate missing level 2 and 3 tables from the buddy allocator
+ * @return  Pointer to the descriptor, NULL if a table is missing (and alloc is false) or a block maps the address
+ */
+u64 *mmu_walk(u64 *pgd, u64 va, bool alloc);
+
+/**
+ * @brief   Map one page
+ * @details No TLB maintenance is needed since the previous descriptor was invalid. The caller issues
+ *          a single barrier with mmu_sync_tables after a batch of mappings
+ * @param   pgd Root (level 1) table
+ * @param   va Page aligned virtual address
+ * @param   pa Page aligned physical address
+ * @param   attrs Descriptor attributes (PAGE_KERNEL etc.)
+ * @return  SUCCESS if mapped
+ *          ERR_MEM_OUT_OF_MEMORY if a table could not be allocated
+ *          ERR_MEM_INVALID_ADDR if the address is already mapped
+ */
+ErrorCode mmu_map_page(u64 *pgd, u64 va, u64 pa, u64 attrs);
+
+/**
+ * @brief   Map one huge page with a level 2 block descriptor
+ * @param   pgd Root (level 1) table
+ * @param   va HUGE_PAGE_SIZE aligned virtual address
+ * @param   pa HUGE_PAGE_SIZE aligned physical address
+ * @param   attrs Descriptor attributes (PAGE_KERNEL etc.)
+ * @return  SUCCESS if mapped
+ *          ERR_MEM_OUT_OF_MEMORY if the level 2 table could not be allocated
+ *          ERR_MEM_INVALID_ADDR if the slot already holds a block or a level 3 table
+ */
+ErrorCode mmu_map_block(u64 *pgd, u64 va, u64 pa, u64 attrs);
+
+/**
+ * @brief   Map a physically contiguous range, using huge pages where possible
+ * @details Every 2MB stretch where both addresses are 2MB aligned is mapped with one level 2 block
+ *          descriptor, so it takes a single TLB entry instead of 512. The rest, and any slot that already
+ *          holds a level 3 table, is mapped with pages. The caller issues mmu_sync_tables afterwards
+ * @param   pgd Root (level 1) table
+ * @param   va Page aligned virtual address
+ * @param   pa Page aligned physical address
+ * @param   size Size of the range in bytes, rounded up to whole pages
+ * @param   attrs Descriptor attributes (PAGE_KERNEL etc.)
+ * @return  SUCCESS if the whole range is mapped. On failure nothing is left mapped
+ *          ERR_MEM_OUT_OF_MEMORY if a table could not be allocated
+ *          ERR_MEM_INVALID_ADDR if part of the range is already mapped
+ */
+ErrorCode mmu_map_range(u64 *pgd, u64 va, u64 pa, u64 size, u64 attrs);
+
+/**
+ * @brief   Unmap one page without invalidating the TLB
+ * @details The caller batches invalidation with mmu_flush_tlb_range once a whole range is unmapped
+ * @param   pgd Root (level 1) table
+ * @param   va Page aligned virtual address
+ * @return  Physical address that was mapped, 0 if nothing was mapped
+ */
+u64 mmu_unmap_page(u64 *pgd, u64 va);
+
+/**
+ * @brief   Unmap the page or huge page mapping an address without invalidating the TLB
+ * @param   pgd Root (level 1) table
+ * @param   va Virtual address at the start of the mapping
+ * @param   size Set to the size of the mapping removed, PAGE_SIZE if nothing was mapped
+ * @return  Physical address that was mapped, 0 if nothing was mapped
+ */
+u64 mmu_unmap_entry(u64 *pgd, u64 va, u64 *size);
+
+/**
+ * @brief   Unmap a range made of pages and huge pages and invalidate its TLB entries
+ * @param   pgd Root (level 1) table
+ * @param   va Page aligned virtual address
+ * @param   size Size of the range in bytes
+ */
+void mmu_unmap_range(u64 *pgd, u64 va, u64 size);
+
+/**
+ * @brief   Make new descriptors visible to the table walker
+ */
+void mmu_sync_tables(void);
+
+/**
+ * @brief   Invalidate the TLB entries for a range of virtual addresses on all cores
+ * @details Large ranges fall back to invalidating the whole TLB
+ * @param   va Start of the range
+ * @param   size Size of the range in bytes
+ */
+void mmu_flush_tlb_range(u64 va, u64 size);
+
+/**
+ * @brief   Invalidate the non-global TLB entries of one ASID on all cores
+ * @param   asid ASID to invalidate
+ */
+void mmu_flush_tlb_asid(u64 asid);
+
+/**
+ * @brief   Invalidate all TLB entries on all cores
+ */
+void mmu_flush_tlb_all(void);
+
+/**
+ * @brief   Make instructions written through data accesses visible to instruction fetch
+ * @details Needed after copying code into a page before executing it
+ * @param   addr Start of the written range
+ * @param   size Size of the range in bytes
+ */
+void mmu_sync_icache_range(u64 addr, u64 size);
+
+/** @} */
@@ -31,13 +31,16 @@
  * @details Maintained in a separate array outside the memory pool
  */
 struct Page {
-  struct Page *next; /**< Next free page in buddy list */
-  u32 order;         /**< Order of this page block (2^order pages) */
-  bool is_free;      /**< Whether this page is free */
-  u32 _count;        /**< Reference count */
-  u32 flags;         /**< Page flags */
-  void *freelist;    /**< For slab allocator use */
-  struct Slab *slab; /**< Slab this page belongs to, NULL for buddy allocations */
+  struct Page *next;   /**< Next free page in buddy list */
+  u32 order;           /**< Order of this page block (2^order pages) */
+  bool is_free;        /**< Whether this page is free */
+  volatile u32 _count; /**< Reference count, changed with atomic_add_return_32 once the page is shared */
+  u32 flags;           /**< Page flags */
+  void *freelist;      /**< For slab allocator use */
+  struct Slab *slab;   /**< Slab this page belongs to, NULL for buddy allocations */
+#ifdef ALLOC_PROFILE
+  u32 alloc_site; /**< Allocation-site profiler handle of the owner */
+#endif
 };
 
 /**
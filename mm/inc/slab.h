@@ -32,6 +32,8 @@
 #define MAX_SLAB_SIZE (PAGE_SIZE / 4) /* Maximum slab allocation size */
 #define SLAB_SIZES (MAX_SLAB_SIZE / MIN_SLAB_SIZE)
 #define KMALLOC_MAGIC 0xDEADBEEF /* Magic number for validation */
+#define SLAB_ALIGN_MIN_SIZE CACHE_LINE_SIZE /* Classes this size and up get cache-line aligned objects */
+#define SLAB_COLOUR_SIZE CACHE_LINE_SIZE    /* Step between the colour offsets of consecutive slabs */
 /**
  * @brief   Slab allocator object
  * @details Stored at the beginning of each slab allocation
@@ -41,6 +43,9 @@ struct SlabObject {
   u32 size;                     /**< Actual size of the allocation */
   struct Slab *parent;          /**< Parent slab */
   struct SlabObject *next_free; /**< Next free object in slab */
+#ifdef ALLOC_PROFILE
+  u32 alloc_site; /**< Allocation-site profiler handle of the owner */
+#endif
 };
 
 /**
@@ -54,6 +59,7 @@ struct Slab {
   struct Slab *next;            /**< Next slab with the same object size */
   struct Page *first_page;      /**< First page in this slab */
   u32 pages;                    /**< Number of pages in this slab */
+  u32 colour;                   /**< Byte offset of the first object, cycles through the slack space */
 };
 
 /**
@@ -0,0 +1,85 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   swap.h
+ *
+ * @brief  Swapping of user pages to zram header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+
+/* Intra-component Headers */
+#include "address_space.h"
+#include "page_alloc.h"
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/* A swapped out page leaves an invalid descriptor holding its zram slot. The walker ignores every
+ * bit of an invalid descriptor, so the marker and slot can use them */
+#define SWAP_PTE_MARKER (1UL << 1)
+#define SWAP_PTE(slot) (((u64)(slot) << PAGE_SHIFT) | SWAP_PTE_MARKER)
+#define SWAP_PTE_SLOT(pte) ((u32)((pte) >> PAGE_SHIFT))
+#define IS_SWAP_PTE(pte) (((pte) & (PTE_VALID | SWAP_PTE_MARKER)) == SWAP_PTE_MARKER)
+
+/** @brief  Pages reclaimed at once when an allocation for a user page fails */
+#define SWAP_RECLAIM_BATCH 8U
+
+/**
+ * @brief   Prepare zram while memory is still available
+ * @details Called when the first address space is created
+ * @return  SUCCESS if swapping is possible
+ *          ERR_MEM_OUT_OF_MEMORY if zram could not reserve its pool pages
+ */
+ErrorCode swap_init(void);
+
+/**
+ * @brief   Compress cold user pages into zram
+ * @details A clock hand sweeps the mapped pages of every address space, using the access flag as the
+ *          reference bit. A page with the flag set has it cleared and gets another round; a page still
+ *          clear when the hand comes back is evicted. Pages shared by fork, the zero page and pages that
+ *          do not compress are skipped. Re-entrant calls return immediately
+ * @param   target Number of pages to free
+ * @return  Number of pages freed
+ */
+u32 swap_reclaim(u32 target);
+
+/**
+ * @brief   Allocate a page for user memory, swapping out cold pages if the buddy allocator is empty
+ * @return  Pointer to the page or NULL if nothing could be reclaimed
+ */
+struct Page *swap_alloc_page(void);
+
+/**
+ * @brief   Bring a swapped out page back
+ * @param   as Address space
+ * @param   pte Descriptor holding a swap entry
+ * @param   va Page aligned virtual address
+ * @param   attrs Descriptor attributes from the region
+ * @return  SUCCESS if the page is mapped again
+ *          ERR_MEM_OUT_OF_MEMORY if no page can be allocated
+ *          ERR_GEN_INVALID_PARAM if the zram slot is corrupt
+ */
+ErrorCode swap_in(struct AddressSpace *as, u64 *pte, u64 va, u64 attrs);
+
+/**
+ * @brief   Move the clock hand off an address space that is being destroyed
+ * @details Must be called with the address space list locked
+ * @param   as Address space, still linked into the address space list
+ */
+void swap_forget(struct AddressSpace *as);
+
+/** @} */
@@ -1,17 +1,25 @@
+#pragma once
+
 /*******************************************************************************************************************************
- * @file   virtual_malloc.c
+ * @file   virtual_malloc.h
  *
- * @brief  Virtual memory allocation source file
+ * @brief  Virtual memory allocation header file
  *
  * @date   2024-12-27
  * @author Aryan Kashem
  *******************************************************************************************************************************/
 
 /* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
 
 /* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
 
 /* Intra-component Headers */
+#include "mmu.h"
 
 /**
  * @defgroup MemoryManager OS Memory Manager
@@ -19,4 +27,70 @@
  * @{
  */
 
+/** @brief  Start of the vmalloc area, at the bottom of the kernel upper address space */
+#define VMALLOC_START KERNEL_VA_BASE
+/** @brief  Size of the vmalloc area. One level 1 entry, so a single level 2 table covers it */
+#define VMALLOC_SIZE L1_BLOCK_SIZE
+#define VMALLOC_END (VMALLOC_START + VMALLOC_SIZE)
+
+/**
+ * @brief   Reserved range of the vmalloc area
+ * @details Every area is followed by an unmapped guard page so overruns fault instead of corrupting
+ *          the next allocation
+ */
+struct VmArea {
+  u64 addr;            /**< First mapped virtual address */
+  u64 size;            /**< Reserved size in bytes, including the guard page */
+  bool external;       /**< Maps memory owned elsewhere (vmap), which is not freed with the area */
+  struct VmArea *next; /**< Next area, sorted by address */
+};
+
+/**
+ * @brief   Allocate virtually contiguous memory
+ * @details The memory is built from individual order-0 pages, so it succeeds regardless of
+ *          fragmentation but is not physically contiguous and must not be handed to DMA. The MMU is
+ *          enabled on first use
+ * @param   size Number of bytes to allocate
+ * @return  Pointer to the memory or NULL if no memory or address space can be allocated
+ */
+void *vmalloc(size_t size);
+
+/**
+ * @brief   Allocate virtually contiguous memory backed by huge pages
+ * @details Intended for large buffers that are swept end to end. Each 2MB chunk is taken from the buddy
+ *          allocator as one physically contiguous block and mapped with a single block descriptor. A
+ *          chunk falls back to order-0 pages when no suitably aligned block is free, which is always the case
+ *          with the default 2MB heap. Pass a larger 2MB aligned pool to mm_init to get huge pages
+ * @param   size Number of bytes to allocate, rounded up to a multiple of HUGE_PAGE_SIZE
+ * @return  Pointer to the memory or NULL if no memory or address space can be allocated
+ */
+void *vmalloc_huge(size_t size);
+
+/**
+ * @brief   Map physically contiguous memory owned by someone else into the vmalloc area
+ * @details The virtual address is chosen with the same offset within a huge page as the physical address,
+ *          so everything past the first 2MB boundary is mapped with huge pages. Memory below 4GB is already covered
+ *          by the identity map's 1GB and 2MB blocks, so this only pays off for a mapping with other attributes
+ * @param   pa Physical address of the memory
+ * @param   size Size of the memory in bytes
+ * @param   attrs Descriptor attributes, PAGE_KERNEL_NC for memory shared with the VideoCore
+ * @return  Pointer mapping pa or NULL if no memory or address space can be allocated
+ */
+void *vmap(u64 pa, size_t size, u64 attrs);
+
+/**
+ * @brief   Free memory allocated by vmalloc or vmalloc_huge, or remove a vmap mapping
+ * @details The whole area is unmapped before a single TLB invalidation, after which the pages are
+ *          returned to the buddy allocator. Memory mapped by vmap is left alone
+ * @param   ptr Pointer returned by vmalloc, vmalloc_huge or vmap. NULL is ignored
+ */
+void vfree(void *ptr);
+
+/**
+ * @brief   Check if an address lies in the vmalloc area
+ * @param   ptr Address to check
+ * @return  TRUE if the address belongs to the vmalloc area
+ */
+bool is_vmalloc_addr(void *ptr);
+
 /** @} */
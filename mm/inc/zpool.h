@@ -0,0 +1,107 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   zpool.h
+ *
+ * @brief  Size-class pool for compressed objects header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+#include "spinlock.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/** @brief  Granularity of the size classes */
+#define ZPOOL_CLASS_STEP 64U
+/** @brief  Largest object the pool stores, so every page holds at least two. Bigger objects would save nothing */
+#define ZPOOL_MAX_SIZE (PAGE_SIZE / 2U - ZPOOL_CLASS_STEP)
+/** @brief  Number of size classes */
+#define ZPOOL_NUM_CLASSES (ZPOOL_MAX_SIZE / ZPOOL_CLASS_STEP)
+/** @brief  Marks the end of a page free list */
+#define ZPOOL_NO_OBJECT 0xFFFFU
+
+/**
+ * @brief   Header at the start of every pool page
+ * @details A page only holds objects of one size class. Free objects are chained by index, with the
+ *          link stored in the first 2 bytes of each free object
+ */
+struct ZpoolPage {
+  struct ZpoolPage *next; /**< Next page of the class with free objects */
+  u16 size_class;         /**< Index of the size class */
+  u16 in_use;             /**< Objects handed out */
+  u16 capacity;           /**< Objects that fit in the page */
+  u16 free_head;          /**< Index of the first free object, ZPOOL_NO_OBJECT if full */
+};
+
+/**
+ * @brief   Pool of variable sized objects packed into pages by size class
+ * @details Objects are rounded up to ZPOOL_CLASS_STEP, so a page of 1 KB objects holds three of them
+ *          instead of one per page. A few pages are kept in reserve, since the pool is mostly grown
+ *          while the buddy allocator is out of memory
+ */
+struct Zpool {
+  struct ZpoolPage *partial[ZPOOL_NUM_CLASSES]; /**< Pages with free objects, per size class */
+  struct ZpoolPage *reserve;                    /**< Spare pages, linked through next */
+  u32 reserve_count;                            /**< Pages on the reserve list */
+  u32 reserve_target;                           /**< Pages zpool_refill keeps in reserve */
+  u32 pages;                                    /**< Pages holding objects */
+  struct Spinlock lock;                         /**< Protects the lists and counters */
+};
+
+/**
+ * @brief   Set up an empty pool and fill its reserve
+ * @param   pool Pool storage
+ * @param   reserve_pages Number of pages to keep for growing the pool when the buddy allocator is empty
+ * @return  SUCCESS if the reserve is filled
+ *          ERR_MEM_OUT_OF_MEMORY if the reserve could not be allocated
+ */
+ErrorCode zpool_init(struct Zpool *pool, u32 reserve_pages);
+
+/**
+ * @brief   Allocate an object
+ * @param   pool Pointer to the pool
+ * @param   size Size in bytes, at most ZPOOL_MAX_SIZE
+ * @return  Pointer to the object or NULL if no page can be allocated
+ */
+void *zpool_alloc(struct Zpool *pool, u32 size);
+
+/**
+ * @brief   Free an object
+ * @details The page returns to the buddy allocator once its last object is freed
+ * @param   pool Pointer to the pool
+ * @param   obj Pointer returned by zpool_alloc. NULL is ignored
+ */
+void zpool_free(struct Zpool *pool, void *obj);
+
+/**
+ * @brief   Top the reserve back up from the buddy allocator
+ * @param   pool Pointer to the pool
+ * @return  SUCCESS if the reserve is full
+ *          ERR_MEM_OUT_OF_MEMORY if the buddy allocator ran out first
+ */
+ErrorCode zpool_refill(struct Zpool *pool);
+
+/**
+ * @brief   Read the number of pages holding objects
+ * @param   pool Pointer to the pool
+ * @return  Pages in use, not counting the reserve
+ */
+u32 zpool_pages(struct Zpool *pool);
+
+/** @} */
@@ -0,0 +1,112 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   zram.h
+ *
+ * @brief  Compressed in-memory page store header file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "error.h"
+#include "hardware.h"
+
+/* Intra-component Headers */
+#include "zpool.h"
+
+/**
+ * @defgroup MemoryManager OS Memory Manager
+ * @brief    OS Memory Manager using Buddy Allocator and Slab Allocator
+ * @{
+ */
+
+/** @brief  Number of pages zram can hold, 16 MB worth of memory */
+#define ZRAM_SLOTS 4096U
+/** @brief  Pool pages kept back so pages can be compressed while the buddy allocator is empty */
+#define ZRAM_RESERVE_PAGES 2U
+
+/**
+ * @brief   One stored page
+ * @details Pages made of a single repeated word, zeroes above all, take no pool memory
+ */
+struct ZramSlot {
+  void *obj; /**< LZ4 block in the pool, NULL for a same-filled page */
+  u64 fill;  /**< Repeated word of a same-filled page, index of the next free slot while free */
+  u16 size;  /**< Size of the LZ4 block, 0 for a same-filled page */
+  u16 refs;  /**< Page table entries referring to the slot, 0 while free */
+};
+
+/**
+ * @brief   Usage counters
+ */
+struct ZramStats {
+  u32 stored_pages;     /**< Slots in use */
+  u32 same_filled;      /**< Slots in use that hold a same-filled page */
+  u64 compressed_bytes; /**< Total size of the LZ4 blocks in use */
+  u32 pool_pages;       /**< Pages the pool uses to hold them */
+  u64 stores;           /**< Pages stored since boot */
+  u64 loads;            /**< Pages loaded since boot */
+  u64 rejected;         /**< Pages that did not compress below ZPOOL_MAX_SIZE */
+};
+
+/**
+ * @brief   Set up the slot table and the pool reserve
+ * @details Called by swap_init. Must run while memory is still available
+ * @return  SUCCESS if zram is ready
+ *          ERR_MEM_OUT_OF_MEMORY if the pool reserve could not be allocated
+ */
+ErrorCode zram_init(void);
+
+/**
+ * @brief   Compress a page into a new slot
+ * @param   page Page to store
+ * @param   slot Set to the slot index, which starts with one reference
+ * @return  SUCCESS if the page is stored
+ *          ERR_MEM_OUT_OF_MEMORY if no slot or pool memory is left
+ *          ERR_SYS_NOT_SUPPORTED if the page does not compress well enough to be worth storing
+ */
+ErrorCode zram_store(const void *page, u32 *slot);
+
+/**
+ * @brief   Decompress a slot into a page
+ * @details The slot keeps its references, so the caller drops its own with zram_put afterwards
+ * @param   slot Slot index
+ * @param   page Page to fill
+ * @return  SUCCESS if the page is restored
+ *          ERR_GEN_INVALID_PARAM if the slot is not in use or its data is corrupt
+ */
+ErrorCode zram_load(u32 slot, void *page);
+
+/**
+ * @brief   Add a reference to a slot, for a page table entry copied by fork
+ * @param   slot Slot index
+ */
+void zram_dup(u32 slot);
+
+/**
+ * @brief   Drop a reference to a slot, freeing it with the last one
+ * @param   slot Slot index
+ */
+void zram_put(u32 slot);
+
+/**
+ * @brief   Top the pool reserve back up after memory has been freed
+ * @return  SUCCESS if the reserve is full
+ *          ERR_MEM_OUT_OF_MEMORY if the buddy allocator is still empty
+ */
+ErrorCode zram_refill(void);
+
+/**
+ * @brief   Read the usage counters
+ * @param   stats Filled with a snapshot of the counters
+ */
+void zram_get_stats(struct ZramStats *stats);
+
+/** @} */
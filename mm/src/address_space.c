@@ -0,0 +1,512 @@
+/*******************************************************************************************************************************
+ * @file   address_space.c
+ *
+ * @brief  Per-task address space and ASID management source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "arm64_atomic.h"
+#include "bcm2711_cpu.h"
+#include "irq.h"
+#include "mem_utils.h"
+#include "scheduler.h"
+#include "spinlock.h"
+
+/* Intra-component Headers */
+#include "address_space.h"
+#include "buddy.h"
+#include "kernel_malloc.h"
+#include "swap.h"
+#include "zram.h"
+
+/** @brief  Words in the ASID bitmap, sized for 16-bit ASIDs */
+#define ASID_MAP_WORDS ((1U << 16) / 64U)
+
+static struct Spinlock asid_lock = SPIN_LOCK_INIT;
+
+/* The generation counts up in units of 2 ^ asid_bits, so it never overlaps the ASID itself */
+static u64 asid_generation = 0U;
+static u64 asid_map[ASID_MAP_WORDS];
+static u32 asid_next = 1U;
+
+/* Context ID every core runs with. A rollover zeroes it, so a core racing with the rollover takes the locked path */
+static volatile u64 active_context[NUM_CPUS];
+/* Context IDs that survived the last rollover because a core was still running them */
+static u64 reserved_context[NUM_CPUS];
+
+/* Every live address space, newest first. Guarded by list_lock, which the swap clock holds for a whole sweep */
+static struct Spinlock list_lock = SPIN_LOCK_INIT;
+static struct AddressSpace *address_spaces = NULL;
+
+static u64 asid_mask(void) {
+  return (1UL << mmu_asid_bits()) - 1U;
+}
+
+static bool asid_context_valid(u64 context) {
+  return (context & ~asid_mask()) == asid_generation && asid_generation != 0U;
+}
+
+/**
+ * @brief   Start a new ASID generation
+ * @details Every address space has to allocate a fresh ASID, so the whole TLB is invalidated once
+ *          instead of on every switch. Must be called with asid_lock held
+ */
+static void asid_rollover(void) {
+  asid_generation += asid_mask() + 1U;
+  memset(asid_map, 0, sizeof(asid_map));
+
+  /* ASID 0 stays with the kernel identity map */
+  asid_map[0] = 1U;
+  asid_next = 1U;
+
+  /* The other cores keep running their address spaces through the rollover, so those ASIDs stay taken */
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    u64 context = atomic_xchg(&active_context[cpu], 0U);
+
+    /* A core that has not switched since the previous rollover still runs on its reserved ASID */
+    if (context == 0U) {
+      context = reserved_context[cpu];
+    }
+
+    u64 asid = context & asid_mask();
+    asid_map[asid / 64U] |= 1UL << (asid % 64U);
+    reserved_context[cpu] = context;
+  }
+
+  mmu_flush_tlb_all();
+}
+
+/**
+ * @brief   Allocate an ASID from the current generation
+ * @details Must be called with asid_lock held
+ * @param   old_context Context ID the address space had so far, 0 if none
+ * @return  Context ID (generation | ASID)
+ */
+static u64 asid_new_context(u64 old_context) {
+  u32 num_asids = (u32)asid_mask() + 1U;
+
+  if (asid_generation == 0U) {
+    asid_rollover();
+  }
+
+  /* An address space that was running during the rollover moves its reserved ASID into the new generation */
+  if (old_context != 0U) {
+    u64 updated = asid_generation | (old_context & asid_mask());
+    bool reserved = false;
+
+    for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+      if (reserved_context[cpu] == old_context) {
+        reserved_context[cpu] = updated;
+        reserved = true;
+      }
+    }
+
+    if (reserved) {
+      return updated;
+    }
+  }
+
+  for (u32 pass = 0U; pass < 2U; pass++) {
+    for (u32 word = asid_next / 64U; word < num_asids / 64U; word++) {
+      u64 free_bits = ~asid_map[word];
+      if (free_bits == 0U) {
+        continue;
+      }
+
+      u32 asid = word * 64U + (u32)__builtin_ctzll(free_bits);
+      asid_map[word] |= 1UL << (asid % 64U);
+      asid_next = asid + 1U;
+      return asid_generation | asid;
+    }
+
+    asid_rollover();
+  }
+
+  return 0U;
+}
+
+static u64 *alloc_table(void) {
+  struct Page *page = buddy_alloc_pages(0U);
+  if (!page) {
+    return NULL;
+  }
+
+  u64 *table = page_to_virt(page);
+  memset(table, 0, PAGE_SIZE);
+
+  return table;
+}
+
+static void free_table(u64 *table) {
+  buddy_free_pages(virt_to_page(table));
+}
+
+struct AddressSpace *address_space_create(void) {
+  if (!mmu_is_enabled()) {
+    if (mmu_init() != SUCCESS) {
+      return NULL;
+    }
+  }
+
+  struct AddressSpace *as = kzalloc(sizeof(struct AddressSpace));
+  if (!as) {
+    return NULL;
+  }
+
+  as->pgd = alloc_table();
+  if (!as->pgd) {
+    kfree(as);
+    return NULL;
+  }
+
+  /* Share the kernel identity map */
+  u64 *identity = mmu_identity_pgd();
+  for (u32 i = 0U; i < L1_INDEX(USER_VA_START); i++) {
+    as->pgd[i] = identity[i];
+  }
+
+  /* zram reserves its pool pages now, while memory is still available. Without it nothing is swapped */
+  swap_init();
+
+  address_space_list_lock();
+  as->next = address_spaces;
+  address_spaces = as;
+  address_space_list_unlock();
+
+  return as;
+}
+
+void address_space_destroy(struct AddressSpace *as) {
+  if (!as) {
+    return;
+  }
+
+  /* Waits for a sweep that may be evicting one of its pages. Once unlinked nothing else walks its tables */
+  address_space_list_lock();
+  swap_forget(as);
+
+  struct AddressSpace **pp = &address_spaces;
+  while (*pp && *pp != as) {
+    pp = &(*pp)->next;
+  }
+  if (*pp) {
+    *pp = as->next;
+  }
+  address_space_list_unlock();
+
+  for (u32 i = L1_INDEX(USER_VA_START); i < PTRS_PER_TABLE; i++) {
+    if (!(as->pgd[i] & PTE_VALID)) {
+      continue;
+    }
+
+    u64 *pmd = (u64 *)(as->pgd[i] & PTE_ADDR_MASK);
+    for (u32 j = 0U; j < PTRS_PER_TABLE; j++) {
+      if (!(pmd[j] & PTE_VALID)) {
+        continue;
+      }
+
+      u64 *pte = (u64 *)(pmd[j] & PTE_ADDR_MASK);
+      for (u32 k = 0U; k < PTRS_PER_TABLE; k++) {
+        if (pte[k] & PTE_VALID) {
+          address_space_put_page(pte[k] & PTE_ADDR_MASK);
+        } else if (IS_SWAP_PTE(pte[k])) {
+          zram_put(SWAP_PTE_SLOT(pte[k]));
+        }
+      }
+
+      free_table(pte);
+    }
+
+    free_table(pmd);
+  }
+
+  while (as->regions) {
+    struct VmRegion *region = as->regions;
+    as->regions = region->next;
+    kfree(region);
+  }
+
+  free_table(as->pgd);
+  kfree(as);
+}
+
+/**
+ * @brief   Copy the regions of an address space
+ * @param   dst Address space without regions
+ * @param   src Address space to copy from
+ * @return  SUCCESS if every region was copied
+ *          ERR_MEM_OUT_OF_MEMORY if a region could not be allocated
+ */
+static ErrorCode clone_regions(struct AddressSpace *dst, struct AddressSpace *src) {
+  for (struct VmRegion *region = src->regions; region; region = region->next) {
+    struct VmRegion *copy = address_space_add_region(dst, region->start, region->end, region->flags);
+    if (!copy) {
+      return ERR_MEM_OUT_OF_MEMORY;
+    }
+
+    if (region == src->heap) {
+      dst->heap = copy;
+    }
+  }
+
+  return SUCCESS;
+}
+
+struct AddressSpace *address_space_clone(struct AddressSpace *parent) {
+  struct AddressSpace *child = address_space_create();
+  if (!child) {
+    return NULL;
+  }
+
+  if (clone_regions(child, parent) != SUCCESS) {
+    address_space_destroy(child);
+    return NULL;
+  }
+
+  /* The child is already on the list, so the swap clock could find its half-copied tables too */
+  address_space_lock(parent);
+  address_space_lock(child);
+
+  for (u32 i = L1_INDEX(USER_VA_START); i < PTRS_PER_TABLE; i++) {
+    if (!(parent->pgd[i] & PTE_VALID)) {
+      continue;
+    }
+
+    u64 *pmd = (u64 *)(parent->pgd[i] & PTE_ADDR_MASK);
+    for (u32 j = 0U; j < PTRS_PER_TABLE; j++) {
+      if (!(pmd[j] & PTE_VALID)) {
+        continue;
+      }
+
+      u64 *pte = (u64 *)(pmd[j] & PTE_ADDR_MASK);
+      for (u32 k = 0U; k < PTRS_PER_TABLE; k++) {
+        if (!(pte[k] & PTE_VALID) && !IS_SWAP_PTE(pte[k])) {
+          continue;
+        }
+
+        u64 va = ((u64)i << L1_SHIFT) | ((u64)j << L2_SHIFT) | ((u64)k << L3_SHIFT);
+        u64 *child_pte = mmu_walk(child->pgd, va, true);
+        if (!child_pte) {
+          address_space_flush_tlb(parent);
+          address_space_unlock(child);
+          address_space_unlock(parent);
+          address_space_destroy(child);
+          return NULL;
+        }
+
+        if (IS_SWAP_PTE(pte[k])) {
+          zram_dup(SWAP_PTE_SLOT(pte[k]));
+          *child_pte = pte[k];
+          continue;
+        }
+
+        u64 pa = pte[k] & PTE_ADDR_MASK;
+        if (pa != mmu_zero_page()) {
+          atomic_add_return_32(&virt_to_page((void *)pa)->_count, 1U);
+        }
+
+        pte[k] |= PTE_RDONLY;
+        *child_pte = pte[k];
+      }
+    }
+  }
+
+  mmu_sync_tables();
+
+  /* The parent may still hold writable entries for the pages that just became read-only */
+  address_space_flush_tlb(parent);
+  child->rss_pages = parent->rss_pages;
+  child->swap_pages = parent->swap_pages;
+
+  address_space_unlock(child);
+  address_space_unlock(parent);
+
+  return child;
+}
+
+struct AddressSpace *address_space_next(struct AddressSpace *as) {
+  return as ? as->next : address_spaces;
+}
+
+void address_space_list_lock(void) {
+  preempt_disable();
+  spin_lock(&list_lock);
+}
+
+void address_space_list_unlock(void) {
+  spin_unlock(&list_lock);
+  preempt_enable();
+}
+
+void address_space_lock(struct AddressSpace *as) {
+  preempt_disable();
+  spin_lock(&as->lock);
+}
+
+void address_space_unlock(struct AddressSpace *as) {
+  spin_unlock(&as->lock);
+  preempt_enable();
+}
+
+void address_space_put_page(u64 pa) {
+  if (pa == mmu_zero_page()) {
+    return;
+  }
+
+  /* Two address spaces can drop their references to a page shared by fork at once */
+  struct Page *page = virt_to_page((void *)pa);
+  if (atomic_add_return_32(&page->_count, -1U) > 0U) {
+    return;
+  }
+
+  buddy_free_pages(page);
+}
+
+void address_space_flush_tlb(struct AddressSpace *as) {
+  if (asid_context_valid(as->context_id)) {
+    mmu_flush_tlb_asid(as->context_id & asid_mask());
+  }
+}
+
+void *address_space_alloc_page(struct AddressSpace *as, u64 va, u64 attrs) {
+  if (va < USER_VA_START || va >= USER_VA_END) {
+    return NULL;
+  }
+
+  struct Page *page = swap_alloc_page();
+  if (!page) {
+    return NULL;
+  }
+
+  void *addr = page_to_virt(page);
+  memset(addr, 0, PAGE_SIZE);
+
+  address_space_lock(as);
+
+  if (mmu_map_page(as->pgd, va, (u64)addr, attrs) != SUCCESS) {
+    address_space_unlock(as);
+    buddy_free_pages(page);
+    return NULL;
+  }
+
+  mmu_sync_tables();
+  as->rss_pages++;
+
+  address_space_unlock(as);
+
+  return addr;
+}
+
+struct VmRegion *address_space_add_region(struct AddressSpace *as, u64 start, u64 end, u32 flags) {
+  if (start > end || start < USER_VA_START || end > USER_VA_END) {
+    return NULL;
+  }
+
+  struct VmRegion **pp = &as->regions;
+  while (*pp && (*pp)->end <= start) {
+    pp = &(*pp)->next;
+  }
+
+  if (*pp && (*pp)->start < end) {
+    return NULL;
+  }
+
+  struct VmRegion *region = kmalloc(sizeof(struct VmRegion));
+  if (!region) {
+    return NULL;
+  }
+
+  region->start = start;
+  region->end = end;
+  region->flags = flags;
+  region->next = *pp;
+  *pp = region;
+
+  return region;
+}
+
+struct VmRegion *address_space_find_region(struct AddressSpace *as, u64 va) {
+  for (struct VmRegion *region = as->regions; region; region = region->next) {
+    if (va < region->start) {
+      break;
+    }
+
+    if (va < region->end) {
+      return region;
+    }
+  }
+
+  return NULL;
+}
+
+u64 address_space_brk(struct AddressSpace *as, u64 increment) {
+  struct VmRegion *heap = as->heap;
+  if (!heap) {
+    return 0U;
+  }
+
+  u64 old_end = heap->end;
+  u64 new_end = (old_end + increment + PAGE_SIZE - 1U) & ~((u64)PAGE_SIZE - 1U);
+  /* Keep the guard gap below the next region (the stack) */
+  u64 limit = heap->next ? heap->next->start - USER_STACK_GUARD_SIZE : USER_VA_END;
+
+  if (new_end < old_end || new_end > limit) {
+    return 0U;
+  }
+
+  heap->end = new_end;
+
+  return old_end;
+}
+
+u64 address_space_region_attrs(struct VmRegion *region) {
+  if (region->flags & VM_EXEC) {
+    return PAGE_USER_EXEC;
+  }
+
+  if (region->flags & VM_WRITE) {
+    return PAGE_USER;
+  }
+
+  return PAGE_USER | PTE_RDONLY;
+}
+
+void address_space_switch(struct AddressSpace *as) {
+  if (!as) {
+    return;
+  }
+
+  u64 flags = irq_save_flags();
+  u32 cpu = get_cpu_id();
+  u64 context = as->context_id;
+  u64 active = active_context[cpu];
+
+  /* Fast path: the ASID is still valid and no rollover cleared this core's context, no lock and no TLB
+   * maintenance. Publishing the context with a cmpxchg makes a concurrent rollover either see and reserve it,
+   * or zero it first and send this core down the locked path */
+  if (active == 0U || !asid_context_valid(context) ||
+      atomic_cmpxchg(&active_context[cpu], active, context) != active) {
+    spin_lock(&asid_lock);
+    context = as->context_id;
+    if (!asid_context_valid(context)) {
+      context = asid_new_context(context);
+      as->context_id = context;
+    }
+    active_context[cpu] = context;
+    spin_unlock(&asid_lock);
+  }
+
+  u64 ttbr = (u64)as->pgd | ((context & asid_mask()) << TTBR_ASID_SHIFT);
+  asm volatile("msr ttbr0_el1, %0; isb" ::"r"(ttbr) : "memory");
+
+  irq_restore_flags(flags);
+}
+
+void address_space_switch_kernel(void) {
+  asm volatile("msr ttbr0_el1, %0; isb" ::"r"((u64)mmu_identity_pgd()) : "memory");
+}
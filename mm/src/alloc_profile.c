@@ -0,0 +1,152 @@
+/*******************************************************************************************************************************
+ * @file   alloc_profile.c
+ *
+ * @brief  Allocation-site profiler source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "log.h"
+#include "spinlock.h"
+
+/* Intra-component Headers */
+#include "alloc_profile.h"
+
+#ifdef ALLOC_PROFILE
+
+static struct Spinlock profile_lock = SPIN_LOCK_INIT;
+
+/* Open addressing table keyed by caller. Slot 0 collects every site once the table is full */
+static struct AllocSite sites[ALLOC_PROFILE_SITES];
+
+/**
+ * @brief   Find or claim the table slot for a call site
+ * @details Must be called with profile_lock held
+ * @param   caller Return address of the allocator call
+ * @return  Slot index, 0 if the table is full
+ */
+static u32 find_site(u64 caller) {
+  u32 slot = ((caller >> 2U) % (ALLOC_PROFILE_SITES - 1U)) + 1U;
+
+  for (u32 probes = 0U; probes < ALLOC_PROFILE_SITES - 1U; probes++) {
+    if (sites[slot].caller == caller) {
+      return slot;
+    }
+
+    if (sites[slot].caller == 0U) {
+      sites[slot].caller = caller;
+      return slot;
+    }
+
+    slot = (slot % (ALLOC_PROFILE_SITES - 1U)) + 1U;
+  }
+
+  return 0U;
+}
+
+u32 alloc_profile_record_alloc(u64 caller, u64 bytes, u64 cycles) {
+  spin_lock(&profile_lock);
+
+  u32 slot = find_site(caller);
+  struct AllocSite *site = &sites[slot];
+
+  site->allocs++;
+  site->cycles += cycles;
+  site->live_bytes += bytes;
+  site->peak_bytes = max(site->peak_bytes, site->live_bytes);
+
+  spin_unlock(&profile_lock);
+
+  return slot;
+}
+
+void alloc_profile_record_free(u32 owner, u64 caller, u64 bytes, u64 cycles) {
+  spin_lock(&profile_lock);
+
+  if (owner < ALLOC_PROFILE_SITES) {
+    struct AllocSite *owner_site = &sites[owner];
+    owner_site->live_bytes -= min(owner_site->live_bytes, bytes);
+  }
+
+  struct AllocSite *site = &sites[find_site(caller)];
+  site->frees++;
+  site->cycles += cycles;
+
+  spin_unlock(&profile_lock);
+}
+
+static u64 sort_value(struct AllocSite *site, AllocProfileSort sort) {
+  switch (sort) {
+    case ALLOC_PROFILE_SORT_LIVE_BYTES:
+      return site->live_bytes;
+    case ALLOC_PROFILE_SORT_PEAK_BYTES:
+      return site->peak_bytes;
+    case ALLOC_PROFILE_SORT_ALLOCS:
+      return site->allocs;
+    case ALLOC_PROFILE_SORT_CYCLES:
+    default:
+      return site->cycles;
+  }
+}
+
+void alloc_profile_report(AllocProfileSort sort) {
+  /* Take a snapshot so the UART output is not produced with the lock held */
+  static struct AllocSite snapshot[ALLOC_PROFILE_SITES];
+  static u16 order[ALLOC_PROFILE_SITES];
+  u32 count = 0U;
+
+  spin_lock(&profile_lock);
+
+  for (u32 i = 0U; i < ALLOC_PROFILE_SITES; i++) {
+    if (sites[i].allocs == 0U && sites[i].frees == 0U) {
+      continue;
+    }
+
+    snapshot[count] = sites[i];
+
+    /* Insertion sort, descending by the requested column */
+    u32 j = count;
+    while (j > 0U && sort_value(&snapshot[order[j - 1U]], sort) < sort_value(&snapshot[count], sort)) {
+      order[j] = order[j - 1U];
+      j--;
+    }
+    order[j] = count;
+    count++;
+  }
+
+  spin_unlock(&profile_lock);
+
+  log("\n\r===== ALLOCATION SITE PROFILE (%d sites) =====\n\r", count);
+  log("caller  allocs  frees  live  peak  cycles  cyc/op\n\r");
+
+  for (u32 i = 0U; i < count; i++) {
+    struct AllocSite *site = &snapshot[order[i]];
+    u64 ops = site->allocs + site->frees;
+
+    if (site->caller == 0U) {
+      log("(overflow)          ");
+    } else {
+      log("0x%lx  ", site->caller);
+    }
+
+    log("%ld  %ld  %ld  %ld  %ld  %ld\n\r", site->allocs, site->frees, site->live_bytes, site->peak_bytes, site->cycles,
+        ops ? (site->cycles / ops) : 0U);
+  }
+}
+
+void alloc_profile_reset(void) {
+  spin_lock(&profile_lock);
+
+  /* Keep the callers so handles stored in live allocations still name the same site */
+  for (u32 i = 0U; i < ALLOC_PROFILE_SITES; i++) {
+    sites[i] = (struct AllocSite){ .caller = sites[i].caller };
+  }
+
+  spin_unlock(&profile_lock);
+}
+
+#endif
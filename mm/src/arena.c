@@ -0,0 +1,140 @@
+/*******************************************************************************************************************************
+ * @file   arena.c
+ *
+ * @brief  Region (arena) allocator source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+
+/* Intra-component Headers */
+#include "arena.h"
+
+/**
+ * @brief   Smallest buddy order that holds a number of bytes
+ * @param   bytes Number of bytes
+ * @return  Buddy order, or MAX_ORDER + 1 if the request is too large
+ */
+static u32 order_for_bytes(u64 bytes) {
+  u32 order = 0U;
+
+  while (((u64)PAGE_SIZE << order) < bytes) {
+    order++;
+    if (order > MAX_ORDER) {
+      break;
+    }
+  }
+
+  return order;
+}
+
+/**
+ * @brief   Allocate a chunk and initialize its header
+ * @param   order Buddy order of the chunk
+ * @return  Pointer to the chunk or NULL if no memory can be allocated
+ */
+static struct ArenaChunk *alloc_chunk(u32 order) {
+  if (order > MAX_ORDER) {
+    return NULL;
+  }
+
+  struct Page *page = buddy_alloc_pages(order);
+  if (!page) {
+    return NULL;
+  }
+
+  struct ArenaChunk *chunk = page_to_virt(page);
+  chunk->next = NULL;
+  chunk->page = page;
+
+  return chunk;
+}
+
+static u64 chunk_end(struct ArenaChunk *chunk) {
+  return (u64)chunk + ((u64)PAGE_SIZE << chunk->page->order);
+}
+
+struct Arena *arena_create(size_t initial_size) {
+  u64 header_size = sizeof(struct ArenaChunk) + sizeof(struct Arena);
+  u32 order = order_for_bytes(header_size + initial_size);
+
+  struct ArenaChunk *chunk = alloc_chunk(order);
+  if (!chunk) {
+    return NULL;
+  }
+
+  struct Arena *arena = (struct Arena *)((u64)chunk + sizeof(struct ArenaChunk));
+  arena->head = chunk;
+  arena->current = chunk;
+  arena->reset_ptr = (u64)chunk + header_size;
+  arena->ptr = arena->reset_ptr;
+  arena->end = chunk_end(chunk);
+  arena->next_order = min(order + 1U, ARENA_MAX_CHUNK_ORDER);
+
+  return arena;
+}
+
+void *arena_alloc_slow(struct Arena *arena, size_t size, size_t align) {
+  if (!arena || (align & (align - 1U)) != 0U) {
+    return NULL;
+  }
+
+  /* Oversized requests get a chunk of their own without disturbing the growth sequence */
+  u64 needed = sizeof(struct ArenaChunk) + align + size;
+  u32 fit_order = order_for_bytes(needed);
+  bool oversized = fit_order > arena->next_order;
+  u32 order = max(arena->next_order, fit_order);
+
+  struct ArenaChunk *chunk = alloc_chunk(order);
+  if (!chunk) {
+    return NULL;
+  }
+
+  chunk->next = arena->current->next;
+  arena->current->next = chunk;
+  arena->current = chunk;
+  arena->end = chunk_end(chunk);
+
+  if (!oversized && arena->next_order < ARENA_MAX_CHUNK_ORDER) {
+    arena->next_order++;
+  }
+
+  u64 ptr = ((u64)chunk + sizeof(struct ArenaChunk) + align - 1U) & ~((u64)align - 1U);
+  arena->ptr = ptr + size;
+
+  return (void *)ptr;
+}
+
+void arena_reset(struct Arena *arena) {
+  if (!arena) {
+    return;
+  }
+
+  struct ArenaChunk *chunk = arena->head->next;
+  while (chunk) {
+    struct ArenaChunk *next = chunk->next;
+    buddy_free_pages(chunk->page);
+    chunk = next;
+  }
+
+  arena->head->next = NULL;
+  arena->current = arena->head;
+  arena->ptr = arena->reset_ptr;
+  arena->end = chunk_end(arena->head);
+  arena->next_order = min(arena->head->page->order + 1U, ARENA_MAX_CHUNK_ORDER);
+}
+
+void arena_destroy(struct Arena *arena) {
+  if (!arena) {
+    return;
+  }
+
+  arena_reset(arena);
+
+  /* The arena object lives in the head chunk, so this must be last */
+  buddy_free_pages(arena->head->page);
+}
@@ -13,6 +13,7 @@
 #include "spinlock.h"
 
 /* Intra-component Headers */
+#include "alloc_profile.h"
 #include "buddy.h"
 
 static struct Spinlock buddy_alloc_lock = SPIN_LOCK_INIT;
@@ -59,9 +60,10 @@ ErrorCode buddy_init(void) {
   u32 pages_left = num_pages - pages_reserved;
   u32 start_pfn = pages_reserved;
 
+  /* Blocks are aligned to their size, otherwise get_buddy_page pairs a block with the wrong buddy */
   while (pages_left > 0) {
     u32 order = MAX_ORDER;
-    while ((1U << order) > pages_left && order > 0) {
+    while (((1U << order) > pages_left || (start_pfn & ((1U << order) - 1U)) != 0U) && order > 0) {
       order--;
     }
 
@@ -82,7 +84,7 @@ ErrorCode buddy_init(void) {
   return SUCCESS;
 }
 
-struct Page *buddy_alloc_pages(u32 order) {
+static struct Page *alloc_pages_internal(u32 order) {
   if (!buddy_initialized) {
     if (buddy_init() != SUCCESS) {
       return NULL;
@@ -112,7 +114,7 @@ struct Page *buddy_alloc_pages(u32 order) {
       if (buddy_split_block(i) == SUCCESS) {
         /* Try again with the newly split blocks */
         spin_unlock(&buddy_alloc_lock);
-        return buddy_alloc_pages(order);
+        return alloc_pages_internal(order);
       }
     }
   }
@@ -122,44 +124,138 @@ struct Page *buddy_alloc_pages(u32 order) {
   return NULL;
 }
 
+/**
+ * @brief   Unlink a block from the free list of the given order
+ * @details Must be called with buddy_alloc_lock held
+ * @param   page First page of the block
+ * @param   order Order of the free list to search
+ * @return  true if the block was found and removed, false otherwise
+ */
+static bool remove_from_free_list(struct Page *page, u32 order) {
+  struct Page **pp = &free_lists[order];
+  while (*pp && *pp != page) {
+    pp = &(*pp)->next;
+  }
+
+  if (*pp == NULL) {
+    return false;
+  }
+
+  *pp = page->next;
+  page->next = NULL;
+  return true;
+}
+
+struct Page *buddy_alloc_pages(u32 order) {
+  ALLOC_PROFILE_BEGIN();
+
+  struct Page *page = alloc_pages_internal(order);
+
+#ifdef ALLOC_PROFILE
+  if (page) {
+    page->alloc_site = alloc_profile_record_alloc(ALLOC_PROFILE_CALLER(), (u64)PAGE_SIZE << order, ALLOC_PROFILE_ELAPSED());
+  }
+#endif
+
+  return page;
+}
+
+struct Page *buddy_alloc_pages_untracked(u32 order) {
+  return alloc_pages_internal(order);
+}
+
 void buddy_free_pages(struct Page *page) {
-  if (!page || !page->is_free) {
-    if (page) {
-      page->is_free = true;
-    } else {
-      return;
-    }
+  ALLOC_PROFILE_BEGIN();
+
+  if (!page) {
+    return;
   }
 
-  u32 order = page->order;
-  struct Page *buddy = get_buddy_page(page, order);
+#ifdef ALLOC_PROFILE
+  u32 owner = page->alloc_site;
+  u64 bytes = (u64)PAGE_SIZE << page->order;
+#endif
+
+  buddy_free_pages_untracked(page);
+
+#ifdef ALLOC_PROFILE
+  alloc_profile_record_free(owner, ALLOC_PROFILE_CALLER(), bytes, ALLOC_PROFILE_ELAPSED());
+#endif
+}
+
+void buddy_free_pages_untracked(struct Page *page) {
+  if (!page) {
+    return;
+  }
 
   spin_lock(&buddy_alloc_lock);
 
-  while (buddy && buddy->is_free && buddy->order == order) {
-    /* Remove buddy from free list */
-    struct Page **pp = &free_lists[order];
-    while (*pp && *pp != buddy) {
-      pp = &(*pp)->next;
-    }
-    if (*pp) {
-      *pp = buddy->next;
+  page->is_free = true;
+  u32 order = page->order;
+
+  while (order < MAX_ORDER) {
+    struct Page *buddy = get_buddy_page(page, order);
+
+    /* The buddy must be the head of a free block of the same order */
+    if (!buddy || !buddy->is_free || buddy->order != order || !remove_from_free_list(buddy, order)) {
+      break;
     }
 
     /* Determine which page is the lower address */
     page = (page < buddy) ? page : buddy;
-    page->order = order + 1;
-
-    buddy = get_buddy_page(page, page->order);
+    order++;
+    page->order = order;
   }
 
-  /* Add the page back to the free list if no merging happens */
+  /* Add the merged block back to the free list of its final order */
   page->next = free_lists[order];
   free_lists[order] = page;
 
   spin_unlock(&buddy_alloc_lock);
 }
 
+ErrorCode buddy_expand_pages(struct Page *page, u32 new_order) {
+  if (!page || new_order > MAX_ORDER || new_order <= page->order) {
+    return ERR_GEN_INVALID_PARAM;
+  }
+
+  u32 pfn = page - get_mem_map();
+
+  /* A block can only grow upwards, so it must already sit at the start of the larger block */
+  if ((pfn & ((1U << new_order) - 1U)) != 0U || (pfn + (1U << new_order)) > get_num_pages()) {
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  spin_lock(&buddy_alloc_lock);
+
+  /* Every upper buddy must be a whole free block before any of them are claimed */
+  for (u32 order = page->order; order < new_order; order++) {
+    struct Page *buddy = &get_mem_map()[pfn + (1U << order)];
+    struct Page *it = free_lists[order];
+
+    while (it && it != buddy) {
+      it = it->next;
+    }
+
+    if (it == NULL || !buddy->is_free || buddy->order != order) {
+      spin_unlock(&buddy_alloc_lock);
+      return ERR_MEM_OUT_OF_MEMORY;
+    }
+  }
+
+  for (u32 order = page->order; order < new_order; order++) {
+    struct Page *buddy = &get_mem_map()[pfn + (1U << order)];
+    remove_from_free_list(buddy, order);
+    buddy->is_free = false;
+  }
+
+  page->order = new_order;
+
+  spin_unlock(&buddy_alloc_lock);
+
+  return SUCCESS;
+}
+
 ErrorCode buddy_split_block(u32 order) {
   if (order == 0 || order > MAX_ORDER) {
     return ERR_GEN_INVALID_PARAM;
@@ -176,17 +272,19 @@ ErrorCode buddy_split_block(u32 order) {
   u32 lower_order = order - 1U;
   u32 pfn = block - get_mem_map();
 
-  /* First half becomes a block of the lower order */
-  block->order = lower_order;
-  block->next = free_lists[lower_order];
-  free_lists[lower_order] = block;
-
-  /* Second half becomes another block of the lower order */
+  /* Second half becomes a block of the lower order */
   struct Page *buddy = &get_mem_map()[pfn + (1 << lower_order)];
   buddy->order = lower_order;
   buddy->is_free = true;
   buddy->next = free_lists[lower_order];
   free_lists[lower_order] = buddy;
 
+  /* First half becomes another block of the lower order. It is pushed last so it is handed out
+   * first, leaving the upper buddy free for in-place growth */
+  block->order = lower_order;
+  block->is_free = true;
+  block->next = free_lists[lower_order];
+  free_lists[lower_order] = block;
+
   return SUCCESS;
 }
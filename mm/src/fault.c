@@ -0,0 +1,159 @@
+/*******************************************************************************************************************************
+ * @file   fault.c
+ *
+ * @brief  User page fault handler source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "log.h"
+#include "mem_utils.h"
+#include "scheduler.h"
+#include "sysregs.h"
+
+/* Intra-component Headers */
+#include "address_space.h"
+#include "buddy.h"
+#include "fault.h"
+#include "swap.h"
+
+/**
+ * @brief   Back a faulting page with a private page
+ * @param   as Address space
+ * @param   pte Descriptor of the page
+ * @param   entry Value of the descriptor when the fault was taken, invalid or mapping a shared read-only page
+ * @param   va Page aligned virtual address
+ * @param   attrs Descriptor attributes from the region
+ * @return  SUCCESS if the page is mapped, or the descriptor changed and the access has to be retried
+ *          ERR_MEM_OUT_OF_MEMORY if no page can be allocated
+ */
+static ErrorCode map_private_page(struct AddressSpace *as, u64 *pte, u64 entry, u64 va, u64 attrs) {
+  /* Allocated before taking the lock, which reclaim needs as well */
+  struct Page *page = swap_alloc_page();
+  if (!page) {
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  address_space_lock(as);
+
+  /* The swap clock got to the page in the meantime, the next attempt sees what it left */
+  if (*pte != entry) {
+    address_space_unlock(as);
+    buddy_free_pages(page);
+    return SUCCESS;
+  }
+
+  void *addr = page_to_virt(page);
+  u64 old_pa = entry & PTE_ADDR_MASK;
+  bool was_valid = (entry & PTE_VALID) != 0U;
+
+  /* Copy on write. The zero page is copied too, which is the same as clearing the new page */
+  if (was_valid) {
+    memcpy(addr, (void *)old_pa, PAGE_SIZE);
+  } else {
+    memset(addr, 0, PAGE_SIZE);
+  }
+
+  /* A copy that can be executed must reach the instruction cache before any thread can jump to it */
+  if (!(attrs & PTE_UXN)) {
+    mmu_sync_icache_range((u64)addr, PAGE_SIZE);
+  }
+
+  /* Break before make: the old read-only entry must be gone from the TLB first */
+  if (was_valid) {
+    *pte = 0U;
+    mmu_flush_tlb_range(va, PAGE_SIZE);
+    address_space_put_page(old_pa);
+  }
+
+  *pte = (u64)addr | attrs | PTE_PAGE | PTE_VALID;
+  mmu_sync_tables();
+
+  if (!was_valid || old_pa == mmu_zero_page()) {
+    as->rss_pages++;
+  }
+
+  address_space_unlock(as);
+
+  return SUCCESS;
+}
+
+int do_mem_abort(u64 far, u64 esr) {
+  struct AddressSpace *as = current ? current->mm : NULL;
+  u32 ec = esr >> ESR_EL1_EC_SHIFT;
+  bool from_user = (ec != ESR_EL1_EC_DABT_CUR);
+  bool write = (ec != ESR_EL1_EC_IABT_LOW) && (esr & ESR_EL1_WNR);
+  u32 fault_type = esr & ESR_EL1_FSC_TYPE_MASK;
+  u64 va = far & ~((u64)PAGE_SIZE - 1U);
+
+  struct VmRegion *region = as ? address_space_find_region(as, far) : NULL;
+
+  if (region && (!write || (region->flags & VM_WRITE))) {
+    u64 attrs = address_space_region_attrs(region);
+    address_space_lock(as);
+    u64 *pte = mmu_walk(as->pgd, va, true);
+    u64 entry = pte ? *pte : 0U;
+    bool handled = false;
+
+    /* Faults that need no new page are fixed up under the lock. The others allocate first, which may run the swap
+     * clock, so they take the lock again afterwards and check the entry did not change */
+    if (pte && fault_type == ESR_EL1_FSC_TRANSLATION && entry == 0U && !write && !(region->flags & VM_EXEC)) {
+      /* Reads of untouched memory share the zero page until the first write */
+      *pte = mmu_zero_page() | (PAGE_USER | PTE_RDONLY) | PTE_PAGE | PTE_VALID;
+      mmu_sync_tables();
+      handled = true;
+    } else if (pte && fault_type == ESR_EL1_FSC_TRANSLATION && (entry & PTE_VALID)) {
+      /* A page the swap clock failed to compress is mapped again, the access only has to be retried */
+      handled = true;
+    } else if (pte && fault_type == ESR_EL1_FSC_ACCESS && (entry & PTE_VALID)) {
+      /* The swap clock cleared the access flag to see if the page is still in use */
+      *pte |= PTE_AF;
+      mmu_sync_tables();
+      handled = true;
+    } else if (pte && fault_type == ESR_EL1_FSC_PERMISSION && write && (entry & PTE_VALID)) {
+      u64 pa = entry & PTE_ADDR_MASK;
+
+      /* The last owner of a shared page takes it back without copying. The count cannot grow while the lock is
+       * held, since only fork of this address space adds references */
+      if (pa != mmu_zero_page() && virt_to_page((void *)pa)->_count == 1U) {
+        *pte &= ~PTE_RDONLY;
+        mmu_flush_tlb_range(va, PAGE_SIZE);
+        handled = true;
+      }
+    }
+
+    address_space_unlock(as);
+
+    if (handled) {
+      return 0;
+    }
+
+    /* Whatever the fault was, a page swapped out in the meantime is brought back and the access retried */
+    if (pte && IS_SWAP_PTE(entry)) {
+      if (swap_in(as, pte, va, attrs) == SUCCESS) {
+        return 0;
+      }
+    } else if (pte && fault_type == ESR_EL1_FSC_TRANSLATION && !(entry & PTE_VALID)) {
+      if (map_private_page(as, pte, entry, va, attrs) == SUCCESS) {
+        return 0;
+      }
+    } else if (pte && fault_type == ESR_EL1_FSC_PERMISSION && write && (entry & PTE_VALID)) {
+      if (map_private_page(as, pte, entry, va, attrs) == SUCCESS) {
+        return 0;
+      }
+    }
+  }
+
+  if (!from_user) {
+    return -1;
+  }
+
+  log("Segmentation fault: task %lx, address 0x%lx, ESR 0x%lx\n\r", (u64)current, far, esr);
+  task_exit(-1);
+
+  return -1;
+}
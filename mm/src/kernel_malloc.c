@@ -14,6 +14,7 @@
 #include "spinlock.h"
 
 /* Intra-component Headers */
+#include "alloc_profile.h"
 #include "kernel_malloc.h"
 #include "slab.h"
 
@@ -25,6 +26,9 @@ struct DirectHeader {
   u32 magic; /**< Magic number for validation */
   u32 size;  /**< Size of the allocation */
   u32 order; /**< Order of the buddy allocation */
+#ifdef ALLOC_PROFILE
+  u32 alloc_site; /**< Allocation-site profiler handle of the owner */
+#endif
 };
 
 /* Structure to manage direct allocation mappings */
@@ -124,7 +128,7 @@ static void *direct_alloc(size_t size) {
   }
 
   /* Allocate pages */
-  struct Page *page = buddy_alloc_pages(order);
+  struct Page *page = buddy_alloc_pages_untracked(order);
   if (!page) {
     return NULL;
   }
@@ -132,7 +136,7 @@ static void *direct_alloc(size_t size) {
   /* Allocate a header in the header pool */
   struct DirectHeader *header = alloc_header(sizeof(struct DirectHeader));
   if (!header) {
-    buddy_free_pages(page);
+    buddy_free_pages_untracked(page);
     return NULL;
   }
 
@@ -161,12 +165,42 @@ static void direct_free(void *ptr) {
   }
 
   /* Free the pages */
-  buddy_free_pages(map->page);
+  buddy_free_pages_untracked(map->page);
 
   /* Remove from hash table */
   remove_direct_alloc(ptr);
 }
 
+/**
+ * @brief   Resize a direct allocation without moving it
+ * @details Shrinking keeps the existing pages. Growing absorbs the free upper buddies of the block
+ * @param   map Direct allocation map entry
+ * @param   new_size Requested size in bytes
+ * @return  true if the allocation now holds new_size bytes in place, false if it must be moved
+ */
+static bool direct_resize(struct DirectAllocMap *map, size_t new_size) {
+  u32 pages_needed = (new_size + PAGE_SIZE - 1) / PAGE_SIZE;
+
+  u32 order = 0;
+  while ((1U << order) < pages_needed && order < MAX_ORDER) {
+    order++;
+  }
+
+  if ((1U << order) < pages_needed) {
+    return false;
+  }
+
+  if (order > map->hdr->order) {
+    if (buddy_expand_pages(map->page, order) != SUCCESS) {
+      return false;
+    }
+    map->hdr->order = order;
+  }
+
+  map->hdr->size = new_size;
+  return true;
+}
+
 static ErrorCode kmalloc_init(void) {
   if (kmalloc_initialized) {
     return SUCCESS;
@@ -185,7 +219,50 @@ static ErrorCode kmalloc_init(void) {
   return SUCCESS;
 }
 
-void *kmalloc(size_t size) {
+#ifdef ALLOC_PROFILE
+/**
+ * @brief   Locate the profiler handle and usable size of a live allocation
+ * @param   ptr Pointer returned by the allocator
+ * @param   bytes Filled with the usable size of the allocation
+ * @return  Pointer to the profiler handle stored with the allocation
+ */
+static u32 *profile_handle(void *ptr, u64 *bytes) {
+  spin_lock(&kmalloc_lock);
+
+  u32 *handle;
+  struct DirectAllocMap *map = find_direct_alloc(ptr);
+  if (map) {
+    *bytes = map->hdr->size;
+    handle = &map->hdr->alloc_site;
+  } else {
+    struct SlabObject *obj = (struct SlabObject *)((u64)ptr - sizeof(struct SlabObject));
+    *bytes = obj->size;
+    handle = &obj->alloc_site;
+  }
+
+  spin_unlock(&kmalloc_lock);
+
+  return handle;
+}
+
+static void profile_alloc(void *ptr, u64 caller, u64 cycles) {
+  if (ptr) {
+    u64 bytes = 0;
+    u32 *handle = profile_handle(ptr, &bytes);
+    *handle = alloc_profile_record_alloc(caller, bytes, cycles);
+  }
+}
+
+/* The caller must be captured in the exported entry points, so these are macros */
+#define PROFILE_ALLOC(ptr) profile_alloc((ptr), ALLOC_PROFILE_CALLER(), ALLOC_PROFILE_ELAPSED())
+#define PROFILE_FREE(owner, bytes) \
+  alloc_profile_record_free((owner), ALLOC_PROFILE_CALLER(), (bytes), ALLOC_PROFILE_ELAPSED())
+#else
+#define PROFILE_ALLOC(ptr)
+#define PROFILE_FREE(owner, bytes)
+#endif
+
+static void *kmalloc_internal(size_t size) {
   if (!is_mm_initialized()) {
     if (mm_init(NULL, 0) != SUCCESS) {
       return NULL;
@@ -213,11 +290,7 @@ void *kmalloc(size_t size) {
   return result;
 }
 
-void kfree(void *ptr) {
-  if (ptr == NULL || !is_mm_initialized()) {
-    return;
-  }
-
+static void kfree_internal(void *ptr) {
   spin_lock(&kmalloc_lock);
 
   struct DirectAllocMap *map = find_direct_alloc(ptr);
@@ -230,8 +303,108 @@ void kfree(void *ptr) {
   spin_unlock(&kmalloc_lock);
 }
 
+static void *krealloc_internal(void *ptr, size_t new_size) {
+  if (ptr == NULL) {
+    return kmalloc_internal(new_size);
+  }
+
+  if (new_size == 0) {
+    kfree_internal(ptr);
+    return NULL;
+  }
+
+  if (!is_mm_initialized()) {
+    return NULL;
+  }
+
+  spin_lock(&kmalloc_lock);
+
+  size_t old_size = 0;
+  struct DirectAllocMap *map = find_direct_alloc(ptr);
+
+  if (map) {
+    if (map->hdr->magic != KMALLOC_MAGIC) {
+      spin_unlock(&kmalloc_lock);
+      return NULL;
+    }
+
+    old_size = map->hdr->size;
+
+    /* Allocations that shrink into slab range are moved so their pages can be released */
+    if (new_size > MAX_SLAB_SIZE && direct_resize(map, new_size)) {
+      spin_unlock(&kmalloc_lock);
+      return ptr;
+    }
+  } else {
+    struct SlabObject *obj = (struct SlabObject *)((u64)ptr - sizeof(struct SlabObject));
+
+    if (obj->magic != KMALLOC_MAGIC) {
+      spin_unlock(&kmalloc_lock);
+      return NULL;
+    }
+
+    /* The object already has room for the whole size class */
+    old_size = obj->size;
+    if (new_size <= obj->size) {
+      spin_unlock(&kmalloc_lock);
+      return ptr;
+    }
+  }
+
+  spin_unlock(&kmalloc_lock);
+
+  void *new_ptr = kmalloc_internal(new_size);
+  if (!new_ptr) {
+    return NULL;
+  }
+
+  memcpy(new_ptr, ptr, min(old_size, new_size));
+  kfree_internal(ptr);
+
+  return new_ptr;
+}
+
+void *kmalloc(size_t size) {
+  ALLOC_PROFILE_BEGIN();
+
+  void *result = kmalloc_internal(size);
+
+  PROFILE_ALLOC(result);
+
+  return result;
+}
+
+void *kmalloc_cache_aligned(size_t size) {
+  ALLOC_PROFILE_BEGIN();
+
+  void *result = (size == 0) ? NULL : kmalloc_internal(max(size, (size_t)SLAB_ALIGN_MIN_SIZE));
+
+  PROFILE_ALLOC(result);
+
+  return result;
+}
+
+void kfree(void *ptr) {
+  ALLOC_PROFILE_BEGIN();
+
+  if (ptr == NULL || !is_mm_initialized()) {
+    return;
+  }
+
+#ifdef ALLOC_PROFILE
+  u64 bytes = 0;
+  u32 owner = *profile_handle(ptr, &bytes);
+#endif
+
+  kfree_internal(ptr);
+
+  PROFILE_FREE(owner, bytes);
+}
+
 void *kzalloc(size_t size) {
-  void *ptr = kmalloc(size);
+  ALLOC_PROFILE_BEGIN();
+
+  void *ptr = kmalloc_internal(size);
 
   spin_lock(&kmalloc_lock);
 
@@ -241,5 +414,28 @@ void *kzalloc(size_t size) {
 
   spin_unlock(&kmalloc_lock);
 
+  PROFILE_ALLOC(ptr);
+
   return ptr;
 }
+
+void *krealloc(void *ptr, size_t new_size) {
+  ALLOC_PROFILE_BEGIN();
+
+#ifdef ALLOC_PROFILE
+  u64 bytes = 0;
+  u32 owner = ptr ? *profile_handle(ptr, &bytes) : 0U;
+#endif
+
+  void *result = krealloc_internal(ptr, new_size);
+
+  /* A resize is accounted as freeing the old size and allocating the new one */
+#ifdef ALLOC_PROFILE
+  if (ptr && (result || new_size == 0)) {
+    PROFILE_FREE(owner, bytes);
+  }
+#endif
+  PROFILE_ALLOC(result);
+
+  return result;
+}
@@ -0,0 +1,139 @@
+/*******************************************************************************************************************************
+ * @file   mempool.c
+ *
+ * @brief  Interrupt-safe reserved memory pool source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+
+/* Intra-component Headers */
+#include "kernel_malloc.h"
+#include "mempool.h"
+
+/**
+ * @brief   Pop the first object off the free list
+ * @details The load of the next pointer happens inside the exclusive sequence. Any store to the list
+ *          head in between (another core, or an interrupt handler on this core, since exception return
+ *          clears the monitor) makes the store-exclusive fail, so the ABA problem cannot occur
+ * @param   head Pointer to the list head
+ * @return  Address of the object or 0 if the list is empty
+ */
+static u64 free_list_pop(volatile u64 *head) {
+  u64 obj;
+  u64 next;
+  u32 failed;
+
+  asm volatile(
+      "1: ldaxr %0, [%3]      \n"
+      "   cbz %0, 2f          \n" /* Empty list */
+      "   ldr %1, [%0]        \n" /* Link stored in the first word of the object */
+      "   stxr %w2, %1, [%3]  \n"
+      "   cbnz %w2, 1b        \n"
+      "   b 3f                \n"
+      "2: clrex               \n"
+      "3:                     \n"
+      : "=&r"(obj), "=&r"(next), "=&r"(failed)
+      : "r"(head)
+      : "memory");
+
+  return obj;
+}
+
+/**
+ * @brief   Push an object onto the free list
+ * @param   head Pointer to the list head
+ * @param   obj Address of the object
+ */
+static void free_list_push(volatile u64 *head, u64 obj) {
+  u64 first;
+
+  do {
+    first = *head;
+    *(u64 *)obj = first;
+  } while (atomic_cmpxchg(head, first, obj) != first);
+}
+
+struct Mempool *mempool_create(u32 obj_size, u32 min_reserved) {
+  struct Mempool *pool = kzalloc(sizeof(struct Mempool));
+  if (!pool) {
+    return NULL;
+  }
+
+  pool->obj_size = max(obj_size, (u32)sizeof(u64));
+  pool->min_reserved = min_reserved;
+  pool->refill_lock = (struct Spinlock)SPIN_LOCK_INIT;
+
+  if (mempool_refill(pool) != SUCCESS) {
+    mempool_destroy(pool);
+    return NULL;
+  }
+
+  return pool;
+}
+
+void *mempool_alloc(struct Mempool *pool) {
+  u64 obj = free_list_pop(&pool->free_list);
+  if (obj == 0U) {
+    return NULL;
+  }
+
+  atomic_add_return(&pool->available, (u64)-1);
+
+  return (void *)obj;
+}
+
+void mempool_free(struct Mempool *pool, void *obj) {
+  if (!obj) {
+    return;
+  }
+
+  free_list_push(&pool->free_list, (u64)obj);
+  atomic_add_return(&pool->available, 1U);
+}
+
+bool mempool_needs_refill(struct Mempool *pool) {
+  return pool->available < pool->min_reserved;
+}
+
+ErrorCode mempool_refill(struct Mempool *pool) {
+  ErrorCode status = SUCCESS;
+
+  spin_lock(&pool->refill_lock);
+
+  while (pool->available < pool->min_reserved) {
+    void *obj = kmalloc(pool->obj_size);
+    if (!obj) {
+      status = ERR_MEM_OUT_OF_MEMORY;
+      break;
+    }
+
+    pool->total++;
+    mempool_free(pool, obj);
+  }
+
+  spin_unlock(&pool->refill_lock);
+
+  return status;
+}
+
+void mempool_destroy(struct Mempool *pool) {
+  if (!pool) {
+    return;
+  }
+
+  spin_lock(&pool->refill_lock);
+
+  u64 obj;
+  while ((obj = free_list_pop(&pool->free_list)) != 0U) {
+    kfree((void *)obj);
+  }
+
+  spin_unlock(&pool->refill_lock);
+
+  kfree(pool);
+}
@@ -0,0 +1,336 @@
+/*******************************************************************************************************************************
+ * @file   mmu.c
+ *
+ * @brief  Page table and MMU management source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "mem_utils.h"
+
+/* Intra-component Headers */
+#include "buddy.h"
+#include "mmu.h"
+
+/* Root tables must be aligned to their size */
+static u64 identity_pgd[PTRS_PER_TABLE] __attribute__((aligned(PAGE_SIZE)));
+static u64 identity_device_pmd[PTRS_PER_TABLE] __attribute__((aligned(PAGE_SIZE)));
+static u64 kernel_pgd[PTRS_PER_TABLE] __attribute__((aligned(PAGE_SIZE)));
+static u8 zero_page[PAGE_SIZE] __attribute__((aligned(PAGE_SIZE)));
+
+static bool mmu_enabled = false;
+static bool dcache_enabled = false;
+static u32 asid_bits = 8U;
+static u64 tcr_value = TCR_VALUE;
+
+/**
+ * @brief   Fill the TTBR0 identity map
+ * @details The first 3 GB are mapped with 1 GB blocks of normal memory. The last GB is split into 2 MB
+ *          blocks so the peripheral window can be mapped as device memory. Only the first GB, which holds
+ *          the kernel image, is executable
+ */
+static void build_identity_map(void) {
+  for (u64 i = 0U; i < (DEVICE_MAP_START >> L1_SHIFT); i++) {
+    u64 attrs = (i == 0U) ? PAGE_KERNEL_EXEC : PAGE_KERNEL;
+    identity_pgd[i] = (i << L1_SHIFT) | attrs | PTE_BLOCK | PTE_VALID;
+  }
+
+  u64 base = DEVICE_MAP_START & ~(L1_BLOCK_SIZE - 1U);
+  for (u64 i = 0U; i < PTRS_PER_TABLE; i++) {
+    u64 pa = base + (i << L2_SHIFT);
+    u64 attrs = (pa < DEVICE_MAP_START) ? PAGE_KERNEL : PAGE_DEVICE;
+    identity_device_pmd[i] = pa | attrs | PTE_BLOCK | PTE_VALID;
+  }
+
+  identity_pgd[L1_INDEX(base)] = (u64)identity_device_pmd | PTE_TABLE | PTE_VALID;
+}
+
+/**
+ * @brief   Allocate a zeroed translation table
+ * @return  Pointer to the table or NULL if no memory can be allocated
+ */
+static u64 *alloc_table(void) {
+  struct Page *page = buddy_alloc_pages(0U);
+  if (!page) {
+    return NULL;
+  }
+
+  u64 *table = page_to_virt(page);
+  memset(table, 0, PAGE_SIZE);
+
+  return table;
+}
+
+/**
+ * @brief   Get the next level table referenced by a descriptor
+ * @param   entry Descriptor in the current table
+ * @param   alloc Allocate the table if the descriptor is invalid
+ * @return  Pointer to the next level table, NULL if missing or if the descriptor is a block
+ */
+static u64 *next_table(u64 *entry, bool alloc) {
+  if (!(*entry & PTE_VALID)) {
+    if (!alloc) {
+      return NULL;
+    }
+
+    u64 *table = alloc_table();
+    if (!table) {
+      return NULL;
+    }
+
+    /* The table contents must be visible to the walker before it can be reached */
+    asm volatile("dsb ishst" ::: "memory");
+    *entry = (u64)table | PTE_TABLE | PTE_VALID;
+    return table;
+  }
+
+  if ((*entry & PTE_TYPE_MASK) != (PTE_TABLE | PTE_VALID)) {
+    return NULL;
+  }
+
+  return (u64 *)(*entry & PTE_ADDR_MASK);
+}
+
+/**
+ * @brief   Load the translation registers and turn on the MMU of the calling core
+ * @details The tables are shared, so every core runs with the same configuration
+ */
+static void mmu_enable_cpu(void) {
+  asm volatile("msr mair_el1, %0" ::"r"((u64)MAIR_VALUE));
+  asm volatile("msr tcr_el1, %0" ::"r"(tcr_value));
+  asm volatile("msr ttbr0_el1, %0" ::"r"((u64)identity_pgd));
+  asm volatile("msr ttbr1_el1, %0" ::"r"((u64)kernel_pgd));
+  asm volatile("dsb ish; isb" ::: "memory");
+
+  asm volatile("tlbi vmalle1; dsb nsh; isb" ::: "memory");
+
+  u64 sctlr;
+  asm volatile("mrs %0, sctlr_el1" : "=r"(sctlr));
+  sctlr |= SCTLR_MMU_ENABLED | SCTLR_I_CACHE_ENABLED;
+  if (dcache_enabled) {
+    sctlr |= SCTLR_D_CACHE_ENABLED;
+  }
+  asm volatile("msr sctlr_el1, %0; isb" ::"r"(sctlr) : "memory");
+}
+
+ErrorCode mmu_init(void) {
+  if (mmu_enabled) {
+    return SUCCESS;
+  }
+
+  build_identity_map();
+
+  u64 mmfr0;
+  asm volatile("mrs %0, id_aa64mmfr0_el1" : "=r"(mmfr0));
+  if (((mmfr0 >> ID_AA64MMFR0_ASID_SHIFT) & ID_AA64MMFR0_ASID_MASK) == ID_AA64MMFR0_ASID_16BIT) {
+    tcr_value |= TCR_AS_16BIT;
+    asid_bits = 16U;
+  }
+
+  mmu_enable_cpu();
+  mmu_enabled = true;
+
+  return SUCCESS;
+}
+
+void mmu_init_secondary(void) {
+  if (!mmu_enabled) {
+    return;
+  }
+
+  mmu_enable_cpu();
+}
+
+void mmu_enable_dcache(void) {
+  u64 sctlr;
+
+  asm volatile("mrs %0, sctlr_el1" : "=r"(sctlr));
+  sctlr |= SCTLR_D_CACHE_ENABLED;
+  asm volatile("msr sctlr_el1, %0; isb" ::"r"(sctlr) : "memory");
+
+  dcache_enabled = true;
+}
+
+bool mmu_is_enabled(void) {
+  return mmu_enabled;
+}
+
+bool mmu_dcache_enabled(void) {
+  return dcache_enabled;
+}
+
+u32 mmu_asid_bits(void) {
+  return asid_bits;
+}
+
+u64 mmu_zero_page(void) {
+  return (u64)zero_page;
+}
+
+u64 *mmu_kernel_pgd(void) {
+  return kernel_pgd;
+}
+
+u64 *mmu_identity_pgd(void) {
+  return identity_pgd;
+}
+
+u64 *mmu_walk(u64 *pgd, u64 va, bool alloc) {
+  u64 *pmd = next_table(&pgd[L1_INDEX(va)], alloc);
+  if (!pmd) {
+    return NULL;
+  }
+
+  u64 *pte = next_table(&pmd[L2_INDEX(va)], alloc);
+  if (!pte) {
+    return NULL;
+  }
+
+  return &pte[L3_INDEX(va)];
+}
+
+ErrorCode mmu_map_page(u64 *pgd, u64 va, u64 pa, u64 attrs) {
+  u64 *pte = mmu_walk(pgd, va, true);
+  if (!pte) {
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  if (*pte & PTE_VALID) {
+    return ERR_MEM_INVALID_ADDR;
+  }
+
+  *pte = (pa & PTE_ADDR_MASK) | attrs | PTE_PAGE | PTE_VALID;
+
+  return SUCCESS;
+}
+
+ErrorCode mmu_map_block(u64 *pgd, u64 va, u64 pa, u64 attrs) {
+  u64 *pmd = next_table(&pgd[L1_INDEX(va)], true);
+  if (!pmd) {
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  u64 *entry = &pmd[L2_INDEX(va)];
+  if (*entry & PTE_VALID) {
+    return ERR_MEM_INVALID_ADDR;
+  }
+
+  *entry = (pa & PTE_ADDR_MASK) | attrs | PTE_BLOCK | PTE_VALID;
+
+  return SUCCESS;
+}
+
+ErrorCode mmu_map_range(u64 *pgd, u64 va, u64 pa, u64 size, u64 attrs) {
+  u64 offset = 0U;
+
+  while (offset < size) {
+    if (((va + offset) & (HUGE_PAGE_SIZE - 1U)) == 0U && ((pa + offset) & (HUGE_PAGE_SIZE - 1U)) == 0U &&
+        size - offset >= HUGE_PAGE_SIZE && mmu_map_block(pgd, va + offset, pa + offset, attrs) == SUCCESS) {
+      offset += HUGE_PAGE_SIZE;
+      continue;
+    }
+
+    /* Pages cover the unaligned head and tail, and slots a level 3 table already occupies */
+    ErrorCode status = mmu_map_page(pgd, va + offset, pa + offset, attrs);
+    if (status != SUCCESS) {
+      mmu_unmap_range(pgd, va, offset);
+      return status;
+    }
+    offset += PAGE_SIZE;
+  }
+
+  return SUCCESS;
+}
+
+u64 mmu_unmap_page(u64 *pgd, u64 va) {
+  u64 *pte = mmu_walk(pgd, va, false);
+  if (!pte || !(*pte & PTE_VALID)) {
+    return 0U;
+  }
+
+  u64 pa = *pte & PTE_ADDR_MASK;
+  *pte = 0U;
+
+  return pa;
+}
+
+u64 mmu_unmap_entry(u64 *pgd, u64 va, u64 *size) {
+  *size = PAGE_SIZE;
+
+  u64 *pmd = next_table(&pgd[L1_INDEX(va)], false);
+  if (!pmd) {
+    return 0U;
+  }
+
+  u64 *entry = &pmd[L2_INDEX(va)];
+  if ((*entry & PTE_TYPE_MASK) == (PTE_BLOCK | PTE_VALID)) {
+    u64 pa = *entry & PTE_ADDR_MASK;
+    *entry = 0U;
+    *size = HUGE_PAGE_SIZE;
+    return pa;
+  }
+
+  return mmu_unmap_page(pgd, va);
+}
+
+void mmu_unmap_range(u64 *pgd, u64 va, u64 size) {
+  u64 offset = 0U;
+
+  while (offset < size) {
+    u64 entry_size;
+    mmu_unmap_entry(pgd, va + offset, &entry_size);
+    offset += entry_size;
+  }
+
+  mmu_flush_tlb_range(va, size);
+}
+
+void mmu_sync_tables(void) {
+  asm volatile("dsb ishst; isb" ::: "memory");
+}
+
+void mmu_flush_tlb_range(u64 va, u64 size) {
+  u64 start = va & ~((u64)PAGE_SIZE - 1U);
+  u64 pages = (va + size - start + PAGE_SIZE - 1U) >> PAGE_SHIFT;
+
+  /* Descriptor updates must complete before the invalidation */
+  asm volatile("dsb ishst" ::: "memory");
+
+  if (pages > TLB_FLUSH_PAGE_LIMIT) {
+    asm volatile("tlbi vmalle1is" ::: "memory");
+  } else {
+    for (u64 i = 0U; i < pages; i++) {
+      /* Operand holds VA[55:12], matching entries for any ASID */
+      u64 operand = ((start + (i << PAGE_SHIFT)) >> PAGE_SHIFT) & ((1UL << 44) - 1U);
+      asm volatile("tlbi vaae1is, %0" ::"r"(operand) : "memory");
+    }
+  }
+
+  asm volatile("dsb ish; isb" ::: "memory");
+}
+
+void mmu_flush_tlb_asid(u64 asid) {
+  asm volatile("dsb ishst; tlbi aside1is, %0; dsb ish; isb" ::"r"(asid << 48) : "memory");
+}
+
+void mmu_flush_tlb_all(void) {
+  asm volatile("dsb ishst; tlbi vmalle1is; dsb ish; isb" ::: "memory");
+}
+
+void mmu_sync_icache_range(u64 addr, u64 size) {
+  u64 start = addr & ~((u64)CACHE_LINE_SIZE - 1U);
+
+  for (u64 line = start; line < addr + size; line += CACHE_LINE_SIZE) {
+    asm volatile("dc cvau, %0" ::"r"(line) : "memory");
+  }
+  asm volatile("dsb ish" ::: "memory");
+
+  for (u64 line = start; line < addr + size; line += CACHE_LINE_SIZE) {
+    asm volatile("ic ivau, %0" ::"r"(line) : "memory");
+  }
+  asm volatile("dsb ish; isb" ::: "memory");
+}
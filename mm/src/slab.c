@@ -23,6 +23,7 @@
 static struct Spinlock slab_alloc_lock = SPIN_LOCK_INIT;
 
 static struct Slab *slab_caches[SLAB_SIZES]; /* Slab caches for different sizes */
+static u32 slab_colour_next[SLAB_SIZES];     /* Colour of the next slab created for each size */
 
 /* Direct allocation header pool - like Linux's kmalloc_head pool */
 static void *header_pool = NULL;
@@ -34,7 +35,15 @@ bool slab_initialized = false;
 static struct Slab *initialize_slab_cache(u32 index, u64 object_size) {
   /* Calculate how many pages we need */
   u64 real_object_size = object_size + sizeof(struct SlabObject);
-  u64 objects_per_page = PAGE_SIZE / real_object_size;
+  u64 lead = 0;
+
+  /* Large classes are padded so every object starts on a cache line and never straddles one */
+  if (object_size >= SLAB_ALIGN_MIN_SIZE) {
+    real_object_size = (real_object_size + CACHE_LINE_SIZE - 1) & ~((u64)CACHE_LINE_SIZE - 1);
+    lead = ((sizeof(struct SlabObject) + CACHE_LINE_SIZE - 1) & ~((u64)CACHE_LINE_SIZE - 1)) - sizeof(struct SlabObject);
+  }
+
+  u64 objects_per_page = (PAGE_SIZE - lead) / real_object_size;
 
   if (objects_per_page == 0) {
     objects_per_page = 1;
@@ -44,7 +53,7 @@ static struct Slab *initialize_slab_cache(u32 index, u64 object_size) {
   u32 pages_needed = 1;
 
   /* Determine total pages needed */
-  while ((pages_needed * PAGE_SIZE) < (objects_per_page * real_object_size)) {
+  while ((pages_needed * PAGE_SIZE) < (lead + objects_per_page * real_object_size)) {
     pages_needed++;
   }
 
@@ -55,7 +64,7 @@ static struct Slab *initialize_slab_cache(u32 index, u64 object_size) {
   }
 
   /* Allocate pages */
-  struct Page *first_page = buddy_alloc_pages(order);
+  struct Page *first_page = buddy_alloc_pages_untracked(order);
   if (!first_page) {
     return NULL;
   }
@@ -63,10 +72,17 @@ static struct Slab *initialize_slab_cache(u32 index, u64 object_size) {
   /* Initialize the slab structure in header pool */
   struct Slab *slab = alloc_header(sizeof(struct Slab));
   if (!slab) {
-    buddy_free_pages(first_page);
+    buddy_free_pages_untracked(first_page);
     return NULL;
   }
 
+  /* Each new slab of a class starts one more cache line into the slack, so the same object in
+   * different slabs maps to different cache sets */
+  u64 slack = ((u64)PAGE_SIZE << order) - lead - (objects_per_page * real_object_size);
+  u32 colours = (slack / SLAB_COLOUR_SIZE) + 1;
+  u32 colour = slab_colour_next[index] % colours;
+  slab_colour_next[index] = (colour + 1) % colours;
+
   slab->object_size = object_size;
   slab->total_objects = objects_per_page;
   slab->free_objects = objects_per_page;
@@ -74,6 +90,7 @@ static struct Slab *initialize_slab_cache(u32 index, u64 object_size) {
   slab->next = NULL;
   slab->first_page = first_page;
   slab->pages = 1 << order;
+  slab->colour = colour * SLAB_COLOUR_SIZE;
 
   /* Mark the pages as belonging to this slab */
   u32 pfn = first_page - get_mem_map();
@@ -82,7 +99,7 @@ static struct Slab *initialize_slab_cache(u32 index, u64 object_size) {
   }
 
   /* Initialize objects */
-  void *data_start = page_to_virt(first_page);
+  void *data_start = (void *)((u64)page_to_virt(first_page) + lead + slab->colour);
   for (u32 i = 0; i < objects_per_page; i++) {
     struct SlabObject *obj = (struct SlabObject *)((u64)data_start + (i * real_object_size));
     obj->magic = KMALLOC_MAGIC;
@@ -114,17 +131,20 @@ ErrorCode slab_init(void) {
   spin_lock(&slab_alloc_lock);
 
   if (slab_initialized) {
+    spin_unlock(&slab_alloc_lock);
     return SUCCESS;
   }
 
   if (!is_mm_initialized()) {
     if (mm_init(NULL, 0) != SUCCESS) {
+      spin_unlock(&slab_alloc_lock);
       return ERR_MEM_INIT_FAILED;
     }
   }
 
   for (u32 i = 0; i < SLAB_SIZES; i++) {
     slab_caches[i] = NULL;
+    slab_colour_next[i] = 0;
   }
 
   /* Calculate header pool size (5% of memory pool or at least 64KB) */
@@ -154,8 +174,6 @@ void *slab_alloc(u32 size) {
     }
   }
 
-  spin_lock(&slab_alloc_lock);
-
   if (size == 0) {
     return NULL;
   }
@@ -172,10 +190,14 @@ void *slab_alloc(u32 size) {
   /* Handle slab allocation */
   u32 index = (size / MIN_SLAB_SIZE) - 1;
 
+  /* Every core allocates through here, so each way out must drop the lock */
+  spin_lock(&slab_alloc_lock);
+
   /* No slab cache exists for this size yet */
   if (slab_caches[index] == NULL) {
     struct Slab *new_slab = initialize_slab_cache(index, size);
     if (new_slab == NULL) {
+      spin_unlock(&slab_alloc_lock);
       return NULL;
     }
     slab_caches[index] = new_slab;
@@ -191,6 +213,7 @@ void *slab_alloc(u32 size) {
   if (slab == NULL) {
     slab = initialize_slab_cache(index, size);
     if (slab == NULL) {
+      spin_unlock(&slab_alloc_lock);
       return NULL;
     }
 
@@ -209,23 +232,25 @@ void *slab_alloc(u32 size) {
 }
 
 void slab_free(void *ptr) {
-  spin_lock(&slab_alloc_lock);
-
   if (ptr == NULL) {
     return;
   }
 
+  spin_lock(&slab_alloc_lock);
+
   /* Must be a slab allocation */
   struct SlabObject *obj = (struct SlabObject *)((u64)ptr - sizeof(struct SlabObject));
 
   if (obj->magic != KMALLOC_MAGIC) {
     /* Invalid or corrupted object */
+    spin_unlock(&slab_alloc_lock);
     return;
   }
 
   /* Get the slab */
   struct Slab *slab = obj->parent;
   if (!slab) {
+    spin_unlock(&slab_alloc_lock);
     return;
   }
 
@@ -0,0 +1,236 @@
+/*******************************************************************************************************************************
+ * @file   swap.c
+ *
+ * @brief  Swapping of user pages to zram source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "arm64_atomic.h"
+#include "scheduler.h"
+
+/* Intra-component Headers */
+#include "buddy.h"
+#include "swap.h"
+#include "zram.h"
+
+static volatile u64 reclaim_active = 0U;
+
+/* Clock hand: the next page to look at. Guarded by the address space list lock */
+static struct AddressSpace *hand_as = NULL;
+static u64 hand_va = USER_VA_START;
+
+ErrorCode swap_init(void) {
+  return zram_init();
+}
+
+void swap_forget(struct AddressSpace *as) {
+  if (hand_as == as) {
+    hand_as = address_space_next(as);
+    hand_va = USER_VA_START;
+  }
+}
+
+/**
+ * @brief   Advance the clock hand to the next mapped user page
+ * @details Missing tables are skipped whole. Gives up after passing the start of the list twice. Must be called
+ *          with the address space list locked
+ * @param   as Set to the address space of the page
+ * @param   va Set to the virtual address of the page
+ * @return  Pointer to the descriptor, NULL if no address space maps any page
+ */
+static u64 *clock_next(struct AddressSpace **as, u64 *va) {
+  u32 wraps = 0U;
+
+  while (wraps < 2U) {
+    if (!hand_as) {
+      hand_as = address_space_next(NULL);
+      hand_va = USER_VA_START;
+      wraps++;
+      if (!hand_as) {
+        return NULL;
+      }
+    }
+
+    while (hand_va < USER_VA_END) {
+      u64 l1 = hand_as->pgd[L1_INDEX(hand_va)];
+      if ((l1 & PTE_TYPE_MASK) != (PTE_TABLE | PTE_VALID)) {
+        hand_va = (hand_va & ~(L1_BLOCK_SIZE - 1U)) + L1_BLOCK_SIZE;
+        continue;
+      }
+
+      u64 l2 = ((u64 *)(l1 & PTE_ADDR_MASK))[L2_INDEX(hand_va)];
+      if ((l2 & PTE_TYPE_MASK) != (PTE_TABLE | PTE_VALID)) {
+        hand_va = (hand_va & ~(L2_BLOCK_SIZE - 1U)) + L2_BLOCK_SIZE;
+        continue;
+      }
+
+      u64 *pte = &((u64 *)(l2 & PTE_ADDR_MASK))[L3_INDEX(hand_va)];
+      *va = hand_va;
+      hand_va += PAGE_SIZE;
+
+      if (*pte & PTE_VALID) {
+        *as = hand_as;
+        return pte;
+      }
+    }
+
+    hand_as = address_space_next(hand_as);
+    hand_va = USER_VA_START;
+  }
+
+  return NULL;
+}
+
+/**
+ * @brief   Compress a page into zram and free it
+ * @details Must be called with the address space locked
+ * @param   as Address space mapping the page
+ * @param   pte Valid descriptor of the page
+ * @param   va Virtual address of the page
+ * @return  TRUE if the page was freed
+ */
+static bool evict_page(struct AddressSpace *as, u64 *pte, u64 va) {
+  u64 entry = *pte;
+  u64 pa = entry & PTE_ADDR_MASK;
+  if (pa == mmu_zero_page()) {
+    return false;
+  }
+
+  /* Pages shared by fork stay until a write or an exit leaves a single owner. Only fork adds references, and
+   * it holds the address space lock */
+  struct Page *page = virt_to_page((void *)pa);
+  if (page->_count > 1U) {
+    return false;
+  }
+
+  /* The owner may be running on another core. Unmapping first stops its writes from landing after the page was
+   * compressed, a fault in the meantime waits on the address space lock */
+  *pte = 0U;
+  mmu_flush_tlb_range(va, PAGE_SIZE);
+
+  u32 slot;
+  if (zram_store((void *)pa, &slot) != SUCCESS) {
+    *pte = entry;
+    mmu_sync_tables();
+    return false;
+  }
+
+  *pte = SWAP_PTE(slot);
+  mmu_sync_tables();
+  buddy_free_pages(page);
+
+  as->rss_pages--;
+  as->swap_pages++;
+
+  return true;
+}
+
+u32 swap_reclaim(u32 target) {
+  if (atomic_xchg(&reclaim_active, 1U) != 0U) {
+    return 0U;
+  }
+
+  address_space_list_lock();
+
+  /* Enough steps for the hand to pass every page twice, once to age it and once to evict it */
+  u64 budget = target;
+  for (struct AddressSpace *as = address_space_next(NULL); as; as = address_space_next(as)) {
+    budget += 2U * as->rss_pages;
+  }
+
+  u32 reclaimed = 0U;
+  bool aged = false;
+
+  while (reclaimed < target && budget > 0U) {
+    struct AddressSpace *as;
+    u64 va;
+    u64 *pte = clock_next(&as, &va);
+    if (!pte) {
+      break;
+    }
+    budget--;
+
+    address_space_lock(as);
+
+    /* The owner may have changed the entry since the hand found it */
+    if ((*pte & (PTE_VALID | PTE_AF)) == (PTE_VALID | PTE_AF)) {
+      *pte &= ~PTE_AF;
+      aged = true;
+    } else if ((*pte & PTE_VALID) && evict_page(as, pte, va)) {
+      reclaimed++;
+    }
+
+    address_space_unlock(as);
+  }
+
+  /* One invalidation for every cleared flag, so the next access to each of those pages faults and sets it */
+  if (aged) {
+    mmu_flush_tlb_all();
+  }
+
+  /* Pages were just freed, so the pool can take back what it borrowed from its reserve */
+  zram_refill();
+
+  address_space_list_unlock();
+  atomic_xchg(&reclaim_active, 0U);
+
+  return reclaimed;
+}
+
+struct Page *swap_alloc_page(void) {
+  struct Page *page = buddy_alloc_pages(0U);
+
+  if (!page && swap_reclaim(SWAP_RECLAIM_BATCH) > 0U) {
+    page = buddy_alloc_pages(0U);
+  }
+
+  return page;
+}
+
+ErrorCode swap_in(struct AddressSpace *as, u64 *pte, u64 va, u64 attrs) {
+  u64 entry = *pte;
+  u32 slot = SWAP_PTE_SLOT(entry);
+
+  /* Allocated before taking the lock, which reclaim needs as well */
+  struct Page *page = swap_alloc_page();
+  if (!page) {
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  address_space_lock(as);
+
+  /* Another fault on the same page got there first, the access is simply retried */
+  if (*pte != entry) {
+    address_space_unlock(as);
+    buddy_free_pages(page);
+    return SUCCESS;
+  }
+
+  void *addr = page_to_virt(page);
+  if (zram_load(slot, addr) != SUCCESS) {
+    address_space_unlock(as);
+    buddy_free_pages(page);
+    return ERR_GEN_INVALID_PARAM;
+  }
+
+  /* A slot shared by fork hands each address space its own copy */
+  *pte = (u64)addr | attrs | PTE_PAGE | PTE_VALID;
+  mmu_sync_tables();
+
+  as->rss_pages++;
+  as->swap_pages--;
+
+  address_space_unlock(as);
+  zram_put(slot);
+
+  if (attrs == PAGE_USER_EXEC) {
+    mmu_sync_icache_range((u64)addr, PAGE_SIZE);
+  }
+
+  return SUCCESS;
+}
@@ -10,6 +10,308 @@
 /* Standard library Headers */
 
 /* Inter-component Headers */
+#include "spinlock.h"
 
 /* Intra-component Headers */
+#include "buddy.h"
+#include "kernel_malloc.h"
 #include "virtual_malloc.h"
+
+static struct Spinlock vmalloc_lock = SPIN_LOCK_INIT;
+
+/* Areas sorted by address */
+static struct VmArea *vm_areas = NULL;
+
+/**
+ * @brief   Reserve address space using first fit
+ * @details Must be called with vmalloc_lock held
+ * @param   area Area to insert. The size must be set, the address is filled in
+ * @param   align Power of two alignment of the start of the area, at least PAGE_SIZE
+ * @param   phase Offset from the alignment the area must start at, a multiple of PAGE_SIZE below align
+ * @return  SUCCESS if the area was inserted
+ *          ERR_MEM_OUT_OF_MEMORY if no gap is large enough
+ */
+static ErrorCode insert_area(struct VmArea *area, u64 align, u64 phase) {
+  struct VmArea **pp = &vm_areas;
+  u64 addr = VMALLOC_START + phase;
+
+  while (*pp) {
+    if ((*pp)->addr >= addr && (*pp)->addr - addr >= area->size) {
+      break;
+    }
+    addr = (((*pp)->addr + (*pp)->size + align - 1U) & ~(align - 1U)) + phase;
+    pp = &(*pp)->next;
+  }
+
+  if (addr >= VMALLOC_END || VMALLOC_END - addr < area->size) {
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  area->addr = addr;
+  area->next = *pp;
+  *pp = area;
+
+  return SUCCESS;
+}
+
+/**
+ * @brief   Unlink the area starting at an address
+ * @details Must be called with vmalloc_lock held
+ * @param   addr Start address of the area
+ * @return  The area or NULL if no area starts at addr
+ */
+static struct VmArea *remove_area(u64 addr) {
+  struct VmArea **pp = &vm_areas;
+  while (*pp && (*pp)->addr != addr) {
+    pp = &(*pp)->next;
+  }
+
+  struct VmArea *area = *pp;
+  if (area) {
+    *pp = area->next;
+  }
+
+  return area;
+}
+
+/**
+ * @brief   Unmap a range and release its pages
+ * @details The pages are chained through their buddy list pointer and only freed after the TLB
+ *          invalidation, so no stale translation can reach a page that has been handed out again. A huge
+ *          page is a single buddy block, so it is released as one
+ * @param   addr Start of the range
+ * @param   size Size of the range in bytes
+ */
+static void unmap_area(u64 addr, u64 size) {
+  struct Page *freed = NULL;
+  u64 va = addr;
+
+  while (va < addr + size) {
+    u64 entry_size;
+    u64 pa = mmu_unmap_entry(mmu_kernel_pgd(), va, &entry_size);
+    if (pa) {
+      struct Page *page = virt_to_page((void *)pa);
+      page->next = freed;
+      freed = page;
+    }
+    va += entry_size;
+  }
+
+  mmu_flush_tlb_range(addr, size);
+
+  while (freed) {
+    struct Page *page = freed;
+    freed = page->next;
+    page->next = NULL;
+    buddy_free_pages(page);
+  }
+}
+
+void *vmalloc(size_t size) {
+  if (size == 0U) {
+    return NULL;
+  }
+
+  if (!mmu_is_enabled()) {
+    if (mmu_init() != SUCCESS) {
+      return NULL;
+    }
+  }
+
+  struct VmArea *area = kmalloc(sizeof(struct VmArea));
+  if (!area) {
+    return NULL;
+  }
+
+  u64 mapped_size = ((u64)size + PAGE_SIZE - 1U) & ~((u64)PAGE_SIZE - 1U);
+  area->size = mapped_size + PAGE_SIZE;
+  area->external = false;
+
+  spin_lock(&vmalloc_lock);
+
+  if (insert_area(area, PAGE_SIZE, 0U) != SUCCESS) {
+    spin_unlock(&vmalloc_lock);
+    kfree(area);
+    return NULL;
+  }
+
+  for (u64 offset = 0U; offset < mapped_size; offset += PAGE_SIZE) {
+    struct Page *page = buddy_alloc_pages(0U);
+    ErrorCode status = ERR_MEM_OUT_OF_MEMORY;
+
+    if (page) {
+      status = mmu_map_page(mmu_kernel_pgd(), area->addr + offset, (u64)page_to_virt(page), PAGE_KERNEL);
+      if (status != SUCCESS) {
+        buddy_free_pages(page);
+      }
+    }
+
+    if (status != SUCCESS) {
+      unmap_area(area->addr, offset);
+      remove_area(area->addr);
+      spin_unlock(&vmalloc_lock);
+      kfree(area);
+      return NULL;
+    }
+  }
+
+  /* One barrier for the whole batch. The entries were invalid before, so no TLB maintenance is needed */
+  mmu_sync_tables();
+
+  spin_unlock(&vmalloc_lock);
+
+  return (void *)area->addr;
+}
+
+/**
+ * @brief   Map one huge page worth of memory at the start of a chunk
+ * @details Must be called with vmalloc_lock held. The buddy block is only usable if it is physically
+ *          aligned to HUGE_PAGE_SIZE and the slot holds no level 3 table left by earlier page mappings,
+ *          otherwise the chunk is built from order-0 pages
+ * @param   va Huge page aligned virtual address
+ * @return  SUCCESS if the chunk is mapped
+ *          ERR_MEM_OUT_OF_MEMORY if pages or tables could not be allocated. Pages already mapped are
+ *          left for the caller to release
+ */
+static ErrorCode map_huge_chunk(u64 va) {
+  struct Page *block = buddy_alloc_pages(HUGE_PAGE_ORDER);
+
+  if (block && ((u64)page_to_virt(block) & (HUGE_PAGE_SIZE - 1U)) == 0U &&
+      mmu_map_block(mmu_kernel_pgd(), va, (u64)page_to_virt(block), PAGE_KERNEL) == SUCCESS) {
+    return SUCCESS;
+  }
+
+  /* The pages must be freed one by one later, so a block is never split across page descriptors */
+  if (block) {
+    buddy_free_pages(block);
+  }
+
+  for (u64 offset = 0U; offset < HUGE_PAGE_SIZE; offset += PAGE_SIZE) {
+    struct Page *page = buddy_alloc_pages(0U);
+    if (!page) {
+      return ERR_MEM_OUT_OF_MEMORY;
+    }
+
+    ErrorCode status = mmu_map_page(mmu_kernel_pgd(), va + offset, (u64)page_to_virt(page), PAGE_KERNEL);
+    if (status != SUCCESS) {
+      buddy_free_pages(page);
+      return status;
+    }
+  }
+
+  return SUCCESS;
+}
+
+void *vmalloc_huge(size_t size) {
+  if (size == 0U) {
+    return NULL;
+  }
+
+  if (!mmu_is_enabled()) {
+    if (mmu_init() != SUCCESS) {
+      return NULL;
+    }
+  }
+
+  struct VmArea *area = kmalloc(sizeof(struct VmArea));
+  if (!area) {
+    return NULL;
+  }
+
+  u64 mapped_size = ((u64)size + HUGE_PAGE_SIZE - 1U) & ~((u64)HUGE_PAGE_SIZE - 1U);
+  area->size = mapped_size + PAGE_SIZE;
+  area->external = false;
+
+  spin_lock(&vmalloc_lock);
+
+  if (insert_area(area, HUGE_PAGE_SIZE, 0U) != SUCCESS) {
+    spin_unlock(&vmalloc_lock);
+    kfree(area);
+    return NULL;
+  }
+
+  for (u64 offset = 0U; offset < mapped_size; offset += HUGE_PAGE_SIZE) {
+    if (map_huge_chunk(area->addr + offset) != SUCCESS) {
+      /* Covers the partially mapped chunk as well */
+      unmap_area(area->addr, offset + HUGE_PAGE_SIZE);
+      remove_area(area->addr);
+      spin_unlock(&vmalloc_lock);
+      kfree(area);
+      return NULL;
+    }
+  }
+
+  mmu_sync_tables();
+
+  spin_unlock(&vmalloc_lock);
+
+  return (void *)area->addr;
+}
+
+void *vmap(u64 pa, size_t size, u64 attrs) {
+  if (size == 0U) {
+    return NULL;
+  }
+
+  if (!mmu_is_enabled()) {
+    if (mmu_init() != SUCCESS) {
+      return NULL;
+    }
+  }
+
+  struct VmArea *area = kmalloc(sizeof(struct VmArea));
+  if (!area) {
+    return NULL;
+  }
+
+  u64 start = pa & ~((u64)PAGE_SIZE - 1U);
+  u64 mapped_size = (pa + size - start + PAGE_SIZE - 1U) & ~((u64)PAGE_SIZE - 1U);
+  area->size = mapped_size + PAGE_SIZE;
+  area->external = true;
+
+  spin_lock(&vmalloc_lock);
+
+  /* Matching the physical offset within a huge page lets mmu_map_range use blocks past the first boundary */
+  if (insert_area(area, HUGE_PAGE_SIZE, start & (HUGE_PAGE_SIZE - 1U)) != SUCCESS) {
+    spin_unlock(&vmalloc_lock);
+    kfree(area);
+    return NULL;
+  }
+
+  if (mmu_map_range(mmu_kernel_pgd(), area->addr, start, mapped_size, attrs) != SUCCESS) {
+    remove_area(area->addr);
+    spin_unlock(&vmalloc_lock);
+    kfree(area);
+    return NULL;
+  }
+
+  mmu_sync_tables();
+
+  spin_unlock(&vmalloc_lock);
+
+  return (void *)(area->addr + (pa - start));
+}
+
+void vfree(void *ptr) {
+  if (ptr == NULL) {
+    return;
+  }
+
+  spin_lock(&vmalloc_lock);
+
+  /* vmap hands out a pointer with the page offset of the physical address */
+  struct VmArea *area = remove_area((u64)ptr & ~((u64)PAGE_SIZE - 1U));
+  if (area && area->external) {
+    mmu_unmap_range(mmu_kernel_pgd(), area->addr, area->size - PAGE_SIZE);
+  } else if (area) {
+    unmap_area(area->addr, area->size - PAGE_SIZE);
+  }
+
+  spin_unlock(&vmalloc_lock);
+
+  kfree(area);
+}
+
+bool is_vmalloc_addr(void *ptr) {
+  return (u64)ptr >= VMALLOC_START && (u64)ptr < VMALLOC_END;
+}
@@ -0,0 +1,203 @@
+/*******************************************************************************************************************************
+ * @file   zpool.c
+ *
+ * @brief  Size-class pool for compressed objects source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "scheduler.h"
+
+/* Intra-component Headers */
+#include "buddy.h"
+#include "zpool.h"
+
+/** @brief  Offset of the first object, keeping objects aligned to 16 bytes */
+#define ZPOOL_PAGE_HEADER ((sizeof(struct ZpoolPage) + 15U) & ~15UL)
+
+static inline u32 class_size(u32 size_class) {
+  return (size_class + 1U) * ZPOOL_CLASS_STEP;
+}
+
+static inline u8 *page_object(struct ZpoolPage *zpage, u32 index) {
+  return (u8 *)zpage + ZPOOL_PAGE_HEADER + index * class_size(zpage->size_class);
+}
+
+/* Objects are freed from preemptible code while the swap clock allocates with preemption disabled */
+static void pool_lock(struct Zpool *pool) {
+  preempt_disable();
+  spin_lock(&pool->lock);
+}
+
+static void pool_unlock(struct Zpool *pool) {
+  spin_unlock(&pool->lock);
+  preempt_enable();
+}
+
+/**
+ * @brief   Take a page from the buddy allocator, or from the reserve when it is empty
+ * @details Must be called with the pool lock held
+ * @param   pool Pointer to the pool
+ * @return  Pointer to the page or NULL if both are empty
+ */
+static void *take_page(struct Zpool *pool) {
+  struct Page *page = buddy_alloc_pages(0U);
+  if (page) {
+    return page_to_virt(page);
+  }
+
+  struct ZpoolPage *spare = pool->reserve;
+  if (spare) {
+    pool->reserve = spare->next;
+    pool->reserve_count--;
+  }
+
+  return spare;
+}
+
+/**
+ * @brief   Carve a new page into objects of one size class
+ * @details Must be called with the pool lock held
+ * @param   pool Pointer to the pool
+ * @param   size_class Index of the size class
+ * @return  Pointer to the page header or NULL if no page is available
+ */
+static struct ZpoolPage *grow_class(struct Zpool *pool, u32 size_class) {
+  struct ZpoolPage *zpage = take_page(pool);
+  if (!zpage) {
+    return NULL;
+  }
+
+  zpage->size_class = (u16)size_class;
+  zpage->in_use = 0U;
+  zpage->capacity = (u16)((PAGE_SIZE - ZPOOL_PAGE_HEADER) / class_size(size_class));
+  zpage->free_head = 0U;
+
+  for (u32 i = 0U; i < zpage->capacity; i++) {
+    *(u16 *)page_object(zpage, i) = (i + 1U < zpage->capacity) ? (u16)(i + 1U) : ZPOOL_NO_OBJECT;
+  }
+
+  zpage->next = pool->partial[size_class];
+  pool->partial[size_class] = zpage;
+  pool->pages++;
+
+  return zpage;
+}
+
+ErrorCode zpool_init(struct Zpool *pool, u32 reserve_pages) {
+  *pool = (struct Zpool){ .reserve_target = reserve_pages, .lock = SPIN_LOCK_INIT };
+
+  return zpool_refill(pool);
+}
+
+void *zpool_alloc(struct Zpool *pool, u32 size) {
+  if (size == 0U || size > ZPOOL_MAX_SIZE) {
+    return NULL;
+  }
+
+  u32 size_class = (size - 1U) / ZPOOL_CLASS_STEP;
+
+  pool_lock(pool);
+
+  struct ZpoolPage *zpage = pool->partial[size_class];
+  if (!zpage) {
+    zpage = grow_class(pool, size_class);
+    if (!zpage) {
+      pool_unlock(pool);
+      return NULL;
+    }
+  }
+
+  u8 *obj = page_object(zpage, zpage->free_head);
+  zpage->free_head = *(u16 *)obj;
+  zpage->in_use++;
+
+  /* Full pages leave the list, zpool_free finds them again through the object address */
+  if (zpage->free_head == ZPOOL_NO_OBJECT) {
+    pool->partial[size_class] = zpage->next;
+    zpage->next = NULL;
+  }
+
+  pool_unlock(pool);
+
+  return obj;
+}
+
+void zpool_free(struct Zpool *pool, void *obj) {
+  if (obj == NULL) {
+    return;
+  }
+
+  struct ZpoolPage *zpage = (struct ZpoolPage *)((u64)obj & ~((u64)PAGE_SIZE - 1U));
+  u32 size_class = zpage->size_class;
+  u32 index = ((u8 *)obj - page_object(zpage, 0U)) / class_size(size_class);
+
+  pool_lock(pool);
+
+  bool was_full = (zpage->free_head == ZPOOL_NO_OBJECT);
+  *(u16 *)obj = zpage->free_head;
+  zpage->free_head = (u16)index;
+  zpage->in_use--;
+
+  if (was_full) {
+    zpage->next = pool->partial[size_class];
+    pool->partial[size_class] = zpage;
+  }
+
+  if (zpage->in_use == 0U) {
+    struct ZpoolPage **pp = &pool->partial[size_class];
+    while (*pp != zpage) {
+      pp = &(*pp)->next;
+    }
+    *pp = zpage->next;
+    pool->pages--;
+
+    if (pool->reserve_count < pool->reserve_target) {
+      zpage->next = pool->reserve;
+      pool->reserve = zpage;
+      pool->reserve_count++;
+      zpage = NULL;
+    }
+  } else {
+    zpage = NULL;
+  }
+
+  pool_unlock(pool);
+
+  if (zpage) {
+    buddy_free_pages(virt_to_page(zpage));
+  }
+}
+
+u32 zpool_pages(struct Zpool *pool) {
+  pool_lock(pool);
+  u32 pages = pool->pages;
+  pool_unlock(pool);
+
+  return pages;
+}
+
+ErrorCode zpool_refill(struct Zpool *pool) {
+  pool_lock(pool);
+
+  while (pool->reserve_count < pool->reserve_target) {
+    struct Page *page = buddy_alloc_pages(0U);
+    if (!page) {
+      pool_unlock(pool);
+      return ERR_MEM_OUT_OF_MEMORY;
+    }
+
+    struct ZpoolPage *spare = page_to_virt(page);
+    spare->next = pool->reserve;
+    pool->reserve = spare;
+    pool->reserve_count++;
+  }
+
+  pool_unlock(pool);
+
+  return SUCCESS;
+}
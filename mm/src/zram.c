@@ -0,0 +1,211 @@
+/*******************************************************************************************************************************
+ * @file   zram.c
+ *
+ * @brief  Compressed in-memory page store source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "lz4.h"
+#include "mem_utils.h"
+#include "scheduler.h"
+#include "spinlock.h"
+
+/* Intra-component Headers */
+#include "zram.h"
+
+/** @brief  Marks the end of the free slot list */
+#define ZRAM_NO_SLOT ZRAM_SLOTS
+
+static struct Spinlock zram_lock = SPIN_LOCK_INIT;
+static bool zram_initialized = false;
+
+static struct ZramSlot slots[ZRAM_SLOTS];
+static u32 free_slot;
+static struct Zpool pool;
+static struct ZramStats stats;
+
+/* Compression scratch space, used with zram_lock held */
+static u16 lz4_workspace[LZ4_WORKSPACE_SIZE / sizeof(u16)];
+static u8 compress_buffer[ZPOOL_MAX_SIZE];
+
+/* The swap clock spins on the lock with preemption disabled, so a holder must not be preempted on its core */
+static void slots_lock(void) {
+  preempt_disable();
+  spin_lock(&zram_lock);
+}
+
+static void slots_unlock(void) {
+  spin_unlock(&zram_lock);
+  preempt_enable();
+}
+
+/**
+ * @brief   Check if a page is one word repeated
+ * @param   page Page to check
+ * @param   fill Set to the repeated word
+ * @return  TRUE if every word of the page equals the first
+ */
+static bool page_same_filled(const u64 *page, u64 *fill) {
+  for (u32 i = 1U; i < PAGE_SIZE / sizeof(u64); i++) {
+    if (page[i] != page[0]) {
+      return false;
+    }
+  }
+
+  *fill = page[0];
+  return true;
+}
+
+ErrorCode zram_init(void) {
+  if (zram_initialized) {
+    return SUCCESS;
+  }
+
+  /* The first address spaces may be created on several cores at once */
+  slots_lock();
+
+  if (zram_initialized) {
+    slots_unlock();
+    return SUCCESS;
+  }
+
+  if (zpool_init(&pool, ZRAM_RESERVE_PAGES) != SUCCESS) {
+    slots_unlock();
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  for (u32 i = 0U; i < ZRAM_SLOTS; i++) {
+    slots[i] = (struct ZramSlot){ .fill = i + 1U };
+  }
+  free_slot = 0U;
+  zram_initialized = true;
+
+  slots_unlock();
+
+  return SUCCESS;
+}
+
+ErrorCode zram_store(const void *page, u32 *slot) {
+  if (zram_init() != SUCCESS) {
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  slots_lock();
+
+  if (free_slot == ZRAM_NO_SLOT) {
+    slots_unlock();
+    return ERR_MEM_OUT_OF_MEMORY;
+  }
+
+  u64 fill = 0U;
+  void *obj = NULL;
+  u32 size = 0U;
+
+  if (!page_same_filled(page, &fill)) {
+    size = lz4_compress(page, PAGE_SIZE, compress_buffer, sizeof(compress_buffer), lz4_workspace);
+    if (size == 0U) {
+      stats.rejected++;
+      slots_unlock();
+      return ERR_SYS_NOT_SUPPORTED;
+    }
+
+    obj = zpool_alloc(&pool, size);
+    if (!obj) {
+      slots_unlock();
+      return ERR_MEM_OUT_OF_MEMORY;
+    }
+    memcpy(obj, compress_buffer, size);
+  }
+
+  u32 index = free_slot;
+  free_slot = (u32)slots[index].fill;
+  slots[index] = (struct ZramSlot){ .obj = obj, .fill = fill, .size = (u16)size, .refs = 1U };
+
+  stats.stored_pages++;
+  stats.same_filled += obj ? 0U : 1U;
+  stats.compressed_bytes += size;
+  stats.stores++;
+
+  slots_unlock();
+
+  *slot = index;
+  return SUCCESS;
+}
+
+ErrorCode zram_load(u32 slot, void *page) {
+  if (slot >= ZRAM_SLOTS) {
+    return ERR_GEN_INVALID_PARAM;
+  }
+
+  slots_lock();
+
+  struct ZramSlot *entry = &slots[slot];
+  ErrorCode status = SUCCESS;
+
+  if (entry->refs == 0U) {
+    status = ERR_GEN_INVALID_PARAM;
+  } else if (!entry->obj) {
+    u64 *words = page;
+    for (u32 i = 0U; i < PAGE_SIZE / sizeof(u64); i++) {
+      words[i] = entry->fill;
+    }
+  } else if (lz4_decompress(entry->obj, entry->size, page, PAGE_SIZE) != PAGE_SIZE) {
+    status = ERR_GEN_INVALID_PARAM;
+  }
+
+  if (status == SUCCESS) {
+    stats.loads++;
+  }
+
+  slots_unlock();
+
+  return status;
+}
+
+void zram_dup(u32 slot) {
+  slots_lock();
+  slots[slot].refs++;
+  slots_unlock();
+}
+
+void zram_put(u32 slot) {
+  slots_lock();
+
+  struct ZramSlot *entry = &slots[slot];
+  if (--entry->refs > 0U) {
+    slots_unlock();
+    return;
+  }
+
+  void *obj = entry->obj;
+  stats.stored_pages--;
+  stats.same_filled -= obj ? 0U : 1U;
+  stats.compressed_bytes -= entry->size;
+
+  *entry = (struct ZramSlot){ .fill = free_slot };
+  free_slot = slot;
+
+  slots_unlock();
+
+  zpool_free(&pool, obj);
+}
+
+ErrorCode zram_refill(void) {
+  if (!zram_initialized) {
+    return SUCCESS;
+  }
+
+  return zpool_refill(&pool);
+}
+
+void zram_get_stats(struct ZramStats *out) {
+  slots_lock();
+  *out = stats;
+  out->pool_pages = zpool_pages(&pool);
+  slots_unlock();
+}
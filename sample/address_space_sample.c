@@ -0,0 +1,154 @@
+#include "address_space.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mini_uart.h"
+#include "scheduler.h"
+#include "syscalls.h"
+#include "utils.h"
+
+#define NUM_SPACES 4
+#define PAGES_PER_SPACE 4
+#define ROUNDS 256
+#define NUM_USER_TASKS 3
+
+/* Code and data that run at EL0 are placed in the .user section and copied into each address space,
+ * together with the call_sys_* wrappers */
+#define USER_CODE __attribute__((section(".user.text")))
+#define USER_DATA __attribute__((section(".user.rodata")))
+
+extern char __user_begin[];
+extern char __user_end[];
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+USER_DATA static char user_message[] = "EL0 task alive in its own address space\n\r";
+
+/* Every task sees the same virtual addresses but writes its own physical stack page */
+USER_CODE static void user_process(void) {
+  volatile u64 counter = 0;
+
+  while (1) {
+    if ((counter++ % 2000000) == 0) {
+      call_sys_write(user_message);
+    }
+  }
+}
+
+static void user_task_launcher(u64 arg) {
+  if (move_task_to_user_mode((u64)__user_begin, (u64)(__user_end - __user_begin), (u64)&user_process) != 0) {
+    log("ERROR: Failed to move task %d to user mode\n\r", arg);
+    while (1) {
+    }
+  }
+}
+
+static struct AddressSpace *spaces[NUM_SPACES];
+
+static void touch_pages() {
+  for (u32 i = 0; i < PAGES_PER_SPACE; i++) {
+    volatile u64 *p = (u64 *)(USER_VA_START + (u64)i * PAGE_SIZE);
+    (void)*p;
+  }
+}
+
+/*
+ * Cycle through the address spaces, touching every page after each switch. With ASIDs the entries
+ * of all spaces stay in the TLB. Invalidating on every switch models an untagged TLB
+ */
+static void run_switches(char *name, bool flush) {
+  u64 switch_cycles = 0;
+
+  pmu_config_event(0, PMU_EVENT_L1D_TLB_REFILL);
+  u64 start = pmu_read_cycles();
+
+  for (u32 r = 0; r < ROUNDS; r++) {
+    for (u32 s = 0; s < NUM_SPACES; s++) {
+      u64 t0 = pmu_read_cycles();
+      address_space_switch(spaces[s]);
+      if (flush) {
+        mmu_flush_tlb_all();
+      }
+      switch_cycles += pmu_read_cycles() - t0;
+
+      touch_pages();
+    }
+  }
+
+  u64 total = pmu_read_cycles() - start;
+  u64 refills = pmu_read_event(0);
+  u32 switches = ROUNDS * NUM_SPACES;
+
+  address_space_switch_kernel();
+
+  log("  %s: %ld cycles/switch, %ld cycles/round, %ld D-TLB refills/switch\n\r", name, switch_cycles / switches,
+      total / ROUNDS, refills / switches);
+}
+
+static void benchmark_switch_cost() {
+  for (u32 s = 0; s < NUM_SPACES; s++) {
+    spaces[s] = address_space_create();
+    if (!spaces[s]) {
+      log("  Failed to create address space %d\n\r", s);
+      return;
+    }
+
+    for (u32 i = 0; i < PAGES_PER_SPACE; i++) {
+      if (!address_space_alloc_page(spaces[s], USER_VA_START + (u64)i * PAGE_SIZE, PAGE_USER)) {
+        log("  Failed to map page %d of address space %d\n\r", i, s);
+        return;
+      }
+    }
+  }
+
+  log("%d address spaces, %d pages each, %d ASID bits\n\r", NUM_SPACES, PAGES_PER_SPACE, mmu_asid_bits());
+
+  run_switches("ASID tagged", false);
+  run_switches("TLB flush per switch", true);
+
+  for (u32 s = 0; s < NUM_SPACES; s++) {
+    address_space_destroy(spaces[s]);
+  }
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+
+  pmu_init();
+  mmu_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== ADDRESS SPACE SWITCH BENCHMARK =====\n\r");
+
+  benchmark_switch_cost();
+
+  log("\n\r===== STARTING %d USER TASKS =====\n\r", NUM_USER_TASKS);
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+
+  for (u32 i = 0; i < NUM_USER_TASKS; i++) {
+    if (scheduler_create_task(PF_KTHREAD, (u64)&user_task_launcher, i, DEFAULT_PRIORITY) != 0) {
+      log("ERROR: Failed to create task %d\n\r", i);
+    }
+  }
+
+  while (1) {
+  }
+}
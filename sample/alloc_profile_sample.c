@@ -0,0 +1,73 @@
+#include "alloc_profile.h"
+#include "buddy.h"
+#include "kernel.h"
+#include "kernel_malloc.h"
+#include "log.h"
+#include "mini_uart.h"
+#include "utils.h"
+
+/* Build with `make ALLOC_PROFILE=1`, otherwise the report compiles away */
+
+#define PACKETS 64
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Small short-lived allocations, like HCI event parsing */
+void parse_packets() {
+  for (int i = 0; i < PACKETS; i++) {
+    void *header = kmalloc(16);
+    void *payload = kzalloc(64 + i);
+    kfree(payload);
+    kfree(header);
+  }
+}
+
+/* Long-lived buffers that stay allocated, like log staging */
+void *log_buffers[4];
+void allocate_log_buffers() {
+  for (int i = 0; i < 4; i++) {
+    log_buffers[i] = kmalloc(2 * PAGE_SIZE);
+  }
+}
+
+/* Raw page allocations, like DMA descriptors */
+void allocate_dma_pages() {
+  struct Page *pages[8];
+  for (int i = 0; i < 8; i++) {
+    pages[i] = buddy_alloc_pages(0);
+  }
+  for (int i = 0; i < 8; i += 2) {
+    buddy_free_pages(pages[i]);
+  }
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+}
+
+void kernel_main() {
+  kernel_init();
+
+  parse_packets();
+  allocate_log_buffers();
+  allocate_dma_pages();
+
+  log("\n\rSorted by cycles:\n\r");
+  alloc_profile_report(ALLOC_PROFILE_SORT_CYCLES);
+
+  log("\n\rSorted by live bytes:\n\r");
+  alloc_profile_report(ALLOC_PROFILE_SORT_LIVE_BYTES);
+
+  while (1) {
+  }
+}
@@ -0,0 +1,148 @@
+#include "arena.h"
+#include "kernel.h"
+#include "kernel_malloc.h"
+#include "log.h"
+#include "mem_utils.h"
+#include "mini_uart.h"
+#include "utils.h"
+
+#define PACKETS 256
+#define OBJECTS_PER_PACKET 12
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Object sizes seen when decoding an HCI event: header, parameters, TLVs, name strings */
+static const u32 object_sizes[OBJECTS_PER_PACKET] = { 16, 24, 8, 64, 32, 32, 48, 16, 96, 8, 40, 24 };
+
+typedef struct {
+  u64 total;
+  u64 min;
+  u64 max;
+} CycleStats;
+
+static void record(CycleStats *stats, u64 cycles) {
+  stats->total += cycles;
+  stats->min = (stats->min == 0 || cycles < stats->min) ? cycles : stats->min;
+  stats->max = max(stats->max, cycles);
+}
+
+/* Touch every object like a parser filling in fields */
+static void parse_object(void *obj, u32 size, u32 packet) {
+  memset(obj, (int)packet, size);
+}
+
+void benchmark_kmalloc() {
+  CycleStats stats = { 0 };
+  void *objects[OBJECTS_PER_PACKET];
+
+  for (u32 p = 0; p < PACKETS; p++) {
+    u64 start = pmu_read_cycles();
+
+    for (u32 i = 0; i < OBJECTS_PER_PACKET; i++) {
+      objects[i] = kmalloc(object_sizes[i]);
+      if (objects[i]) {
+        parse_object(objects[i], object_sizes[i], p);
+      }
+    }
+
+    for (u32 i = 0; i < OBJECTS_PER_PACKET; i++) {
+      kfree(objects[i]);
+    }
+
+    record(&stats, pmu_read_cycles() - start);
+  }
+
+  log("  kmalloc/kfree: avg %ld cycles/packet (min %ld, max %ld)\n\r", stats.total / PACKETS, stats.min, stats.max);
+}
+
+void benchmark_arena() {
+  CycleStats stats = { 0 };
+  struct Arena *arena = arena_create(PAGE_SIZE);
+  if (!arena) {
+    log("  Failed to create arena\n\r");
+    return;
+  }
+
+  for (u32 p = 0; p < PACKETS; p++) {
+    u64 start = pmu_read_cycles();
+
+    for (u32 i = 0; i < OBJECTS_PER_PACKET; i++) {
+      void *obj = arena_alloc(arena, object_sizes[i], 0);
+      if (obj) {
+        parse_object(obj, object_sizes[i], p);
+      }
+    }
+
+    arena_reset(arena);
+
+    record(&stats, pmu_read_cycles() - start);
+  }
+
+  arena_destroy(arena);
+
+  log("  arena:         avg %ld cycles/packet (min %ld, max %ld)\n\r", stats.total / PACKETS, stats.min, stats.max);
+}
+
+/* Batches that overflow the first chunk exercise chunk chaining and bulk page release */
+void benchmark_arena_batches() {
+  CycleStats stats = { 0 };
+  struct Arena *arena = arena_create(PAGE_SIZE);
+  if (!arena) {
+    log("  Failed to create arena\n\r");
+    return;
+  }
+
+  for (u32 batch = 0; batch < PACKETS / 16; batch++) {
+    u64 start = pmu_read_cycles();
+
+    for (u32 p = 0; p < 16 * 8; p++) {
+      for (u32 i = 0; i < OBJECTS_PER_PACKET; i++) {
+        void *obj = arena_alloc(arena, object_sizes[i], 0);
+        if (obj) {
+          parse_object(obj, object_sizes[i], p);
+        }
+      }
+    }
+
+    arena_reset(arena);
+
+    record(&stats, pmu_read_cycles() - start);
+  }
+
+  arena_destroy(arena);
+
+  log("  arena (128 packets per reset): avg %ld cycles/batch (min %ld, max %ld)\n\r", stats.total / (PACKETS / 16),
+      stats.min, stats.max);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+
+  pmu_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== ARENA PARSE-AND-DISCARD BENCHMARK =====\n\r");
+  log("%d packets, %d objects per packet\n\r", PACKETS, OBJECTS_PER_PACKET);
+
+  benchmark_kmalloc();
+  benchmark_arena();
+  benchmark_arena_batches();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
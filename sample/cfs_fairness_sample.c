@@ -0,0 +1,84 @@
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "utils.h"
+
+#define NUM_WORKERS 5
+#define BENCHMARK_SECONDS 10
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+static const long worker_priorities[NUM_WORKERS] = { 1, 3, 5, 7, 10 };
+static u32 worker_pids[NUM_WORKERS];
+static volatile u64 worker_loops[NUM_WORKERS];
+
+/* CPU-bound worker, it never blocks so its share is decided by the scheduler alone */
+void worker(void *arg) {
+  volatile u64 *loops = arg;
+  while (true) {
+    (*loops)++;
+  }
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the CFS fairness sample. EL: %d\n\r", el);
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  for (int i = 0; i < NUM_WORKERS; i++) {
+    int res = scheduler_create_task_pid(PF_KTHREAD, (u64)&worker, (u64)&worker_loops[i], worker_priorities[i],
+                                        &worker_pids[i]);
+    if (res != 0) {
+      log("ERROR: Failed to start worker %d. Error: %d\n\r", i, res);
+      return;
+    }
+  }
+
+  log("Running %d CPU-bound workers for %d seconds...\n\r", NUM_WORKERS, BENCHMARK_SECONDS);
+
+  // The main task yields until the run is over. Its own share is excluded from the results
+  u64 end = timer_get_ticks() + (u64)BENCHMARK_SECONDS * CLOCK_HZ;
+  while (timer_get_ticks() < end) {
+    schedule();
+  }
+
+  u64 runtime[NUM_WORKERS];
+  u64 weight[NUM_WORKERS];
+  u64 total_runtime = 0;
+  u64 total_weight = 0;
+
+  for (int i = 0; i < NUM_WORKERS; i++) {
+    struct TaskBlock *p = scheduler_find_task(worker_pids[i]);
+    runtime[i] = p->se.sum_exec_runtime;
+    weight[i] = p->se.weight;
+    total_runtime += runtime[i];
+    total_weight += weight[i];
+  }
+
+  log("\n\r===== CFS FAIRNESS (share in permille) =====\n\r");
+  log("prio  weight  runtime_ms  expected  measured\n\r");
+  for (int i = 0; i < NUM_WORKERS; i++) {
+    log("%ld  %ld  %ld  %ld  %ld\n\r", worker_priorities[i], weight[i], runtime[i] / 1000000U,
+        (weight[i] * 1000U) / total_weight, total_runtime ? (runtime[i] * 1000U) / total_runtime : 0U);
+  }
+
+  while (1) {
+  }
+}
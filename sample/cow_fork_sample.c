@@ -0,0 +1,193 @@
+#include "address_space.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mem_utils.h"
+#include "mini_uart.h"
+#include "scheduler.h"
+#include "syscalls.h"
+#include "utils.h"
+
+#define HEAP_PAGES 64
+#define CHILD_WRITES 8
+
+/* Code and data that run at EL0 are placed in the .user section and copied into each address space */
+#define USER_CODE __attribute__((section(".user.text")))
+#define USER_DATA __attribute__((section(".user.rodata")))
+
+extern char __user_begin[];
+extern char __user_end[];
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+USER_DATA static char parent_message[] = "Parent running\n\r";
+USER_DATA static char child_message[] = "Forked child running\n\r";
+
+USER_CODE static void user_child(void *arg) {
+  volatile u64 counter = 0;
+
+  while (1) {
+    if ((counter++ % 2000000) == 0) {
+      call_sys_write(arg);
+    }
+  }
+}
+
+USER_CODE static void user_parent(void) {
+  volatile u64 counter = 0;
+
+  call_sys_create_task(user_child, child_message);
+
+  while (1) {
+    if ((counter++ % 2000000) == 0) {
+      call_sys_write(parent_message);
+    }
+  }
+}
+
+static void user_task_launcher(u64 arg) {
+  if (move_task_to_user_mode((u64)__user_begin, (u64)(__user_end - __user_begin), (u64)&user_parent) != 0) {
+    log("ERROR: Failed to move task to user mode\n\r");
+    while (1) {
+    }
+  }
+}
+
+/* What fork would cost without copy-on-write: every resident page is copied up front */
+static struct AddressSpace *clone_by_copy(struct AddressSpace *parent, u64 heap) {
+  struct AddressSpace *child = address_space_create();
+  if (!child) {
+    return NULL;
+  }
+
+  for (u32 i = 0; i < HEAP_PAGES; i++) {
+    u64 va = heap + (u64)i * PAGE_SIZE;
+    u64 *pte = mmu_walk(parent->pgd, va, false);
+    void *page = address_space_alloc_page(child, va, PAGE_USER);
+    if (!pte || !page) {
+      address_space_destroy(child);
+      return NULL;
+    }
+    memcpy(page, (void *)(*pte & PTE_ADDR_MASK), PAGE_SIZE);
+  }
+
+  return child;
+}
+
+static void use_address_space(struct AddressSpace *as) {
+  current->mm = as;
+  address_space_switch(as);
+}
+
+/* Run on the init task's behalf so the fault handler finds the address space through current */
+static void benchmark_fork() {
+  struct AddressSpace *parent = address_space_create();
+  if (!parent) {
+    log("  Failed to create address space\n\r");
+    return;
+  }
+
+  parent->heap = address_space_add_region(parent, USER_VA_START, USER_VA_START, VM_READ | VM_WRITE);
+  u64 heap = parent->heap ? address_space_brk(parent, HEAP_PAGES * PAGE_SIZE) : 0;
+  if (!heap) {
+    log("  Failed to set up the heap\n\r");
+    address_space_destroy(parent);
+    return;
+  }
+
+  use_address_space(parent);
+  for (u32 i = 0; i < HEAP_PAGES; i++) {
+    *(volatile u64 *)(heap + (u64)i * PAGE_SIZE) = i;
+  }
+  log("  Parent: %d resident pages\n\r", parent->rss_pages);
+
+  u64 start = pmu_read_cycles();
+  struct AddressSpace *copy = clone_by_copy(parent, heap);
+  u64 copy_cycles = pmu_read_cycles() - start;
+  address_space_destroy(copy);
+
+  start = pmu_read_cycles();
+  struct AddressSpace *child = address_space_clone(parent);
+  u64 cow_cycles = pmu_read_cycles() - start;
+  if (!child) {
+    log("  address_space_clone failed\n\r");
+    use_address_space(NULL);
+    address_space_switch_kernel();
+    address_space_destroy(parent);
+    return;
+  }
+
+  log("  Fork by copying: %ld cycles\n\r", copy_cycles);
+  log("  Fork copy-on-write: %ld cycles\n\r", cow_cycles);
+
+  /* The child's writes copy only the pages it touches */
+  use_address_space(child);
+  start = pmu_read_cycles();
+  for (u32 i = 0; i < CHILD_WRITES; i++) {
+    *(volatile u64 *)(heap + (u64)i * PAGE_SIZE) = 1000 + i;
+  }
+  u64 fault_cycles = pmu_read_cycles() - start;
+  log("  Child wrote %d pages: %ld cycles per copy\n\r", CHILD_WRITES, fault_cycles / CHILD_WRITES);
+
+  /* The parent still sees its own data, and takes its pages back without copying */
+  use_address_space(parent);
+  bool intact = true;
+  for (u32 i = 0; i < HEAP_PAGES; i++) {
+    if (*(volatile u64 *)(heap + (u64)i * PAGE_SIZE) != i) {
+      intact = false;
+    }
+  }
+
+  start = pmu_read_cycles();
+  for (u32 i = 0; i < CHILD_WRITES; i++) {
+    *(volatile u64 *)(heap + (u64)i * PAGE_SIZE) = i;
+  }
+  u64 reuse_cycles = pmu_read_cycles() - start;
+  log("  Parent data %s, retaking %d pages: %ld cycles per page\n\r", intact ? "intact" : "CORRUPTED", CHILD_WRITES,
+      reuse_cycles / CHILD_WRITES);
+
+  use_address_space(NULL);
+  address_space_switch_kernel();
+  address_space_destroy(child);
+  address_space_destroy(parent);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+
+  pmu_init();
+  mmu_init();
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== COPY-ON-WRITE FORK BENCHMARK =====\n\r");
+  log("%d resident heap pages\n\r", HEAP_PAGES);
+
+  benchmark_fork();
+
+  log("\n\r===== STARTING USER TASK THAT FORKS =====\n\r");
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  if (scheduler_create_task(PF_KTHREAD, (u64)&user_task_launcher, 0, DEFAULT_PRIORITY) != 0) {
+    log("ERROR: Failed to create task\n\r");
+  }
+
+  while (1) {
+  }
+}
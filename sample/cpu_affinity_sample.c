@@ -0,0 +1,205 @@
+#include "arm64_atomic.h"
+#include "bcm2711_cpu.h"
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mmu.h"
+#include "sched_class.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "utils.h"
+#include "wait_queue.h"
+
+#define NUM_HOGS 6
+#define PHASE_MS 2000
+#define LATENCY_ROUNDS 200
+#define LATENCY_SLEEP_MS 2
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Bit n is set once the task ran on CPU n, one word per task */
+static volatile u64 seen_cpus[NUM_HOGS + 1];
+static WaitQueue done_wq = WAIT_QUEUE_INIT;
+static volatile u64 tasks_done = 0;
+static volatile bool phase_over = false;
+static u64 max_late_us = 0;
+static u64 total_late_us = 0;
+
+static void task_done(void) {
+  atomic_add_return(&tasks_done, 1U);
+  wake_up_all(&done_wq);
+  scheduler_exit_task();
+}
+
+static void mark_cpu(volatile u64 *seen) {
+  u64 bit = 1ULL << get_cpu_id();
+  if (!(*seen & bit)) {
+    atomic_add_return(seen, bit);
+  }
+}
+
+/* Batch work, placed by the balancer on any CPU that is not isolated */
+void hog(void *arg) {
+  volatile u64 *seen = arg;
+
+  while (!phase_over) {
+    mark_cpu(seen);
+  }
+
+  task_done();
+}
+
+/* Stands in for the Bluetooth/UART task, pinned to the isolated CPU */
+void latency_task(void *arg) {
+  volatile u64 *seen = arg;
+
+  for (u32 i = 0U; i < LATENCY_ROUNDS; i++) {
+    u64 start = sched_clock();
+    msleep(LATENCY_SLEEP_MS);
+    u64 late_us = (sched_clock() - start - LATENCY_SLEEP_MS * NSEC_PER_MSEC) / NSEC_PER_USEC;
+
+    max_late_us = max(max_late_us, late_us);
+    total_late_us += late_us;
+    mark_cpu(seen);
+  }
+
+  task_done();
+}
+
+/* Never sleeps, so with the CPU to itself its tick can stop */
+void pinned_spinner(void *arg) {
+  volatile u64 *seen = arg;
+
+  while (!phase_over) {
+    mark_cpu(seen);
+  }
+
+  task_done();
+}
+
+static u64 cpu_ticks(u32 cpu) {
+  struct SchedCpuStats stats;
+  scheduler_get_cpu_stats(cpu, &stats);
+  return stats.ticks;
+}
+
+static void print_seen(char *name, u64 seen) {
+  log("  %s ran on cpus:", name);
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    if (seen & (1ULL << cpu)) {
+      log(" %d", cpu);
+    }
+  }
+  log("\n\r");
+}
+
+static void start_hogs(u32 move_cpu) {
+  for (u32 i = 0U; i < NUM_HOGS; i++) {
+    u32 pid;
+    seen_cpus[i] = 0U;
+    if (scheduler_create_task_pid(PF_KTHREAD, (u64)&hog, (u64)&seen_cpus[i], DEFAULT_PRIORITY, &pid) != 0) {
+      log("ERROR: Failed to start hog %d\n\r", i);
+      continue;
+    }
+
+    // The first hog is pinned at runtime, after it may already have run elsewhere
+    if (i == 0U) {
+      task_set_affinity(pid, 1U << move_cpu);
+    }
+  }
+}
+
+void run_isolated_latency(u32 isolated) {
+  phase_over = false;
+  tasks_done = 0U;
+  seen_cpus[NUM_HOGS] = 0U;
+
+  start_hogs(0U);
+  scheduler_create_task_affinity(PF_KTHREAD, (u64)&latency_task, (u64)&seen_cpus[NUM_HOGS], DEFAULT_PRIORITY,
+                                 1U << isolated, NULL);
+
+  msleep(PHASE_MS);
+  phase_over = true;
+  wait_event(&done_wq, tasks_done == NUM_HOGS + 1U);
+
+  log("  msleep(%d) x %d on cpu%d: late avg %ld us, max %ld us\n\r", LATENCY_SLEEP_MS, LATENCY_ROUNDS, isolated,
+      total_late_us / LATENCY_ROUNDS, max_late_us);
+  print_seen("latency task", seen_cpus[NUM_HOGS]);
+  print_seen("hog 0, pinned to cpu0 at runtime", seen_cpus[0]);
+
+  u64 all_hogs = 0U;
+  for (u32 i = 1U; i < NUM_HOGS; i++) {
+    all_hogs |= seen_cpus[i];
+  }
+  print_seen("other hogs", all_hogs);
+  log("  isolated cpu%d %s\n\r", isolated, (all_hogs & (1ULL << isolated)) ? "RAN BATCH WORK" : "kept free of batch work");
+}
+
+void run_tick_stop(u32 isolated) {
+  phase_over = false;
+  tasks_done = 0U;
+  seen_cpus[0] = 0U;
+
+  scheduler_create_task_affinity(PF_KTHREAD, (u64)&pinned_spinner, (u64)&seen_cpus[0], DEFAULT_PRIORITY,
+                                 1U << isolated, NULL);
+  msleep(100);
+
+  u64 isolated_start = cpu_ticks(isolated);
+  u64 boot_start = cpu_ticks(0U);
+  msleep(PHASE_MS);
+  u64 isolated_ticks = cpu_ticks(isolated) - isolated_start;
+  u64 boot_ticks = cpu_ticks(0U) - boot_start;
+
+  phase_over = true;
+  wait_event(&done_wq, tasks_done == 1U);
+
+  log("  ticks in %d ms: isolated cpu%d running one task %ld, cpu0 %ld\n\r", PHASE_MS, isolated, isolated_ticks,
+      boot_ticks);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the CPU affinity sample. EL: %d\n\r", el);
+
+  // Secondary cores need cacheable memory for their locks. Nothing here shares buffers with the VideoCore
+  mmu_init();
+  mmu_enable_dcache();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+  u32 online = scheduler_smp_init();
+  if (online < 2U) {
+    log("ERROR: Needs at least 2 CPUs, run with make sim SMP=4\n\r");
+    while (1) {
+    }
+  }
+
+  // The hogs may run on every CPU, only isolation keeps them off the last one
+  u32 isolated = online - 1U;
+  scheduler_isolate_cpus(1U << isolated);
+
+  log("\n\r===== PINNED TASK ON ISOLATED CPU%d =====\n\r", isolated);
+  run_isolated_latency(isolated);
+
+  log("\n\r===== TICK ON AN ISOLATED CPU =====\n\r");
+  run_tick_stop(isolated);
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+    msleep(1000);
+  }
+}
@@ -0,0 +1,146 @@
+#include "address_space.h"
+#include "kernel.h"
+#include "log.h"
+#include "mini_uart.h"
+#include "scheduler.h"
+#include "utils.h"
+
+#define EAGER_STACK_PAGES 16
+#define HEAP_PAGES 64
+#define CREATE_ROUNDS 16
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Old behaviour: every page of the stack is allocated and mapped when the task is created */
+static struct AddressSpace *create_eager() {
+  struct AddressSpace *as = address_space_create();
+  if (!as) {
+    return NULL;
+  }
+
+  for (u32 i = 1; i <= EAGER_STACK_PAGES; i++) {
+    if (!address_space_alloc_page(as, USER_STACK_TOP - (u64)i * PAGE_SIZE, PAGE_USER)) {
+      address_space_destroy(as);
+      return NULL;
+    }
+  }
+
+  return as;
+}
+
+/* Demand paging: the whole stack is only reserved */
+static struct AddressSpace *create_lazy() {
+  struct AddressSpace *as = address_space_create();
+  if (!as) {
+    return NULL;
+  }
+
+  if (!address_space_add_region(as, USER_STACK_TOP - USER_STACK_SIZE, USER_STACK_TOP, VM_READ | VM_WRITE)) {
+    address_space_destroy(as);
+    return NULL;
+  }
+
+  return as;
+}
+
+static void benchmark_creation(char *name, struct AddressSpace *(*create_fn)()) {
+  u64 cycles = 0;
+
+  for (u32 i = 0; i < CREATE_ROUNDS; i++) {
+    u64 start = pmu_read_cycles();
+    struct AddressSpace *as = create_fn();
+    cycles += pmu_read_cycles() - start;
+
+    if (!as) {
+      log("  %s: creation failed\n\r", name);
+      return;
+    }
+    address_space_destroy(as);
+  }
+
+  log("  %s: %ld cycles per address space\n\r", name, cycles / CREATE_ROUNDS);
+}
+
+/* Run on the init task's behalf so the fault handler finds the address space through current */
+static void benchmark_footprint() {
+  struct AddressSpace *as = create_lazy();
+  if (!as) {
+    log("  Failed to create address space\n\r");
+    return;
+  }
+
+  as->heap = address_space_add_region(as, USER_VA_START, USER_VA_START, VM_READ | VM_WRITE);
+  u64 heap = as->heap ? address_space_brk(as, HEAP_PAGES * PAGE_SIZE) : 0;
+  if (!heap) {
+    log("  Failed to set up the heap\n\r");
+    address_space_destroy(as);
+    return;
+  }
+
+  current->mm = as;
+  address_space_switch(as);
+
+  log("  Reserved: %d heap pages, %d stack pages\n\r", HEAP_PAGES, USER_STACK_SIZE / PAGE_SIZE);
+
+  u64 sum = 0;
+  u64 start = pmu_read_cycles();
+  for (u32 i = 0; i < HEAP_PAGES; i++) {
+    sum += *(volatile u64 *)(heap + (u64)i * PAGE_SIZE);
+  }
+  u64 read_cycles = pmu_read_cycles() - start;
+  log("  After reading every heap page: %d resident pages (%ld cycles/fault, sum %ld)\n\r", as->rss_pages,
+      read_cycles / HEAP_PAGES, sum);
+
+  start = pmu_read_cycles();
+  for (u32 i = 0; i < HEAP_PAGES; i += 4) {
+    *(volatile u64 *)(heap + (u64)i * PAGE_SIZE) = i;
+  }
+  u64 write_cycles = pmu_read_cycles() - start;
+  log("  After writing every 4th heap page: %d resident pages (%ld cycles/fault)\n\r", as->rss_pages,
+      write_cycles / (HEAP_PAGES / 4));
+
+  for (u32 i = 1; i <= 3; i++) {
+    *(volatile u64 *)(USER_STACK_TOP - (u64)i * PAGE_SIZE) = i;
+  }
+  log("  After using 3 stack pages: %d resident pages\n\r", as->rss_pages);
+
+  current->mm = NULL;
+  address_space_switch_kernel();
+  address_space_destroy(as);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+
+  pmu_init();
+  mmu_init();
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== DEMAND PAGING BENCHMARK =====\n\r");
+
+  log("Address space creation:\n\r");
+  benchmark_creation("Eager 64 KB stack", create_eager);
+  benchmark_creation("Reserved 1 MB stack", create_lazy);
+
+  log("Memory footprint:\n\r");
+  benchmark_footprint();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
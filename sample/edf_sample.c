@@ -0,0 +1,138 @@
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "sched_class.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "utils.h"
+
+#define NUM_PERIODIC 3
+#define TEST_SECONDS 5
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+typedef struct {
+  char *name;
+  u64 runtime_ms;
+  u64 period_ms;
+  u64 work_us; /**< Busy time of every job, below the budget */
+  u32 pid;
+  volatile u64 jobs;
+  volatile u64 worst_response_us;
+} PeriodicTask;
+
+/* Models sensor control loops polled at different rates. Total utilization is 65% */
+static PeriodicTask periodic_tasks[NUM_PERIODIC] = {
+  { .name = "imu     ", .runtime_ms = 2, .period_ms = 10, .work_us = 1000 },
+  { .name = "pressure", .runtime_ms = 5, .period_ms = 20, .work_us = 3000 },
+  { .name = "logger  ", .runtime_ms = 10, .period_ms = 50, .work_us = 6000 },
+};
+
+static void busy_wait_us(u64 us) {
+  u64 end = timer_get_ticks() + us;
+  while (timer_get_ticks() < end) {
+  }
+}
+
+void periodic(void *arg) {
+  PeriodicTask *t = arg;
+
+  while (true) {
+    u64 release = current->dl.abs_deadline - current->dl.deadline;
+
+    busy_wait_us(t->work_us);
+
+    u64 response_us = (sched_clock() - release) / NSEC_PER_USEC;
+    t->worst_response_us = max(t->worst_response_us, response_us);
+    t->jobs++;
+
+    sched_wait_next_period();
+  }
+}
+
+/* Fair class background load, only runs in the time the deadline tasks leave over */
+void hog(void *arg) {
+  volatile u64 *loops = arg;
+  while (true) {
+    (*loops)++;
+  }
+}
+
+static int start_periodic(PeriodicTask *t) {
+  int res = scheduler_create_task_pid(PF_KTHREAD, (u64)&periodic, (u64)t, DEFAULT_PRIORITY, &t->pid);
+  if (res != 0) {
+    return res;
+  }
+
+  struct SchedAttr attr = {
+    .policy = SCHED_DEADLINE,
+    .runtime_ns = t->runtime_ms * NSEC_PER_MSEC,
+    .deadline_ns = t->period_ms * NSEC_PER_MSEC,
+    .period_ns = t->period_ms * NSEC_PER_MSEC,
+  };
+  return scheduler_set_attr(t->pid, &attr);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the EDF sample. EL: %d\n\r", el);
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  static volatile u64 hog_loops = 0;
+  if (scheduler_create_task(PF_KTHREAD, (u64)&hog, (u64)&hog_loops, MAX_PRIORITY) != 0) {
+    log("ERROR: Failed to start the background task\n\r");
+    return;
+  }
+
+  for (int i = 0; i < NUM_PERIODIC; i++) {
+    int res = start_periodic(&periodic_tasks[i]);
+    if (res != 0) {
+      log("ERROR: Failed to start %s. Error: %d\n\r", periodic_tasks[i].name, res);
+      return;
+    }
+  }
+
+  // Another 40% does not fit under SCHED_DL_BANDWIDTH_LIMIT and must be refused
+  struct SchedAttr greedy = {
+    .policy = SCHED_DEADLINE,
+    .runtime_ns = 40 * NSEC_PER_MSEC,
+    .deadline_ns = 100 * NSEC_PER_MSEC,
+    .period_ns = 100 * NSEC_PER_MSEC,
+  };
+  int res = scheduler_set_attr(current->pid, &greedy);
+  log("Admission of a further 40%% reservation: %s (%d)\n\r", res == -2 ? "rejected" : "ACCEPTED", res);
+
+  u64 end = timer_get_ticks() + (u64)TEST_SECONDS * CLOCK_HZ;
+  while (timer_get_ticks() < end) {
+    schedule();
+  }
+
+  log("\n\r===== EDF PERIODIC TASKS (%d s) =====\n\r", TEST_SECONDS);
+  log("task      budget_ms  period_ms  jobs  activations  misses  overruns  worst_response_us\n\r");
+  for (int i = 0; i < NUM_PERIODIC; i++) {
+    PeriodicTask *t = &periodic_tasks[i];
+    struct TaskBlock *p = scheduler_find_task(t->pid);
+
+    log("%s  %ld  %ld  %ld  %ld  %ld  %ld  %ld\n\r", t->name, t->runtime_ms, t->period_ms, t->jobs, p->dl.activations,
+        p->dl.misses, p->dl.overruns, t->worst_response_us);
+  }
+  log("Background loops: %ld\n\r", hog_loops);
+
+  while (1) {
+  }
+}
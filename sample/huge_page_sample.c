@@ -0,0 +1,173 @@
+#include "address_space.h"
+#include "kernel.h"
+#include "log.h"
+#include "mini_uart.h"
+#include "mmu.h"
+#include "page_alloc.h"
+#include "utils.h"
+#include "video.h"
+#include "virtual_malloc.h"
+
+/* A 1080p 32bpp frame (8100KB) in the reserved background buffer, which stands in for the framebuffer so
+ * the test does not depend on the firmware. It is mapped twice: once page by page, the way a 4KB-only
+ * page table layer would, and once through vmap, which uses 2MB blocks */
+
+#define SCREEN_WIDTH 1920U
+#define SCREEN_HEIGHT 1080U
+#define SCREEN_PITCH (SCREEN_WIDTH * 4U)
+#define SCREEN_SIZE (SCREEN_PITCH * SCREEN_HEIGHT)
+#define ROUNDS 4
+
+/* The default 2MB heap cannot hold an aligned order-9 block, so the sample hands the memory manager 16MB of
+ * unused low memory instead. It starts on a 2MB boundary past the video buffers */
+#define POOL_START (LOW_MEMORY + (48 * MB))
+#define POOL_SIZE (16 * MB)
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Row order, like video_draw_rectangle: every 4KB page is entered once per frame */
+static void fill_rows(u8 *buffer, u32 color) {
+  for (u32 y = 0; y < SCREEN_HEIGHT; y++) {
+    u32 *row = (u32 *)(buffer + y * SCREEN_PITCH);
+    for (u32 x = 0; x < SCREEN_WIDTH; x++) {
+      row[x] = color;
+    }
+  }
+}
+
+/* Column order, like drawing vertical bars: the pitch is larger than a page, so every pixel is on a new 4KB page */
+static void fill_columns(u8 *buffer, u32 color) {
+  for (u32 x = 0; x < SCREEN_WIDTH; x++) {
+    for (u32 y = 0; y < SCREEN_HEIGHT; y++) {
+      ((u32 *)(buffer + y * SCREEN_PITCH))[x] = color;
+    }
+  }
+}
+
+static void run_fill(char *name, u8 *buffer, void (*fill)(u8 *, u32)) {
+  pmu_config_event(0, PMU_EVENT_L1D_TLB_REFILL);
+  u64 refills = pmu_read_event(0);
+  u64 start = pmu_read_cycles();
+
+  for (u32 i = 0; i < ROUNDS; i++) {
+    fill(buffer, 0xFF000000U | i);
+  }
+
+  u64 cycles = pmu_read_cycles() - start;
+  refills = pmu_read_event(0) - refills;
+
+  log("  %s: %ld cycles/frame, %ld L1D TLB refills/frame\n\r", name, cycles / ROUNDS, refills / ROUNDS);
+}
+
+static void benchmark_small_pages(u64 pa) {
+  struct AddressSpace *as = address_space_create();
+  if (!as) {
+    log("  Failed to create the scratch address space\n\r");
+    return;
+  }
+
+  for (u64 offset = 0; offset < SCREEN_SIZE; offset += PAGE_SIZE) {
+    if (mmu_map_page(as->pgd, USER_VA_START + offset, pa + offset, PAGE_USER) != SUCCESS) {
+      log("  Failed to map page 0x%lx\n\r", offset);
+      break;
+    }
+  }
+  mmu_sync_tables();
+
+  address_space_switch(as);
+
+  run_fill("4KB pages, rows", (u8 *)USER_VA_START, fill_rows);
+  run_fill("4KB pages, columns", (u8 *)USER_VA_START, fill_columns);
+
+  /* The frame is not owned by the address space, so it must not reach address_space_destroy */
+  for (u64 offset = 0; offset < SCREEN_SIZE; offset += PAGE_SIZE) {
+    mmu_unmap_page(as->pgd, USER_VA_START + offset);
+  }
+  address_space_flush_tlb(as);
+
+  address_space_switch_kernel();
+  address_space_destroy(as);
+}
+
+static void benchmark_huge_pages(u64 pa) {
+  u8 *buffer = vmap(pa, SCREEN_SIZE, PAGE_KERNEL);
+  if (!buffer) {
+    log("  vmap failed\n\r");
+    return;
+  }
+
+  /* Everything past the last 2MB boundary of the frame is still mapped with pages */
+  u64 blocks = 0;
+  for (u64 offset = 0; offset < SCREEN_SIZE; offset += PAGE_SIZE) {
+    if (!mmu_walk(mmu_kernel_pgd(), (u64)buffer + offset, false)) {
+      blocks++;
+    }
+  }
+  log("  vmap at 0x%lx, %ld of %ld pages covered by 2MB blocks\n\r", (u64)buffer, blocks, SCREEN_SIZE / PAGE_SIZE);
+
+  run_fill("2MB pages, rows", buffer, fill_rows);
+  run_fill("2MB pages, columns", buffer, fill_columns);
+
+  vfree(buffer);
+}
+
+/* The pool given to mm_init holds whole 2MB blocks, so the chunk should be mapped as one */
+static void check_vmalloc_huge(void) {
+  u8 *buffer = vmalloc_huge(HUGE_PAGE_SIZE);
+  if (!buffer) {
+    log("  vmalloc_huge failed\n\r");
+    return;
+  }
+
+  bool huge = (mmu_walk(mmu_kernel_pgd(), (u64)buffer, false) == NULL);
+  for (u64 i = 0; i < HUGE_PAGE_SIZE; i += PAGE_SIZE) {
+    buffer[i] = (u8)(i >> PAGE_SHIFT);
+  }
+
+  log("  vmalloc_huge at 0x%lx backed by %s\n\r", (u64)buffer, huge ? "a 2MB block" : "4KB pages");
+  if (!huge) {
+    log("  ERROR: No aligned 2MB block was free\n\r");
+  }
+
+  vfree(buffer);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+
+  pmu_init();
+
+  // Before anything allocates, the heap would be used otherwise
+  if (mm_init((void *)POOL_START, POOL_SIZE) != SUCCESS) {
+    log("ERROR: Failed to initialize the memory pool\n\r");
+  }
+
+  mmu_init();
+  mmu_enable_dcache();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== HUGE PAGE FRAMEBUFFER BENCHMARK =====\n\r");
+  log("%dx%d 32bpp frame, %d rounds\n\r", SCREEN_WIDTH, SCREEN_HEIGHT, ROUNDS);
+
+  benchmark_small_pages(BG32_MEM_LOCATION);
+  benchmark_huge_pages(BG32_MEM_LOCATION);
+  check_vmalloc_huge();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
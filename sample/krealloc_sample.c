@@ -0,0 +1,168 @@
+#include "kernel.h"
+#include "kernel_malloc.h"
+#include "log.h"
+#include "mem_utils.h"
+#include "mini_uart.h"
+#include "utils.h"
+
+#define GROWTH_STEP 512
+#define GROWTH_LIMIT (256 * 1024)
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+typedef struct {
+  u64 resizes;
+  u64 in_place;
+  u64 bytes_copied;
+  u64 bytes_avoided;
+  bool corrupted;
+} GrowthStats;
+
+/* Every resize that returns the same pointer saved a copy of the whole old buffer */
+static void *grow(void *buf, size_t old_size, size_t new_size, GrowthStats *stats) {
+  void *new_buf = krealloc(buf, new_size);
+  if (!new_buf) {
+    return NULL;
+  }
+
+  stats->resizes++;
+  if (new_buf == buf) {
+    stats->in_place++;
+    stats->bytes_avoided += old_size;
+  } else {
+    stats->bytes_copied += old_size;
+  }
+
+  for (size_t i = 0; i < old_size; i++) {
+    if (((u8 *)new_buf)[i] != (u8)i) {
+      stats->corrupted = true;
+      break;
+    }
+  }
+
+  for (size_t i = old_size; i < new_size; i++) {
+    ((u8 *)new_buf)[i] = (u8)i;
+  }
+
+  return new_buf;
+}
+
+static void report(char *name, GrowthStats *stats) {
+  log("  %s: %ld resizes, %ld in place\n\r", name, stats->resizes, stats->in_place);
+  log("    bytes copied: %ld, copy bytes avoided: %ld\n\r", stats->bytes_copied, stats->bytes_avoided);
+  if (stats->corrupted) {
+    log("    ERROR: data corruption detected after resize\n\r");
+  }
+}
+
+/* Linear growth models log staging / HCI reassembly buffers that append a packet at a time */
+void benchmark_linear_growth() {
+  GrowthStats stats = { 0 };
+  size_t size = GROWTH_STEP;
+  u8 *buf = kmalloc(size);
+  if (!buf) {
+    log("  Failed to allocate initial buffer\n\r");
+    return;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    buf[i] = (u8)i;
+  }
+
+  while (size < GROWTH_LIMIT) {
+    u8 *new_buf = grow(buf, size, size + GROWTH_STEP, &stats);
+    if (!new_buf) {
+      log("  krealloc failed at %d bytes\n\r", size + GROWTH_STEP);
+      break;
+    }
+    buf = new_buf;
+    size += GROWTH_STEP;
+  }
+
+  kfree(buf);
+  report("Linear growth", &stats);
+}
+
+/* Doubling growth models pipe buffers that grow geometrically */
+void benchmark_doubling_growth() {
+  GrowthStats stats = { 0 };
+  size_t size = 16;
+  u8 *buf = kmalloc(size);
+  if (!buf) {
+    log("  Failed to allocate initial buffer\n\r");
+    return;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    buf[i] = (u8)i;
+  }
+
+  while (size < GROWTH_LIMIT) {
+    u8 *new_buf = grow(buf, size, size * 2, &stats);
+    if (!new_buf) {
+      log("  krealloc failed at %d bytes\n\r", size * 2);
+      break;
+    }
+    buf = new_buf;
+    size *= 2;
+  }
+
+  kfree(buf);
+  report("Doubling growth", &stats);
+}
+
+/* A second allocation of the same order lands on the upper buddy, blocking in-place growth */
+void benchmark_blocked_growth() {
+  GrowthStats stats = { 0 };
+  size_t size = 2 * PAGE_SIZE;
+  u8 *buf = kmalloc(size);
+  void *blocker = kmalloc(2 * PAGE_SIZE);
+  if (!buf || !blocker) {
+    log("  Failed to allocate initial buffers\n\r");
+    kfree(buf);
+    kfree(blocker);
+    return;
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    buf[i] = (u8)i;
+  }
+
+  u8 *new_buf = grow(buf, size, 4 * PAGE_SIZE, &stats);
+  if (new_buf) {
+    buf = new_buf;
+  }
+
+  kfree(blocker);
+  kfree(buf);
+  report("Blocked growth", &stats);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== KREALLOC GROWTH BENCHMARK =====\n\r");
+
+  benchmark_linear_growth();
+  benchmark_doubling_growth();
+  benchmark_blocked_growth();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
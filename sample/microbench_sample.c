@@ -0,0 +1,225 @@
+#include "address_space.h"
+#include "arm64_pmu.h"
+#include "bcm2711_cpu.h"
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "scheduler.h"
+#include "syscalls.h"
+#include "timer.h"
+#include "utils.h"
+#include "wait_queue.h"
+
+/* Build with make SAMPLE=microbench_sample and compare the tables before and after scheduler or entry path changes */
+#define NUM_SAMPLES 500
+
+/* Code and data that run at EL0 are placed in the .user section and copied into each address space */
+#define USER_CODE __attribute__((section(".user.text")))
+
+extern char __user_begin[];
+extern char __user_end[];
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Shared between the EL0 task and the kernel, lives in one page of the user heap */
+struct UserBench {
+  volatile u64 done; /**< Set by the user task once all samples are taken */
+  volatile u64 ack;  /**< Set by the kernel once the samples are copied, the page goes away with the task */
+  u64 samples[NUM_SAMPLES];
+};
+
+static u64 samples[NUM_SAMPLES];
+
+static WaitQueue ping_wq = WAIT_QUEUE_INIT;
+static WaitQueue pong_wq = WAIT_QUEUE_INIT;
+static WaitQueue done_wq = WAIT_QUEUE_INIT;
+static volatile bool pong_turn = false;
+static volatile u64 ping_stamp = 0;
+static volatile u32 tasks_done = 0;
+
+static volatile u64 irq_stamp = 0;
+static struct UserBench *volatile user_bench = NULL;
+
+static void sort_samples(u64 *values, u32 count) {
+  for (u32 i = 1U; i < count; i++) {
+    u64 value = values[i];
+    u32 j = i;
+    while (j > 0U && values[j - 1U] > value) {
+      values[j] = values[j - 1U];
+      j--;
+    }
+    values[j] = value;
+  }
+}
+
+static void report(char *name, u64 *values) {
+  sort_samples(values, NUM_SAMPLES);
+  log("%s  %ld  %ld  %ld  %ld\n\r", name, values[0], values[NUM_SAMPLES / 2U], values[(NUM_SAMPLES * 99U) / 100U],
+      values[NUM_SAMPLES - 1U]);
+}
+
+static void task_done(void) {
+  tasks_done++;
+  wake_up_all(&done_wq);
+  scheduler_exit_task();
+}
+
+/* Stamps the cycle counter and hands the CPU to pong, which measures how long it took to get there */
+void ping(void *arg) {
+  for (u32 i = 0U; i < NUM_SAMPLES; i++) {
+    ping_stamp = pmu_read_cycles();
+    pong_turn = true;
+    wake_up(&pong_wq);
+    wait_event(&ping_wq, !pong_turn);
+  }
+
+  task_done();
+}
+
+void pong(void *arg) {
+  for (u32 i = 0U; i < NUM_SAMPLES; i++) {
+    wait_event(&pong_wq, pong_turn);
+    samples[i] = pmu_read_cycles() - ping_stamp;
+    pong_turn = false;
+    wake_up(&ping_wq);
+  }
+
+  task_done();
+}
+
+static void benchmark_ping_pong(void) {
+  tasks_done = 0U;
+  pong_turn = false;
+
+  if (scheduler_create_task(PF_KTHREAD, (u64)&pong, 0, DEFAULT_PRIORITY) != 0 ||
+      scheduler_create_task(PF_KTHREAD, (u64)&ping, 0, DEFAULT_PRIORITY) != 0) {
+    log("ERROR: Failed to create the ping-pong tasks\n\r");
+    return;
+  }
+
+  wait_event(&done_wq, tasks_done == 2U);
+  report("switch   ", samples);
+}
+
+/* Runs at EL0, so it reads the cycle counter directly instead of calling the kernel side helpers */
+USER_CODE static void user_null_syscall(struct UserBench *bench) {
+  u64 start;
+  u64 end;
+
+  for (u32 i = 0U; i < NUM_SAMPLES; i++) {
+    asm volatile("isb; mrs %0, pmccntr_el0" : "=r"(start)::"memory");
+    call_sys_getpid();
+    asm volatile("isb; mrs %0, pmccntr_el0" : "=r"(end)::"memory");
+    bench->samples[i] = end - start;
+  }
+
+  bench->done = 1U;
+  while (!bench->ack) {
+  }
+
+  call_sys_exit(0);
+}
+
+static void user_task_launcher(u64 arg) {
+  if (move_task_to_user_mode((u64)__user_begin, (u64)(__user_end - __user_begin), (u64)&user_null_syscall) != 0) {
+    log("ERROR: Failed to move task to user mode\n\r");
+    scheduler_exit_task();
+  }
+
+  // One heap page carries the samples back, the kernel reaches it through its own pointer
+  u64 va = address_space_brk(current->mm, PAGE_SIZE);
+  struct UserBench *bench = va ? address_space_alloc_page(current->mm, va, PAGE_USER) : NULL;
+  if (!bench) {
+    log("ERROR: Failed to map the result page\n\r");
+    scheduler_exit_task();
+  }
+
+  get_current_pstate(current)->regs[0] = va;
+  user_bench = bench;
+}
+
+static void benchmark_null_syscall(void) {
+  if (scheduler_create_task(PF_KTHREAD, (u64)&user_task_launcher, 0, DEFAULT_PRIORITY) != 0) {
+    log("ERROR: Failed to create the user task\n\r");
+    return;
+  }
+
+  while (!user_bench || !user_bench->done) {
+    msleep(1);
+  }
+
+  for (u32 i = 0U; i < NUM_SAMPLES; i++) {
+    samples[i] = user_bench->samples[i];
+  }
+  user_bench->ack = 1U;
+
+  report("syscall  ", samples);
+}
+
+static void ipi_hook(void) {
+  irq_stamp = pmu_read_cycles();
+}
+
+/* A reschedule IPI sent to this CPU goes through the same vectors and handle_irq as any device interrupt */
+static void benchmark_irq(void) {
+  static u64 round_trip[NUM_SAMPLES];
+  u32 cpu = get_cpu_id();
+
+  irq_set_ipi_hook(ipi_hook);
+  for (u32 i = 0U; i < NUM_SAMPLES; i++) {
+    irq_stamp = 0U;
+    u64 start = pmu_read_cycles();
+    irq_send_reschedule(cpu);
+    while (!irq_stamp) {
+    }
+    u64 end = pmu_read_cycles();
+
+    samples[i] = irq_stamp - start;
+    round_trip[i] = end - start;
+  }
+  irq_set_ipi_hook(NULL);
+
+  report("irq entry", samples);
+  report("irq round", round_trip);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("Hello! Welcome to the microbenchmark sample. EL: %d\n\r", el);
+
+  pmu_init();
+  pmu_enable_user_access();
+  mmu_init();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== ENTRY PATH MICROBENCHMARKS (%d samples, boot CPU only, cycles) =====\n\r", NUM_SAMPLES);
+  log("benchmark  min  median  p99  max\n\r");
+
+  benchmark_ping_pong();
+  benchmark_null_syscall();
+  benchmark_irq();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
@@ -0,0 +1,232 @@
+#include "arm64_atomic.h"
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mmu.h"
+#include "mutex.h"
+#include "sched_class.h"
+#include "scheduler.h"
+#include "spinlock.h"
+#include "timer.h"
+#include "utils.h"
+#include "wait_queue.h"
+
+#define NUM_WORKERS 8
+#define ITERATIONS 2000
+#define CRITICAL_LOOPS 2000
+#define OUTSIDE_LOOPS 2000
+#define HOLD_MS 50
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+static struct Spinlock spin = SPIN_LOCK_INIT;
+static Mutex mutex = MUTEX_INIT;
+static Mutex pi_mutex = MUTEX_INIT;
+static Mutex other_mutex = MUTEX_INIT;
+static WaitQueue done_wq = WAIT_QUEUE_INIT;
+static volatile u64 workers_done = 0;
+static volatile u64 shared_counter = 0;
+static volatile bool hogs_stop = false;
+
+/* Policy and priority of the owner while it is waited on, after the contended unlock and after the last one */
+static volatile u32 owner_policy[3];
+static volatile long owner_priority[3];
+
+static void busy_loop(u32 loops) {
+  for (volatile u32 i = 0U; i < loops; i++) {
+  }
+}
+
+static void worker_done(void) {
+  atomic_add_return(&workers_done, 1U);
+  wake_up_all(&done_wq);
+  scheduler_exit_task();
+}
+
+/* Waiters keep spinning while the holder is preempted, which burns their whole timeslice */
+void spin_worker(void *arg) {
+  for (u32 i = 0U; i < ITERATIONS; i++) {
+    spin_lock(&spin);
+    shared_counter++;
+    busy_loop(CRITICAL_LOOPS);
+    spin_unlock(&spin);
+    busy_loop(OUTSIDE_LOOPS);
+  }
+
+  worker_done();
+}
+
+/* Waiters sleep, so the CPU goes to the holder or to a task with work outside the lock */
+void mutex_worker(void *arg) {
+  for (u32 i = 0U; i < ITERATIONS; i++) {
+    mutex_lock(&mutex);
+    shared_counter++;
+    busy_loop(CRITICAL_LOOPS);
+    mutex_unlock(&mutex);
+    busy_loop(OUTSIDE_LOOPS);
+  }
+
+  worker_done();
+}
+
+/* Time all online CPUs spent idle, in nanoseconds */
+static u64 total_idle_ns(void) {
+  struct SchedCpuStats stats;
+  u64 idle_ns = 0U;
+
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    scheduler_get_cpu_stats(cpu, &stats);
+    idle_ns += stats.idle_ns;
+  }
+
+  return idle_ns;
+}
+
+static void run_contention(char *name, void (*worker)(void *)) {
+  shared_counter = 0U;
+  workers_done = 0U;
+
+  u64 idle_start = total_idle_ns();
+  u64 start = sched_clock();
+
+  u64 started = 0U;
+  for (u32 i = 0U; i < NUM_WORKERS; i++) {
+    int res = scheduler_create_task(PF_KTHREAD, (u64)worker, 0U, DEFAULT_PRIORITY);
+    if (res != 0) {
+      log("ERROR: Failed to start worker %d. Error: %d\n\r", i, res);
+      break;
+    }
+    started++;
+  }
+
+  wait_event(&done_wq, workers_done == started);
+
+  u64 elapsed = sched_clock() - start;
+  u64 idle = min(total_idle_ns() - idle_start, elapsed * scheduler_num_online_cpus());
+  u64 ops = shared_counter;
+
+  log("  %s  %ld ms  %ld ops/s  idle %ld permille  counter %s\n\r", name, elapsed / NSEC_PER_MSEC,
+      (ops * NSEC_PER_SEC) / elapsed, (idle * 1000U) / (elapsed * scheduler_num_online_cpus()),
+      ops == started * ITERATIONS ? "ok" : "CORRUPT");
+}
+
+static void record_owner(u32 slot) {
+  owner_policy[slot] = current->policy;
+  owner_priority[slot] = current->priority;
+}
+
+/* A SCHED_NORMAL owner, which the round-robin hogs would starve unless it inherits the waiter's policy. It takes a
+ * second mutex while boosted and releases them out of order */
+void pi_low(void *arg) {
+  mutex_lock(&pi_mutex);
+  *(volatile bool *)arg = true;
+  while (!(pi_mutex.owner & MUTEX_HAS_WAITERS)) {
+    schedule();
+  }
+  record_owner(0U);
+
+  mutex_lock(&other_mutex);
+  msleep(HOLD_MS);
+  mutex_unlock(&pi_mutex);
+  record_owner(1U);
+  mutex_unlock(&other_mutex);
+  record_owner(2U);
+
+  worker_done();
+}
+
+void pi_high(void *arg) {
+  // Also set by the creator, whichever comes first. It has to wait as a round-robin task
+  scheduler_set_policy(current->pid, SCHED_RR, MAX_PRIORITY - 1);
+
+  u64 start = sched_clock();
+  mutex_lock(&pi_mutex);
+  u64 waited = sched_clock() - start;
+  mutex_unlock(&pi_mutex);
+  hogs_stop = true;
+
+  log("  round-robin task waited %ld ms for a %d ms critical section\n\r", waited / NSEC_PER_MSEC, HOLD_MS);
+  worker_done();
+}
+
+void pi_hog(void *arg) {
+  while (!hogs_stop) {
+  }
+
+  worker_done();
+}
+
+static char *policy_name(u32 policy) {
+  return policy == SCHED_RR ? "SCHED_RR" : policy == SCHED_DEADLINE ? "SCHED_DEADLINE" : "SCHED_NORMAL";
+}
+
+static void start_rr_task(void (*fn)(void *), long priority, u64 *started) {
+  u32 pid;
+  if (scheduler_create_task_pid(PF_KTHREAD, (u64)fn, 0U, DEFAULT_PRIORITY, &pid) == 0) {
+    scheduler_set_policy(pid, SCHED_RR, priority);
+    (*started)++;
+  }
+}
+
+void run_priority_inheritance() {
+  volatile bool low_holds = false;
+  u64 started = 1U;
+  workers_done = 0U;
+  hogs_stop = false;
+
+  scheduler_create_task(PF_KTHREAD, (u64)&pi_low, (u64)&low_holds, DEFAULT_PRIORITY);
+  while (!low_holds) {
+    schedule();
+  }
+
+  // Round-robin hogs on every CPU leave no time to fair tasks until the waiter got the mutex
+  start_rr_task(pi_high, MAX_PRIORITY - 1, &started);
+  for (u32 i = 0U; i < scheduler_num_online_cpus(); i++) {
+    start_rr_task(pi_hog, MAX_PRIORITY - 2, &started);
+  }
+
+  wait_event(&done_wq, workers_done == started);
+  log("  owner (SCHED_NORMAL %d) while waited on: %s %ld\n\r", DEFAULT_PRIORITY, policy_name(owner_policy[0]),
+      owner_priority[0]);
+  log("  after releasing the contended mutex first: %s %ld, after the other one: %s %ld\n\r",
+      policy_name(owner_policy[1]), owner_priority[1], policy_name(owner_policy[2]), owner_priority[2]);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the mutex contention sample. EL: %d\n\r", el);
+
+  // Secondary cores need cacheable memory for their locks. Nothing here shares buffers with the VideoCore
+  mmu_init();
+  mmu_enable_dcache();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+  u32 online = scheduler_smp_init();
+
+  log("\n\r===== LOCK CONTENTION (%d workers, %d CPUs) =====\n\r", NUM_WORKERS, online);
+  run_contention("spinlock", spin_worker);
+  run_contention("mutex   ", mutex_worker);
+
+  log("\n\r===== PRIORITY INHERITANCE =====\n\r");
+  run_priority_inheritance();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+    msleep(1000);
+  }
+}
@@ -20,7 +20,7 @@ void handle_uart0_irq() {}
 void process(void *arg) {
   while (true) {
     log("%s", arg);
-    timer_sleep(100);
+    msleep(100);
   }
 }
 
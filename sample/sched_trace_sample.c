@@ -0,0 +1,144 @@
+#include "arm64_atomic.h"
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mmu.h"
+#include "sched_class.h"
+#include "sched_trace.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "utils.h"
+#include "wait_queue.h"
+
+#define NUM_HOGS 3
+#define HOG_MS 2000
+#define SLEEPER_ROUNDS 100
+#define SLEEPER_MS 5
+#define PING_PONG_ROUNDS 200
+#define YIELD_ROUNDS 10000
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+static WaitQueue ping_wq = WAIT_QUEUE_INIT;
+static WaitQueue pong_wq = WAIT_QUEUE_INIT;
+static WaitQueue done_wq = WAIT_QUEUE_INIT;
+static volatile u64 ball = 0;
+static volatile u64 tasks_done = 0;
+
+static void task_done(void) {
+  atomic_add_return(&tasks_done, 1U);
+  wake_up_all(&done_wq);
+  scheduler_exit_task();
+}
+
+/* Never blocks, so it only leaves the CPU when its timeslice runs out */
+void hog(void *arg) {
+  u64 end = sched_clock() + HOG_MS * NSEC_PER_MSEC;
+  while (sched_clock() < end) {
+  }
+
+  task_done();
+}
+
+/* Short sleeps, every one ends with a wakeup that has to wait for the hogs */
+void sleeper(void *arg) {
+  for (u32 i = 0U; i < SLEEPER_ROUNDS; i++) {
+    msleep(SLEEPER_MS);
+  }
+
+  task_done();
+}
+
+/* Hands the ball back and forth with pong through two wait queues */
+void ping(void *arg) {
+  for (u64 i = 0U; i < PING_PONG_ROUNDS; i++) {
+    ball = 2U * i + 1U;
+    wake_up(&pong_wq);
+    wait_event(&ping_wq, ball == 2U * i + 2U);
+  }
+
+  task_done();
+}
+
+void pong(void *arg) {
+  for (u64 i = 0U; i < PING_PONG_ROUNDS; i++) {
+    wait_event(&pong_wq, ball == 2U * i + 1U);
+    ball = 2U * i + 2U;
+    wake_up(&ping_wq);
+  }
+
+  task_done();
+}
+
+/* Cost of schedule() with nothing else to run, compare a SCHED_TRACE=1 build against a normal one */
+void benchmark_yield_cost() {
+  u64 start = sched_clock();
+  for (u32 i = 0U; i < YIELD_ROUNDS; i++) {
+    schedule();
+  }
+  u64 elapsed = sched_clock() - start;
+
+  log("  schedule() x %d: %ld ns each\n\r", YIELD_ROUNDS, elapsed / YIELD_ROUNDS);
+}
+
+void run_workload() {
+  void (*tasks[])(void *) = { sleeper, ping, pong };
+  u64 num_tasks = 0U;
+
+  for (u32 i = 0U; i < NUM_HOGS; i++) {
+    if (scheduler_create_task(PF_KTHREAD, (u64)&hog, 0U, DEFAULT_PRIORITY) == 0) {
+      num_tasks++;
+    }
+  }
+  for (u32 i = 0U; i < sizeof(tasks) / sizeof(tasks[0]); i++) {
+    if (scheduler_create_task(PF_KTHREAD, (u64)tasks[i], 0U, DEFAULT_PRIORITY) == 0) {
+      num_tasks++;
+    }
+  }
+
+  wait_event(&done_wq, tasks_done == num_tasks);
+  log("  %ld tasks finished\n\r", num_tasks);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the scheduler trace sample. EL: %d\n\r", el);
+
+  // Secondary cores need cacheable memory for their locks. Nothing here shares buffers with the VideoCore
+  mmu_init();
+  mmu_enable_dcache();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+  scheduler_smp_init();
+
+  log("\n\r===== TRACE OVERHEAD =====\n\r");
+  benchmark_yield_cost();
+
+  log("\n\r===== MIXED WORKLOAD =====\n\r");
+  sched_trace_reset();
+  run_workload();
+
+  // Build with make SCHED_TRACE=1, otherwise both print nothing. Feed the dump to tools/sched_trace_decode.py
+  sched_trace_report();
+  sched_trace_dump();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+    msleep(1000);
+  }
+}
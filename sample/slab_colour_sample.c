@@ -0,0 +1,132 @@
+#include "kernel.h"
+#include "kernel_malloc.h"
+#include "log.h"
+#include "mini_uart.h"
+#include "mmu.h"
+#include "utils.h"
+
+/* Cache effects only show once the MMU and data cache are enabled, which kernel_init does. Without them
+ * every data access bypasses the cache and both layouts run at memory speed */
+
+#define NODES 384
+#define ROUNDS 16
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* 48 byte node: the link and the hot field are 40 bytes apart, so an unaligned node usually spans two lines */
+typedef struct ChaseNode {
+  struct ChaseNode *next;
+  u64 cold[4];
+  u64 hot;
+} ChaseNode;
+
+static ChaseNode *nodes[NODES];
+
+/* Simple LCG so the shuffle is repeatable without a libc */
+static u32 lcg_state = 12345U;
+static u32 lcg_next(void) {
+  lcg_state = lcg_state * 1103515245U + 12345U;
+  return lcg_state >> 8;
+}
+
+static ChaseNode *build_chain(void *(*alloc)(size_t)) {
+  for (u32 i = 0; i < NODES; i++) {
+    nodes[i] = alloc(sizeof(ChaseNode));
+    if (!nodes[i]) {
+      log("  Allocation %d failed\n\r", i);
+      return NULL;
+    }
+    nodes[i]->hot = i;
+  }
+
+  /* Link the nodes in a random order so the hardware prefetcher cannot follow the chain */
+  lcg_state = 12345U;
+  for (u32 i = NODES - 1; i > 0; i--) {
+    u32 j = lcg_next() % (i + 1);
+    ChaseNode *tmp = nodes[i];
+    nodes[i] = nodes[j];
+    nodes[j] = tmp;
+  }
+
+  for (u32 i = 0; i < NODES; i++) {
+    nodes[i]->next = nodes[(i + 1) % NODES];
+  }
+
+  return nodes[0];
+}
+
+static void free_chain(void) {
+  for (u32 i = 0; i < NODES; i++) {
+    kfree(nodes[i]);
+    nodes[i] = NULL;
+  }
+}
+
+static void run_chase(char *name, void *(*alloc)(size_t)) {
+  ChaseNode *head = build_chain(alloc);
+  if (!head) {
+    free_chain();
+    return;
+  }
+
+  u32 straddling = 0;
+  for (u32 i = 0; i < NODES; i++) {
+    u64 start = (u64)nodes[i];
+    if ((start / CACHE_LINE_SIZE) != ((start + sizeof(ChaseNode) - 1) / CACHE_LINE_SIZE)) {
+      straddling++;
+    }
+  }
+
+  pmu_config_event(0, PMU_EVENT_L1D_CACHE_REFILL);
+  u64 refills = pmu_read_event(0);
+  u64 start = pmu_read_cycles();
+
+  u64 sum = 0;
+  ChaseNode *node = head;
+  for (u32 i = 0; i < NODES * ROUNDS; i++) {
+    sum += node->hot;
+    node = node->next;
+  }
+
+  u64 cycles = pmu_read_cycles() - start;
+  refills = pmu_read_event(0) - refills;
+
+  log("  %s: %d/%d nodes straddle a line, %ld cycles/node, %ld L1D refills (checksum %ld)\n\r", name, straddling, NODES,
+      cycles / (NODES * ROUNDS), refills, sum);
+
+  free_chain();
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+
+  pmu_init();
+
+  mmu_init();
+  mmu_enable_dcache();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== SLAB POINTER-CHASE BENCHMARK =====\n\r");
+  log("%d nodes of %d bytes, %d rounds\n\r", NODES, sizeof(ChaseNode), ROUNDS);
+
+  run_chase("kmalloc (48 byte class)", kmalloc);
+  run_chase("kmalloc_cache_aligned", kmalloc_cache_aligned);
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
@@ -0,0 +1,186 @@
+#include "arm64_atomic.h"
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mmu.h"
+#include "sched_class.h"
+#include "scheduler.h"
+#include "spinlock.h"
+#include "timer.h"
+#include "utils.h"
+#include "wait_queue.h"
+
+#define SLEEP_ROUNDS 50
+#define SLEEP_MS 10
+#define BUSY_MS 500
+#define NUM_CONSUMERS 3
+#define NUM_ITEMS 30
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+static WaitQueue items_wq = WAIT_QUEUE_INIT;
+static WaitQueue done_wq = WAIT_QUEUE_INIT;
+static struct Spinlock items_lock = SPIN_LOCK_INIT;
+static volatile u32 items = 0;
+static volatile bool producer_done = false;
+static volatile u64 consumers_done = 0;
+static u64 consumed[NUM_CONSUMERS];
+
+/* Time all online CPUs spent idle, in nanoseconds */
+static u64 total_idle_ns(void) {
+  struct SchedCpuStats stats;
+  u64 idle_ns = 0U;
+
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    scheduler_get_cpu_stats(cpu, &stats);
+    idle_ns += stats.idle_ns;
+  }
+
+  return idle_ns;
+}
+
+static u64 idle_permille(u64 idle_start, u64 clock_start) {
+  u64 elapsed = (sched_clock() - clock_start) * scheduler_num_online_cpus();
+  u64 idle = min(total_idle_ns() - idle_start, elapsed);
+  return (idle * 1000U) / elapsed;
+}
+
+static bool take_item(void) {
+  bool taken = false;
+
+  spin_lock(&items_lock);
+  if (items > 0U) {
+    items--;
+    taken = true;
+  }
+  spin_unlock(&items_lock);
+
+  return taken;
+}
+
+/* Blocks on the wait queue whenever there is nothing to consume, so it uses no CPU time while waiting */
+void consumer(void *arg) {
+  u64 *count = arg;
+
+  while (1) {
+    wait_event(&items_wq, items > 0U || producer_done);
+    if (take_item()) {
+      (*count)++;
+    } else if (producer_done) {
+      break;
+    }
+  }
+
+  atomic_add_return(&consumers_done, 1U);
+  wake_up_all(&done_wq);
+  scheduler_exit_task();
+}
+
+/* Sleeps between items, so the consumers only run when an item arrived */
+void producer(void *arg) {
+  for (u32 i = 0U; i < NUM_ITEMS; i++) {
+    msleep(SLEEP_MS);
+
+    spin_lock(&items_lock);
+    items++;
+    spin_unlock(&items_lock);
+    wake_up(&items_wq);
+  }
+
+  producer_done = true;
+  wake_up_all(&items_wq);
+  scheduler_exit_task();
+}
+
+void benchmark_sleep_accuracy() {
+  u64 min_over = ~0ULL;
+  u64 max_over = 0U;
+  u64 total_over = 0U;
+  u64 idle_start = total_idle_ns();
+  u64 clock_start = sched_clock();
+
+  for (u32 i = 0U; i < SLEEP_ROUNDS; i++) {
+    u64 start = sched_clock();
+    msleep(SLEEP_MS);
+    u64 over = sched_clock() - start - SLEEP_MS * NSEC_PER_MSEC;
+
+    min_over = min(min_over, over);
+    max_over = max(max_over, over);
+    total_over += over;
+  }
+
+  log("  msleep(%d) x %d: overshoot min %ld us, avg %ld us, max %ld us\n\r", SLEEP_MS, SLEEP_ROUNDS,
+      min_over / NSEC_PER_USEC, total_over / SLEEP_ROUNDS / NSEC_PER_USEC, max_over / NSEC_PER_USEC);
+  log("  CPUs idle while sleeping: %ld permille\n\r", idle_permille(idle_start, clock_start));
+
+  idle_start = total_idle_ns();
+  clock_start = sched_clock();
+  timer_sleep(BUSY_MS);
+  log("  CPUs idle during busy timer_sleep(%d): %ld permille\n\r", BUSY_MS, idle_permille(idle_start, clock_start));
+}
+
+void benchmark_wait_queue() {
+  u64 idle_start = total_idle_ns();
+  u64 clock_start = sched_clock();
+
+  for (u32 i = 0U; i < NUM_CONSUMERS; i++) {
+    int res = scheduler_create_task(PF_KTHREAD, (u64)&consumer, (u64)&consumed[i], DEFAULT_PRIORITY);
+    if (res != 0) {
+      log("ERROR: Failed to start consumer %d. Error: %d\n\r", i, res);
+      return;
+    }
+  }
+
+  int res = scheduler_create_task(PF_KTHREAD, (u64)&producer, 0U, DEFAULT_PRIORITY);
+  if (res != 0) {
+    log("ERROR: Failed to start the producer. Error: %d\n\r", res);
+    return;
+  }
+
+  wait_event(&done_wq, consumers_done == NUM_CONSUMERS);
+
+  u64 total = 0U;
+  for (u32 i = 0U; i < NUM_CONSUMERS; i++) {
+    log("  consumer %d took %ld items\n\r", i, consumed[i]);
+    total += consumed[i];
+  }
+  log("  %ld of %d items consumed, CPUs idle %ld permille\n\r", total, NUM_ITEMS, idle_permille(idle_start, clock_start));
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the sleep and wait queue sample. EL: %d\n\r", el);
+
+  // Secondary cores need cacheable memory for their locks. Nothing here shares buffers with the VideoCore
+  mmu_init();
+  mmu_enable_dcache();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+  scheduler_smp_init();
+
+  log("\n\r===== SLEEP ACCURACY =====\n\r");
+  benchmark_sleep_accuracy();
+
+  log("\n\r===== WAIT QUEUE PRODUCER / CONSUMER =====\n\r");
+  benchmark_wait_queue();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+    msleep(1000);
+  }
+}
@@ -0,0 +1,156 @@
+#include "arm64_atomic.h"
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mmu.h"
+#include "sched_class.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "utils.h"
+
+#define MAX_WORKERS 8
+#define ROUND_SECONDS 5
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Worker counts per round. Run with make sim SMP=1 to 4 to compare core counts */
+static const u32 round_workers[] = { 1, 2, 4, 8 };
+#define NUM_ROUNDS (sizeof(round_workers) / sizeof(round_workers[0]))
+
+/* One cache line per worker, so the counters do not bounce between cores */
+typedef struct {
+  volatile u64 loops;
+  u8 pad[56];
+} __attribute__((aligned(64))) WorkerSlot;
+
+static WorkerSlot slots[MAX_WORKERS];
+static volatile bool round_over = false;
+static volatile u64 workers_done = 0;
+
+/* CPU-bound worker, it never blocks so its throughput only depends on how many CPUs it gets */
+void worker(void *arg) {
+  WorkerSlot *slot = arg;
+
+  while (!round_over) {
+    slot->loops++;
+  }
+
+  atomic_add_return(&workers_done, 1U);
+  scheduler_exit_task();
+}
+
+static void snapshot_stats(struct SchedCpuStats *stats) {
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    scheduler_get_cpu_stats(cpu, &stats[cpu]);
+  }
+}
+
+/* Runs one round and returns the combined loops per second */
+static u64 run_round(u32 num_workers, u64 baseline) {
+  struct SchedCpuStats before[NUM_CPUS];
+  struct SchedCpuStats after[NUM_CPUS];
+
+  for (u32 i = 0U; i < num_workers; i++) {
+    slots[i].loops = 0U;
+  }
+  round_over = false;
+  workers_done = 0U;
+
+  snapshot_stats(before);
+  u64 start = timer_get_ticks();
+
+  for (u32 i = 0U; i < num_workers; i++) {
+    int res = scheduler_create_task(PF_KTHREAD, (u64)&worker, (u64)&slots[i], MAX_PRIORITY);
+    if (res != 0) {
+      log("ERROR: Failed to start worker %d. Error: %d\n\r", i, res);
+      num_workers = i;
+      break;
+    }
+  }
+
+  // The main task runs at the lowest weight and only yields, so it takes little from the workers
+  while (timer_get_ticks() - start < (u64)ROUND_SECONDS * CLOCK_HZ) {
+    schedule();
+  }
+
+  u64 total = 0U;
+  u64 min_loops = ~0ULL;
+  u64 max_loops = 0U;
+  for (u32 i = 0U; i < num_workers; i++) {
+    u64 loops = slots[i].loops;
+    total += loops;
+    min_loops = min(min_loops, loops);
+    max_loops = max(max_loops, loops);
+  }
+  u64 elapsed = timer_get_ticks() - start;
+  snapshot_stats(after);
+
+  round_over = true;
+  while (workers_done < num_workers) {
+    schedule();
+  }
+
+  u64 migrations = 0U;
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    migrations += after[cpu].migrations - before[cpu].migrations;
+  }
+
+  u64 rate = (total * CLOCK_HZ) / elapsed;
+  log("%d  %ld  %ld  %ld  %ld\n\r", num_workers, rate, baseline ? (rate * 100U) / baseline : 100U,
+      max_loops ? (min_loops * 1000U) / max_loops : 0U, migrations);
+
+  u64 elapsed_ns = elapsed * (NSEC_PER_SEC / CLOCK_HZ);
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    u64 idle_ns = min(after[cpu].idle_ns - before[cpu].idle_ns, elapsed_ns);
+    log("    cpu%d  busy %ld permille  switches %ld  pulled %ld  load_x100 %ld  ticks %ld\n\r", cpu,
+        ((elapsed_ns - idle_ns) * 1000U) / elapsed_ns, after[cpu].switches - before[cpu].switches,
+        after[cpu].migrations - before[cpu].migrations, (after[cpu].load_avg * 100U) / SCHED_LOAD_SCALE,
+        after[cpu].ticks - before[cpu].ticks);
+  }
+
+  return rate;
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the SMP scaling sample. EL: %d\n\r", el);
+
+  // Secondary cores need cacheable memory for their locks. Nothing here shares buffers with the VideoCore
+  mmu_init();
+  mmu_enable_dcache();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  u32 online = scheduler_smp_init();
+  scheduler_set_policy(0, SCHED_NORMAL, MIN_PRIORITY);
+
+  log("\n\r===== SMP THROUGHPUT SCALING (%d CPUs online, %d s per round) =====\n\r", online, ROUND_SECONDS);
+  log("workers  loops/s  speedup_x100  fairness_permille  migrations\n\r");
+
+  u64 baseline = 0U;
+  for (u32 round = 0U; round < NUM_ROUNDS; round++) {
+    u64 rate = run_round(round_workers[round], baseline);
+    if (round == 0U) {
+      baseline = rate;
+    }
+  }
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
@@ -0,0 +1,120 @@
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "mmu.h"
+#include "pid.h"
+#include "sched_class.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "utils.h"
+
+#define CHURN_ROUNDS 2000
+#define BATCH_SIZE 8
+/* More stacks than the cache holds are freed together, so the overflow goes back to the page allocator */
+#define DETACH_BURST (4U * TASK_STACK_CACHE_SIZE)
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Short-lived worker, exits with the value it was given */
+void worker(void *arg) {
+  task_exit((long)arg);
+}
+
+/* Creates BATCH_SIZE joinable workers at a time and collects their exit codes. With stacks, task blocks and PIDs
+ * recycled, the task count and highest PID stay flat however many rounds run */
+void benchmark_churn() {
+  u32 pids[BATCH_SIZE];
+  u32 tasks_before = nr_tasks;
+  u32 max_pid = 0U;
+  u32 bad_codes = 0U;
+  u32 failures = 0U;
+  u64 start = sched_clock();
+
+  for (u32 round = 0U; round < CHURN_ROUNDS; round++) {
+    for (u32 i = 0U; i < BATCH_SIZE; i++) {
+      long code = (long)(round * BATCH_SIZE + i);
+      if (scheduler_create_task_pid(PF_KTHREAD | PF_JOINABLE, (u64)&worker, (u64)code, DEFAULT_PRIORITY, &pids[i]) != 0) {
+        pids[i] = PID_NONE;
+        failures++;
+        continue;
+      }
+      max_pid = max(max_pid, pids[i]);
+    }
+
+    for (u32 i = 0U; i < BATCH_SIZE; i++) {
+      long code;
+      if (pids[i] == PID_NONE) {
+        continue;
+      }
+      if (task_wait(pids[i], &code) != 0 || code != (long)(round * BATCH_SIZE + i)) {
+        bad_codes++;
+      }
+    }
+  }
+
+  u64 elapsed = sched_clock() - start;
+  u32 tasks = CHURN_ROUNDS * BATCH_SIZE;
+
+  log("  %d tasks created and joined, %ld ns per task\n\r", tasks, elapsed / tasks);
+  log("  create failures: %d, wrong exit codes: %d\n\r", failures, bad_codes);
+  log("  live tasks before: %d, after: %d, highest PID: %d\n\r", tasks_before, nr_tasks, max_pid);
+}
+
+/* Detached workers are freed without anybody waiting for them. Far more stacks pass through the page allocator
+ * than it holds, so a stack that is not given back shows up as create failures */
+void benchmark_detached() {
+  u32 tasks_before = nr_tasks;
+  u32 failures = 0U;
+
+  for (u32 i = 0U; i < CHURN_ROUNDS; i++) {
+    if (scheduler_create_task(PF_KTHREAD, (u64)&worker, 0U, DEFAULT_PRIORITY) != 0) {
+      failures++;
+    }
+    if (i % DETACH_BURST == DETACH_BURST - 1U) {
+      msleep(10);
+    }
+  }
+
+  // Give the workers time to exit and the idle CPUs time to reap them
+  msleep(100);
+  log("  %d detached tasks, create failures: %d, live tasks before: %d, after: %d\n\r", CHURN_ROUNDS, failures,
+      tasks_before, nr_tasks);
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  int el = get_el();
+  log("Hello! Welcome to the task churn sample. EL: %d\n\r", el);
+
+  // Secondary cores need cacheable memory for their locks. Nothing here shares buffers with the VideoCore
+  mmu_init();
+  mmu_enable_dcache();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+}
+
+void kernel_main() {
+  kernel_init();
+  scheduler_smp_init();
+
+  log("\n\r===== JOINABLE TASK CHURN =====\n\r");
+  benchmark_churn();
+
+  log("\n\r===== DETACHED TASK CHURN =====\n\r");
+  benchmark_detached();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+    msleep(1000);
+  }
+}
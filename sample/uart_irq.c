@@ -4,15 +4,33 @@
 #include "irq.h"
 #include "kernel.h"
 #include "log.h"
+#include "mempool.h"
 #include "utils.h"
 
+#define RX_BUFFER_SIZE 32
+#define RX_RING_SIZE 16
+#define RX_RESERVED_BUFFERS 8
+
 UartSettings settings = {
   .uart = UART0,
   .tx = 14,
   .rx = 15,
 };
 
-char ch = 0U;
+typedef struct {
+  u32 len;
+  char data[RX_BUFFER_SIZE];
+} RxBuffer;
+
+/* RX buffers come from a reserved pool, so the IRQ handler never calls kmalloc */
+struct Mempool *rx_pool = NULL;
+
+/* Single producer (IRQ) / single consumer (main loop) ring of filled buffers */
+RxBuffer *volatile rx_ring[RX_RING_SIZE];
+volatile u32 rx_head = 0U;
+volatile u32 rx_tail = 0U;
+volatile u32 rx_dropped = 0U;
+
 uint8_t flag = 0;
 
 void handle_uart0_irq() {
@@ -21,7 +39,30 @@ void handle_uart0_irq() {
   if (settings.uart->mis & (1 << 4)) {
     flag = 2;
     settings.uart->icr |= (1 << 4);
-    ch = settings.uart->dr & 0xFF;
+
+    RxBuffer *buf = mempool_alloc(rx_pool);
+    if (!buf) {
+      /* Reserve exhausted, drain the FIFO so the interrupt does not fire again */
+      while (uart_read_ready()) {
+        (void)settings.uart->dr;
+        rx_dropped++;
+      }
+    } else {
+      buf->len = 0U;
+      while (uart_read_ready() && buf->len < RX_BUFFER_SIZE) {
+        buf->data[buf->len++] = settings.uart->dr & 0xFF;
+      }
+
+      u32 next = (rx_head + 1U) % RX_RING_SIZE;
+      if (next == rx_tail) {
+        rx_dropped += buf->len;
+        mempool_free(rx_pool, buf);
+      } else {
+        rx_ring[rx_head] = buf;
+        dmb();
+        rx_head = next;
+      }
+    }
   }
 
   /* If TX interrupt. */
@@ -40,6 +81,12 @@ void kernel_init() {
   int el = get_el();
   log("Hello! Welcome to UART IRQ sample app. EL: %d\n\r", el);
 
+  rx_pool = mempool_create(sizeof(RxBuffer), RX_RESERVED_BUFFERS);
+  if (!rx_pool) {
+    log("ERROR: Failed to reserve RX buffers\n\r");
+    return;
+  }
+
   irq_init_vectors();
   enable_interrupt_controller();
   irq_enable();
@@ -49,14 +96,32 @@ void kernel_main() {
   kernel_init();
   log("Kernel initialized. Enter characters into PuTTY monitor:\n\r");
 
+  u32 reported_drops = 0U;
+
   while (1) {
     if (flag) {
       log("Flag updated: %d\r\n", flag);
       flag = 0;
     }
-    if (ch) {
-      uart_transmit(ch);
-      ch = 0U;
+
+    while (rx_tail != rx_head) {
+      RxBuffer *buf = rx_ring[rx_tail];
+      for (u32 i = 0; i < buf->len; i++) {
+        uart_transmit(buf->data[i]);
+      }
+      mempool_free(rx_pool, buf);
+      dmb();
+      rx_tail = (rx_tail + 1U) % RX_RING_SIZE;
+    }
+
+    if (rx_dropped != reported_drops) {
+      reported_drops = rx_dropped;
+      log("\n\rRX dropped %d bytes\n\r", reported_drops);
+    }
+
+    /* Refilling calls kmalloc, so it only ever happens here in process context */
+    if (rx_pool && mempool_needs_refill(rx_pool)) {
+      mempool_refill(rx_pool);
     }
   }
 }
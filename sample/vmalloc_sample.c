@@ -0,0 +1,117 @@
+#include "buddy.h"
+#include "kernel.h"
+#include "kernel_malloc.h"
+#include "log.h"
+#include "mini_uart.h"
+#include "utils.h"
+#include "virtual_malloc.h"
+
+/* Enough entries to take every page of the default 2 MB pool */
+#define MAX_PAGES 512
+#define BUFFER_SIZE (64 * 1024)
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+static struct Page *pages[MAX_PAGES];
+static u32 num_pinned = 0;
+
+/* Take every free page, then free every other one, so no free block is larger than one page */
+static void fragment_pool() {
+  u32 count = 0;
+
+  while (count < MAX_PAGES) {
+    pages[count] = buddy_alloc_pages(0);
+    if (!pages[count]) {
+      break;
+    }
+    count++;
+  }
+
+  for (u32 i = 0; i < count; i++) {
+    if (i % 2 == 0) {
+      buddy_free_pages(pages[i]);
+    } else {
+      pages[num_pinned++] = pages[i];
+    }
+  }
+
+  log("  Pinned %d of %d pages\n\r", num_pinned, count);
+}
+
+static void release_pool() {
+  for (u32 i = 0; i < num_pinned; i++) {
+    buddy_free_pages(pages[i]);
+  }
+  num_pinned = 0;
+}
+
+static bool fill_and_check(u8 *buf, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    buf[i] = (u8)(i * 7);
+  }
+
+  for (size_t i = 0; i < size; i++) {
+    if (buf[i] != (u8)(i * 7)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+static void run(char *name, void *(*alloc_fn)(size_t), void (*free_fn)(void *)) {
+  u64 start = pmu_read_cycles();
+  u8 *buf = alloc_fn(BUFFER_SIZE);
+  u64 alloc_cycles = pmu_read_cycles() - start;
+
+  if (!buf) {
+    log("  %s: allocation of %d bytes failed\n\r", name, BUFFER_SIZE);
+    return;
+  }
+
+  bool ok = fill_and_check(buf, BUFFER_SIZE);
+
+  start = pmu_read_cycles();
+  free_fn(buf);
+  u64 free_cycles = pmu_read_cycles() - start;
+
+  log("  %s: 0x%lx, alloc %ld cycles, free %ld cycles, data %s\n\r", name, (u64)buf, alloc_cycles, free_cycles,
+      ok ? "ok" : "CORRUPTED");
+}
+
+void kernel_init() {
+  uart_init(&settings);
+
+  log_init(LOG_MODE_UART);
+
+  int el = get_el();
+
+  log("QEMU Test: Kernel booted at EL%d\n\r", el);
+
+  pmu_init();
+}
+
+void kernel_main() {
+  kernel_init();
+
+  log("\n\r===== VMALLOC FRAGMENTATION BENCHMARK =====\n\r");
+
+  log("Unfragmented pool:\n\r");
+  run("kmalloc", kmalloc, kfree);
+  run("vmalloc", vmalloc, vfree);
+
+  log("Fragmented pool:\n\r");
+  fragment_pool();
+  run("kmalloc", kmalloc, kfree);
+  run("vmalloc", vmalloc, vfree);
+  release_pool();
+
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
@@ -0,0 +1,159 @@
+#include "arm64_atomic.h"
+#include "arm64_pmu.h"
+#include "common.h"
+#include "irq.h"
+#include "kernel.h"
+#include "log.h"
+#include "scheduler.h"
+#include "timer.h"
+#include "utils.h"
+#include "workqueue.h"
+
+#define EVENT_HZ 2000
+#define PHASE_MS 3000
+#define REPORT_MS 1000
+#define NUM_EVENTS 16
+#define EVENT_BYTES 2048
+
+UartSettings settings = {
+  .uart = UART0,
+  .tx = 14,
+  .rx = 15,
+};
+
+/* Stands in for buffers a device filled, one per outstanding event */
+static u8 event_data[NUM_EVENTS][EVENT_BYTES];
+static struct Work event_works[NUM_EVENTS];
+static struct Workqueue event_wq;
+static struct DelayedWork report_work;
+
+static volatile bool events_on = false;
+static volatile bool defer = false;
+static volatile bool reporting = false;
+static volatile u64 irqs = 0;
+static volatile u64 processed = 0;
+static volatile u64 coalesced = 0;
+static volatile u64 max_handler_cycles = 0;
+static volatile u32 checksum = 0;
+
+/* The slow part of the handler, like parsing an HCI event or refilling a buffer */
+static void process_event(u8 *data) {
+  u32 sum = 0U;
+  for (u32 i = 0U; i < EVENT_BYTES; i++) {
+    sum = sum * 31U + data[i];
+  }
+
+  checksum ^= sum;
+  atomic_add_return(&processed, 1U);
+}
+
+static void event_work_fn(struct Work *work) {
+  process_event(work->data);
+}
+
+/* Timer 1 plays the device. Deferring leaves only the acknowledgement, done by handle_timer_irq, in IRQ context */
+static void event_irq(void) {
+  if (!events_on) {
+    return;
+  }
+
+  u64 start = pmu_read_cycles();
+  u32 slot = irqs % NUM_EVENTS;
+  irqs++;
+  event_data[slot][0] = (u8)irqs;
+
+  if (defer) {
+    // The worker has not taken the previous event from this slot yet, it will see the new data as well
+    if (!queue_work(&event_wq, &event_works[slot])) {
+      coalesced++;
+    }
+  } else {
+    process_event(event_data[slot]);
+  }
+
+  max_handler_cycles = max(max_handler_cycles, pmu_read_cycles() - start);
+}
+
+/* Flushing the log is slow too, so progress is reported from the system workqueue */
+static void report_work_fn(struct Work *work) {
+  log("    irqs %ld  processed %ld  coalesced %ld\n\r", irqs, processed, coalesced);
+  if (reporting) {
+    schedule_delayed_work(&report_work, REPORT_MS * 1000U);
+  }
+}
+
+static void run_phase(char *name, bool deferred) {
+  u64 items = event_wq.cpus[0].items;
+  u64 batches = event_wq.cpus[0].batches;
+
+  irqs = 0U;
+  processed = 0U;
+  coalesced = 0U;
+  max_handler_cycles = 0U;
+  defer = deferred;
+
+  log("\n\r%s:\n\r", name);
+  reporting = true;
+  schedule_delayed_work(&report_work, REPORT_MS * 1000U);
+
+  events_on = true;
+  msleep(PHASE_MS);
+  events_on = false;
+
+  reporting = false;
+  cancel_delayed_work(&report_work);
+  msleep(10);
+
+  log("  handler max %ld cycles, %ld events, %ld processed, %ld coalesced\n\r", max_handler_cycles, irqs, processed,
+      coalesced);
+  if (deferred) {
+    items = event_wq.cpus[0].items - items;
+    batches = event_wq.cpus[0].batches - batches;
+    log("  worker ran %ld items in %ld batches, %ld per batch x100\n\r", items, batches,
+        batches ? (items * 100U) / batches : 0U);
+  }
+}
+
+void kernel_init() {
+  uart_init(&settings);
+  log_init(LOG_MODE_UART);
+  int el = get_el();
+  log("Hello! Welcome to the workqueue sample. EL: %d\n\r", el);
+
+  pmu_init();
+
+  irq_init_vectors();
+  enable_interrupt_controller();
+  irq_enable();
+
+  scheduler_init();
+
+  if (system_workqueue_init(DEFAULT_PRIORITY) != 0) {
+    log("ERROR: Failed to start the system workqueue\n\r");
+  }
+  // Event processing runs ahead of every fair task, like a threaded IRQ handler would
+  if (workqueue_init(&event_wq, SCHED_RR, MAX_PRIORITY) != 0) {
+    log("ERROR: Failed to start the event workqueue\n\r");
+  }
+}
+
+void kernel_main() {
+  kernel_init();
+
+  for (u32 i = 0U; i < NUM_EVENTS; i++) {
+    work_init(&event_works[i], event_work_fn, event_data[i]);
+  }
+  delayed_work_init(&report_work, report_work_fn, NULL);
+
+  log("\n\r===== DEFERRED WORK (%d events/s, %d bytes each) =====\n\r", EVENT_HZ, EVENT_BYTES);
+  timer_init(1, CLOCK_HZ / EVENT_HZ, event_irq);
+
+  run_phase("Processing in the IRQ handler", false);
+  run_phase("Processing in a workqueue", true);
+
+  log("\n\rchecksum 0x%x\n\r", checksum);
+  log("\n\r===== BENCHMARK COMPLETE =====\n\r");
+
+  while (1) {
+  }
+}
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+"""Decode a sched_trace_dump() capture into a timeline and a per-task summary.
+
+Usage: sched_trace_decode.py [--chrome out.json] [--summary-only] capture.log
+
+The capture is the raw serial output of a SCHED_TRACE=1 build, anything outside the
+SCHED_TRACE BEGIN / END markers is ignored. --chrome writes a trace that opens in
+chrome://tracing or ui.perfetto.dev, with one row per CPU.
+"""
+
+import argparse
+import json
+import re
+import sys
+from collections import defaultdict
+
+# Keep in sync with SchedTraceType and SchedTraceReason in lib/inc/sched_trace.h
+SWITCH, WAKEUP, TICK, PREEMPT_OFF, IRQ_OFF = range(5)
+REASONS = ["preempt", "yield", "sleep", "exit"]
+
+BEGIN_RE = re.compile(r"SCHED_TRACE BEGIN freq=(\d+) cpus=(\d+)")
+EVENT_RE = re.compile(r"^E (\d+) ([0-9a-fA-F]+) (\d+) ([0-9a-fA-F]+) ([0-9a-fA-F]+)")
+DROPPED_RE = re.compile(r"^D (\d+) (\d+)")
+
+
+def parse(lines):
+    """Returns the counter frequency, the events sorted by time and the events lost per CPU."""
+    freq = None
+    events = []
+    dropped = {}
+    inside = False
+
+    for line in lines:
+        line = line.strip()
+        match = BEGIN_RE.search(line)
+        if match:
+            # Only the last dump of the capture is decoded
+            freq = int(match.group(1))
+            events = []
+            dropped = {}
+            inside = True
+            continue
+        if not inside:
+            continue
+        if "SCHED_TRACE END" in line:
+            inside = False
+            continue
+
+        match = EVENT_RE.match(line)
+        if match:
+            cpu, ts, kind, arg0, arg1 = match.groups()
+            events.append((int(ts, 16), int(cpu), int(kind), int(arg0, 16), int(arg1, 16)))
+            continue
+
+        match = DROPPED_RE.match(line)
+        if match:
+            dropped[int(match.group(1))] = int(match.group(2))
+
+    if freq is None:
+        sys.exit("no SCHED_TRACE BEGIN marker found")
+
+    events.sort()
+    return freq, events, dropped
+
+
+def describe(kind, arg0, arg1, freq):
+    if kind == SWITCH:
+        reason = arg1 >> 32
+        reason = REASONS[reason] if reason < len(REASONS) else str(reason)
+        return "switch   pid %d -> pid %d (%s)" % (arg0, arg1 & 0xFFFFFFFF, reason)
+    if kind == WAKEUP:
+        return "wakeup   pid %d on cpu%d" % (arg0, arg1)
+    if kind == TICK:
+        return "tick     pid %d" % arg0
+    if kind == PREEMPT_OFF:
+        return "preempt off %.1f us, enabled at 0x%x" % (arg0 * 1e6 / freq, arg1)
+    if kind == IRQ_OFF:
+        return "irq off  %.1f us, unmasked at 0x%x" % (arg0 * 1e6 / freq, arg1)
+    return "unknown type %d (%x %x)" % (kind, arg0, arg1)
+
+
+class TaskStats:
+    def __init__(self):
+        self.run_ticks = 0
+        self.runs = 0
+        self.preempted = 0
+        self.wakeups = 0
+        self.wakeup_latency = []
+
+
+def summarize(freq, events):
+    """Replays the switches to attribute CPU time and wakeup latency to every PID."""
+    tasks = defaultdict(TaskStats)
+    running = {}  # cpu -> (pid, start)
+    woken = {}  # pid -> wakeup time
+    slices = []  # (cpu, pid, start, end)
+
+    for ts, cpu, kind, arg0, arg1 in events:
+        if kind == WAKEUP:
+            tasks[arg0].wakeups += 1
+            woken[arg0] = ts
+        elif kind == SWITCH:
+            prev, nxt, reason = arg0, arg1 & 0xFFFFFFFF, arg1 >> 32
+            if cpu in running and running[cpu][0] == prev:
+                start = running[cpu][1]
+                tasks[prev].run_ticks += ts - start
+                slices.append((cpu, prev, start, ts))
+            if reason == 0:
+                tasks[prev].preempted += 1
+            tasks[nxt].runs += 1
+            if nxt in woken:
+                tasks[nxt].wakeup_latency.append(ts - woken.pop(nxt))
+            running[cpu] = (nxt, ts)
+
+    return tasks, slices
+
+
+def print_timeline(freq, events, dropped):
+    for cpu, count in sorted(dropped.items()):
+        print("cpu%d: %d older events were overwritten" % (cpu, count))
+
+    base = events[0][0] if events else 0
+    for ts, cpu, kind, arg0, arg1 in events:
+        print("%12.3f us  cpu%d  %s" % ((ts - base) * 1e6 / freq, cpu, describe(kind, arg0, arg1, freq)))
+
+
+def print_summary(freq, events, tasks):
+    span = events[-1][0] - events[0][0] if len(events) > 1 else 0
+    print("\nTrace covers %.3f ms" % (span * 1e3 / freq))
+    print("%6s %12s %6s %9s %8s %14s %14s" % ("pid", "cpu_ms", "runs", "preempted", "wakeups", "wake_avg_us",
+                                             "wake_max_us"))
+    for pid in sorted(tasks):
+        stats = tasks[pid]
+        latency = stats.wakeup_latency
+        avg = sum(latency) / len(latency) * 1e6 / freq if latency else 0.0
+        worst = max(latency) * 1e6 / freq if latency else 0.0
+        print("%6d %12.3f %6d %9d %8d %14.1f %14.1f" % (pid, stats.run_ticks * 1e3 / freq, stats.runs, stats.preempted,
+                                                        stats.wakeups, avg, worst))
+
+
+def write_chrome(path, freq, events, slices):
+    base = events[0][0] if events else 0
+    trace = []
+
+    for cpu, pid, start, end in slices:
+        trace.append({"name": "pid %d" % pid, "ph": "X", "pid": 0, "tid": cpu, "ts": (start - base) * 1e6 / freq,
+                      "dur": (end - start) * 1e6 / freq})
+
+    for ts, cpu, kind, arg0, arg1 in events:
+        if kind in (WAKEUP, PREEMPT_OFF, IRQ_OFF):
+            trace.append({"name": describe(kind, arg0, arg1, freq), "ph": "i", "s": "t", "pid": 0, "tid": cpu,
+                          "ts": (ts - base) * 1e6 / freq})
+
+    with open(path, "w") as out:
+        json.dump({"traceEvents": trace, "displayTimeUnit": "ns"}, out)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode a sched_trace_dump() capture")
+    parser.add_argument("capture", help="serial log holding the dump, - for stdin")
+    parser.add_argument("--chrome", metavar="FILE", help="also write a Chrome trace event file")
+    parser.add_argument("--summary-only", action="store_true", help="skip the timeline")
+    args = parser.parse_args()
+
+    source = sys.stdin if args.capture == "-" else open(args.capture, errors="replace")
+    with source:
+        freq, events, dropped = parse(source)
+
+    tasks, slices = summarize(freq, events)
+    if not args.summary_only:
+        print_timeline(freq, events, dropped)
+    print_summary(freq, events, tasks)
+
+    if args.chrome:
+        write_chrome(args.chrome, freq, events, slices)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,61 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   lz4.h
+ *
+ * @brief  LZ4 block format compression API
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+#include "common.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup CompressionUtils Compression Utilities
+ * @brief    Libraries to compress and decompress buffers
+ * @{
+ */
+
+/** @brief  Largest input lz4_compress accepts, so match positions fit the 16-bit hash table */
+#define LZ4_MAX_INPUT_SIZE 0xFFFFU
+
+/** @brief  Largest block lz4_compress can produce for an input size, reached by incompressible data */
+#define LZ4_COMPRESS_BOUND(size) ((size) + (size) / 255U + 16U)
+
+/** @brief  Bits of the match finder hash */
+#define LZ4_HASH_BITS 12U
+
+/** @brief  Size in bytes of the workspace lz4_compress needs */
+#define LZ4_WORKSPACE_SIZE ((1U << LZ4_HASH_BITS) * sizeof(u16))
+
+/**
+ * @brief   Compress a buffer into an LZ4 block
+ * @details Greedy single pass match finder with a hash table of the last position each 4-byte sequence
+ *          was seen at. The output is a raw block without frame headers, decodable by any LZ4 decoder
+ * @param   src Data to compress
+ * @param   src_size Size of the data, at most LZ4_MAX_INPUT_SIZE
+ * @param   dst Output buffer
+ * @param   dst_capacity Size of the output buffer
+ * @param   workspace LZ4_WORKSPACE_SIZE bytes of scratch memory, 2-byte aligned
+ * @return  Size of the compressed block, 0 if it does not fit in dst_capacity
+ */
+u32 lz4_compress(const u8 *src, u32 src_size, u8 *dst, u32 dst_capacity, void *workspace);
+
+/**
+ * @brief   Decompress an LZ4 block
+ * @details Every length and offset is checked, so a corrupt block cannot write outside dst
+ * @param   src Compressed block
+ * @param   src_size Size of the block
+ * @param   dst Output buffer
+ * @param   dst_capacity Size of the output buffer
+ * @return  Size of the decompressed data, 0 if the block is malformed or does not fit in dst_capacity
+ */
+u32 lz4_decompress(const u8 *src, u32 src_size, u8 *dst, u32 dst_capacity);
+
+/** @} */
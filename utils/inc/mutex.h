@@ -11,12 +11,15 @@
 
 /* Standard library Headers */
 #include <stdbool.h>
+#include <stddef.h>
 
 /* Inter-component Headers */
 #include "arm64_barrier.h"
 #include "common.h"
+#include "scheduler.h"
 
 /* Intra-component Headers */
+#include "spinlock.h"
 
 /**
  * @defgroup ConcurrencyUtils Concurrency Utilities
@@ -24,17 +27,34 @@
  * @{
  */
 
+/** @brief  Set in Mutex.owner while tasks wait, so the owner unlocks through the slow path */
+#define MUTEX_HAS_WAITERS 1UL
+
+/**
+ * @brief   A task waiting for a mutex, lives on the stack of that task
+ */
+struct MutexWaiter {
+  struct TaskBlock *task;   /**< Waiting task */
+  struct MutexWaiter *next; /**< Next waiter, in arrival order */
+};
+
 /**
  * @brief   Mutex storage
  */
-typedef struct {
-  volatile u32 state; /* Lock state: 0 = unlocked, 1 = locked */
-  // TaskId owner;           /* Thread ID of the owner */
-  u32 lock_count;         /* For recursive mutex support (Locking when already locked) */
-  u32 original_priority;  /* Original priority of the owner */
-  struct thread *waiting; /* List of waiting threads */
+typedef struct Mutex {
+  volatile u64 owner;               /**< Owning task, 0 when unlocked. Ored with MUTEX_HAS_WAITERS */
+  u32 lock_count;                   /**< For recursive mutex support (Locking when already locked) */
+  bool recursive;                   /**< The owner may lock again, and unlocks as many times */
+  struct Spinlock wait_lock;        /**< Protects the waiting list and the hand over to the next owner */
+  struct MutexWaiter *waiting;      /**< List of waiting threads, the oldest first */
+  struct MutexWaiter *waiting_tail; /**< Newest waiter */
+  long top_rank;                    /**< Highest scheduler_task_pi_rank among the waiters */
+  struct Mutex *held_next;          /**< Next mutex with waiters held by the same owner */
 } Mutex;
 
+#define MUTEX_INIT { 0U, 0U, false, SPIN_LOCK_INIT, NULL, NULL, SCHED_PI_NONE, NULL }
+#define RECURSIVE_MUTEX_INIT { 0U, 0U, true, SPIN_LOCK_INIT, NULL, NULL, SCHED_PI_NONE, NULL }
+
 /**
  * @brief   Initialize a mutex
  * @param   mutex Pointer to a mutex struct
@@ -42,14 +62,33 @@ typedef struct {
 void mutex_init(Mutex *mutex);
 
 /**
- * @brief Attempt to acquire mutex
- * @return TRUE if successful, FALSE if already locked
+ * @brief   Initialize a mutex its owner may lock again
+ * @param   mutex Pointer to a mutex struct
+ */
+void mutex_init_recursive(Mutex *mutex);
+
+/**
+ * @brief   Acquire the mutex, sleeping while another task holds it
+ * @details Waiters get the mutex in arrival order. While they wait, the owner inherits the policy and priority of
+ *          the highest ranked waiter of every mutex it holds, so a SCHED_RR waiter lifts a SCHED_NORMAL owner into
+ *          SCHED_RR. It falls back once those mutexes are released, in any order. Before the scheduler runs or with
+ *          preemption disabled this spins instead. Must not be called from interrupt handlers
+ * @param   mutex Pointer to a mutex struct
+ * @return  TRUE once the mutex is held, FALSE if the caller already holds a mutex that is not recursive
  */
 bool mutex_lock(Mutex *mutex);
 
 /**
- * @brief Attempt to unlock mutex
- * @return TRUE if successful, FALSE if already locked
+ * @brief   Acquire the mutex only if that does not need waiting
+ * @param   mutex Pointer to a mutex struct
+ * @return  TRUE if successful, FALSE if already locked
+ */
+bool mutex_trylock(Mutex *mutex);
+
+/**
+ * @brief   Release the mutex, handing it to the task that waited longest
+ * @param   mutex Pointer to a mutex struct
+ * @return  TRUE if successful, FALSE if the caller does not hold the mutex
  */
 bool mutex_unlock(Mutex *mutex);
 
@@ -0,0 +1,85 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   rbtree.h
+ *
+ * @brief  Intrusive red-black tree API
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "common.h"
+
+/* Intra-component Headers */
+
+/**
+ * @defgroup DataStructureUtils Data Structure Utilities
+ * @brief    Allocation free containers embedded in the objects they link
+ * @{
+ */
+
+/**
+ * @brief   Tree node, embedded in the object it orders
+ */
+struct RbNode {
+  struct RbNode *parent; /**< Parent node, NULL for the root */
+  struct RbNode *left;   /**< Left child, holds smaller keys */
+  struct RbNode *right;  /**< Right child, holds larger or equal keys */
+  bool red;              /**< Node colour, the root is always black */
+};
+
+/**
+ * @brief   Tree root that caches the leftmost node, so the smallest key is found in O(1)
+ */
+struct RbRoot {
+  struct RbNode *node;     /**< Root node, NULL if the tree is empty */
+  struct RbNode *leftmost; /**< Node with the smallest key, NULL if the tree is empty */
+};
+
+#define RB_ROOT_INIT { NULL, NULL }
+
+/** @brief  Get the object that embeds a tree node */
+#define rb_entry(ptr, type, member) ((type *)((u8 *)(ptr) - offsetof(type, member)))
+
+/**
+ * @brief   Insert a node and rebalance the tree
+ * @details The caller walks down from the root to find the empty child slot the node belongs in, so
+ *          the tree never needs a comparison callback
+ * @param   root Tree to insert into
+ * @param   node Node to insert
+ * @param   parent Parent of the empty slot, NULL if the tree is empty
+ * @param   link Empty child slot of parent, or &root->node if the tree is empty
+ * @param   leftmost TRUE if the walk only went left, making the node the new smallest key
+ */
+void rb_insert(struct RbRoot *root, struct RbNode *node, struct RbNode *parent, struct RbNode **link, bool leftmost);
+
+/**
+ * @brief   Remove a node and rebalance the tree
+ * @param   root Tree the node is in
+ * @param   node Node to remove
+ */
+void rb_erase(struct RbRoot *root, struct RbNode *node);
+
+/**
+ * @brief   Get the node with the smallest key
+ * @param   root Tree to search
+ * @return  Leftmost node or NULL if the tree is empty
+ */
+static inline struct RbNode *rb_first(struct RbRoot *root) {
+  return root->leftmost;
+}
+
+/**
+ * @brief   Get the node with the next larger key
+ * @param   node Current node
+ * @return  In-order successor or NULL if node is the last one
+ */
+struct RbNode *rb_next(struct RbNode *node);
+
+/** @} */
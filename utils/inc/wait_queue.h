@@ -0,0 +1,106 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   wait_queue.h
+ *
+ * @brief  Wait queue API, lets tasks sleep until a condition becomes true
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "irq.h"
+#include "scheduler.h"
+
+/* Intra-component Headers */
+#include "spinlock.h"
+
+/**
+ * @defgroup ConcurrencyUtils Concurrency Utilities
+ * @brief    Libraries to support Concurrency
+ * @{
+ */
+
+/**
+ * @brief   A task waiting on a wait queue, lives on the stack of that task
+ */
+struct WaitQueueEntry {
+  struct TaskBlock *task;      /**< Waiting task */
+  struct WaitQueueEntry *next; /**< Next waiter, in arrival order */
+  bool queued;                 /**< On the queue, cleared once the waiter was woken */
+};
+
+/**
+ * @brief   Wait queue storage
+ */
+typedef struct {
+  struct Spinlock lock;
+  struct WaitQueueEntry *head; /**< Oldest waiter, woken first */
+  struct WaitQueueEntry *tail; /**< Newest waiter */
+} WaitQueue;
+
+#define WAIT_QUEUE_INIT { SPIN_LOCK_INIT, NULL, NULL }
+
+/**
+ * @brief   Initialize a wait queue
+ * @param   wq Pointer to a wait queue
+ */
+void wait_queue_init(WaitQueue *wq);
+
+/**
+ * @brief   Queue the current task and mark it sleeping, ahead of checking the wait condition
+ * @details Must be called with IRQs masked. Queueing before the check means a wake_up that happens after the
+ *          check cannot be missed
+ * @param   wq Wait queue
+ * @param   entry Entry on the stack of the current task
+ */
+void prepare_to_wait(WaitQueue *wq, struct WaitQueueEntry *entry);
+
+/**
+ * @brief   Leave a wait queue once the wait condition is true
+ * @param   wq Wait queue
+ * @param   entry Entry passed to prepare_to_wait
+ */
+void finish_wait(WaitQueue *wq, struct WaitQueueEntry *entry);
+
+/**
+ * @brief   Wake the task that waited longest
+ * @details Safe to call from interrupt handlers and from any CPU
+ * @param   wq Wait queue
+ */
+void wake_up(WaitQueue *wq);
+
+/**
+ * @brief   Wake every waiting task
+ * @param   wq Wait queue
+ */
+void wake_up_all(WaitQueue *wq);
+
+/**
+ * @brief   Sleep until a condition becomes true
+ * @details The condition is checked with IRQs masked, so it must be short and must not block. Whoever makes it
+ *          true calls wake_up or wake_up_all afterwards
+ * @param   wq Pointer to the wait queue
+ * @param   condition Expression to wait for
+ */
+#define wait_event(wq, condition)          \
+  do {                                     \
+    struct WaitQueueEntry __entry = { 0 }; \
+    u64 __flags = irq_save_flags();        \
+    while (1) {                            \
+      prepare_to_wait((wq), &__entry);     \
+      if (condition) {                     \
+        break;                             \
+      }                                    \
+      schedule();                          \
+    }                                      \
+    finish_wait((wq), &__entry);           \
+    irq_restore_flags(__flags);            \
+  } while (0)
+
+/** @} */
@@ -0,0 +1,158 @@
+#pragma once
+
+/*******************************************************************************************************************************
+ * @file   workqueue.h
+ *
+ * @brief  Workqueue API, runs deferred work in per-CPU kernel worker threads
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+
+/* Inter-component Headers */
+#include "common.h"
+#include "scheduler.h"
+
+/* Intra-component Headers */
+#include "spinlock.h"
+#include "wait_queue.h"
+
+/**
+ * @defgroup ConcurrencyUtils Concurrency Utilities
+ * @brief    Libraries to support Concurrency
+ * @{
+ */
+
+/**
+ * @brief   A piece of deferred work, owned by the caller until it ran
+ */
+struct Work {
+  struct Work *next;             /**< Next work queued on the same CPU */
+  void (*fn)(struct Work *work); /**< Runs in a worker thread, may sleep */
+  void *data;                    /**< Argument for fn */
+  volatile u64 pending;          /**< Queued or waiting on its timer, cleared right before fn runs */
+};
+
+#define WORK_INIT(fn, data) { NULL, (fn), (data), 0U }
+
+/**
+ * @brief   Work queued once a delay passed
+ */
+struct DelayedWork {
+  struct Work work;        /**< Queued by the timer */
+  struct SchedTimer timer; /**< Fires on the CPU that scheduled the work */
+  struct Workqueue *wq;    /**< Workqueue the work goes to */
+};
+
+/**
+ * @brief   Work queued on one CPU and the worker thread that runs it
+ */
+struct WorkqueueCpu {
+  struct Spinlock lock;
+  struct Work *head;   /**< Oldest queued work, runs first */
+  struct Work *tail;   /**< Newest queued work */
+  WaitQueue more_work; /**< Worker sleeps here while nothing is queued */
+  u32 pid;             /**< Worker thread */
+  u64 items;           /**< Work items run */
+  u64 batches;         /**< Times the worker took the queue, items / batches is the average batch size */
+} __attribute__((aligned(64)));
+
+/**
+ * @brief   Workqueue storage
+ */
+struct Workqueue {
+  struct WorkqueueCpu cpus[NUM_CPUS];
+};
+
+/** @brief  Shared workqueue used by schedule_work and schedule_delayed_work */
+extern struct Workqueue system_wq;
+
+/**
+ * @brief   Initialize a workqueue and start one worker thread per CPU
+ * @details Each worker is pinned to its CPU. Workers of CPUs that are not online yet run elsewhere until their
+ *          CPU comes up
+ * @param   wq Workqueue storage
+ * @param   policy Scheduling policy of the workers, SCHED_NORMAL or SCHED_RR
+ * @param   priority Priority of the workers, clamped to [MIN_PRIORITY, MAX_PRIORITY]
+ * @return  0 on success, the scheduler_create_task_affinity error if a worker could not be started
+ */
+int workqueue_init(struct Workqueue *wq, u32 policy, long priority);
+
+/**
+ * @brief   Start the workers of system_wq
+ * @param   priority Priority of the workers, they run as SCHED_NORMAL
+ * @return  0 on success, the workqueue_init error otherwise
+ */
+int system_workqueue_init(long priority);
+
+/**
+ * @brief   Initialize a work item
+ * @param   work Work storage
+ * @param   fn Function to run
+ * @param   data Argument for fn
+ */
+void work_init(struct Work *work, void (*fn)(struct Work *work), void *data);
+
+/**
+ * @brief   Queue work on a CPU
+ * @details Safe to call from interrupt handlers. Only the first work queued onto an empty queue wakes the worker,
+ *          everything queued until it runs is taken in the same batch
+ * @param   cpu CPU whose worker runs the work
+ * @param   wq Workqueue
+ * @param   work Work to queue
+ * @return  TRUE if queued, FALSE if it was still pending
+ */
+bool queue_work_on(u32 cpu, struct Workqueue *wq, struct Work *work);
+
+/**
+ * @brief   Queue work on the calling CPU
+ * @param   wq Workqueue
+ * @param   work Work to queue
+ * @return  TRUE if queued, FALSE if it was still pending
+ */
+bool queue_work(struct Workqueue *wq, struct Work *work);
+
+/**
+ * @brief   Queue work on the calling CPU of system_wq
+ * @param   work Work to queue
+ * @return  TRUE if queued, FALSE if it was still pending
+ */
+bool schedule_work(struct Work *work);
+
+/**
+ * @brief   Initialize a delayed work item
+ * @param   dwork Delayed work storage
+ * @param   fn Function to run
+ * @param   data Argument for fn
+ */
+void delayed_work_init(struct DelayedWork *dwork, void (*fn)(struct Work *work), void *data);
+
+/**
+ * @brief   Queue work on the calling CPU once a delay passed
+ * @details Safe to call from interrupt handlers. The delay is rounded up to the next scheduler tick
+ * @param   wq Workqueue
+ * @param   dwork Delayed work to queue
+ * @param   delay_us Microseconds to wait, 0 queues it right away
+ * @return  TRUE if scheduled, FALSE if it was still pending
+ */
+bool queue_delayed_work(struct Workqueue *wq, struct DelayedWork *dwork, u64 delay_us);
+
+/**
+ * @brief   Queue work on the calling CPU of system_wq once a delay passed
+ * @param   dwork Delayed work to queue
+ * @param   delay_us Microseconds to wait, 0 queues it right away
+ * @return  TRUE if scheduled, FALSE if it was still pending
+ */
+bool schedule_delayed_work(struct DelayedWork *dwork, u64 delay_us);
+
+/**
+ * @brief   Stop delayed work whose delay has not passed yet
+ * @param   dwork Delayed work
+ * @return  TRUE if it was cancelled, FALSE if it was not scheduled or is already queued
+ */
+bool cancel_delayed_work(struct DelayedWork *dwork);
+
+/** @} */
@@ -0,0 +1,229 @@
+/*******************************************************************************************************************************
+ * @file   lz4.c
+ *
+ * @brief  LZ4 block format compression source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stdbool.h>
+
+/* Inter-component Headers */
+#include "mem_utils.h"
+
+/* Intra-component Headers */
+#include "lz4.h"
+
+/* Block format limits. Decoders rely on the last 5 bytes being literals, and on no match starting in
+ * the last 12 bytes */
+#define LZ4_MIN_MATCH 4U
+#define LZ4_LAST_LITERALS 5U
+#define LZ4_MF_LIMIT 12U
+#define LZ4_MAX_OFFSET 0xFFFFU
+#define LZ4_RUN_MASK 15U
+
+static inline u32 read32(const u8 *p) {
+  return (u32)p[0] | ((u32)p[1] << 8) | ((u32)p[2] << 16) | ((u32)p[3] << 24);
+}
+
+static inline u32 hash32(u32 sequence) {
+  return (sequence * 2654435761U) >> (32U - LZ4_HASH_BITS);
+}
+
+/**
+ * @brief   Write the extension bytes of a length that does not fit in its token nibble
+ * @param   dst Output buffer
+ * @param   op Current output position, advanced past the written bytes
+ * @param   length Length minus LZ4_RUN_MASK
+ */
+static void write_length(u8 *dst, u32 *op, u32 length) {
+  while (length >= 255U) {
+    dst[(*op)++] = 255U;
+    length -= 255U;
+  }
+  dst[(*op)++] = (u8)length;
+}
+
+/**
+ * @brief   Emit a run of literals followed by an optional match
+ * @param   dst Output buffer
+ * @param   op Current output position, advanced past the sequence
+ * @param   dst_capacity Size of the output buffer
+ * @param   literals First literal byte
+ * @param   literal_size Number of literals
+ * @param   offset Distance back to the match, unused for the last sequence
+ * @param   match_size Match length, 0 for the last sequence
+ * @return  TRUE if the sequence fit in the output buffer
+ */
+static bool write_sequence(u8 *dst, u32 *op, u32 dst_capacity, const u8 *literals, u32 literal_size, u32 offset,
+                           u32 match_size) {
+  /* Worst case: token, length bytes for both fields, literals and offset */
+  u32 worst = 1U + (literal_size / 255U + 1U) + literal_size + 2U + (match_size / 255U + 1U);
+  if (*op + worst > dst_capacity) {
+    return false;
+  }
+
+  u32 match_code = match_size ? match_size - LZ4_MIN_MATCH : 0U;
+  u8 *token = &dst[(*op)++];
+  *token = (u8)((min(literal_size, LZ4_RUN_MASK) << 4) | min(match_code, LZ4_RUN_MASK));
+
+  if (literal_size >= LZ4_RUN_MASK) {
+    write_length(dst, op, literal_size - LZ4_RUN_MASK);
+  }
+
+  memcpy(&dst[*op], literals, literal_size);
+  *op += literal_size;
+
+  if (match_size == 0U) {
+    return true;
+  }
+
+  dst[(*op)++] = (u8)offset;
+  dst[(*op)++] = (u8)(offset >> 8);
+
+  if (match_code >= LZ4_RUN_MASK) {
+    write_length(dst, op, match_code - LZ4_RUN_MASK);
+  }
+
+  return true;
+}
+
+u32 lz4_compress(const u8 *src, u32 src_size, u8 *dst, u32 dst_capacity, void *workspace) {
+  u16 *table = workspace;
+  u32 anchor = 0U;
+  u32 op = 0U;
+
+  if (src_size > LZ4_MAX_INPUT_SIZE) {
+    return 0U;
+  }
+
+  if (src_size > LZ4_MF_LIMIT) {
+    u32 match_limit = src_size - LZ4_MF_LIMIT;
+    u32 extend_limit = src_size - LZ4_LAST_LITERALS;
+    u32 ip = 1U;
+
+    memset(table, 0, LZ4_WORKSPACE_SIZE);
+
+    while (ip < match_limit) {
+      u32 sequence = read32(&src[ip]);
+      u32 h = hash32(sequence);
+      u32 ref = table[h];
+      table[h] = (u16)ip;
+
+      /* The table starts out zeroed, so every candidate is verified against the data */
+      if (ref >= ip || ip - ref > LZ4_MAX_OFFSET || read32(&src[ref]) != sequence) {
+        ip++;
+        continue;
+      }
+
+      /* Take in equal bytes before the match that were emitted as literals */
+      while (ip > anchor && ref > 0U && src[ip - 1U] == src[ref - 1U]) {
+        ip--;
+        ref--;
+      }
+
+      u32 match_size = LZ4_MIN_MATCH;
+      while (ip + match_size < extend_limit && src[ip + match_size] == src[ref + match_size]) {
+        match_size++;
+      }
+
+      if (!write_sequence(dst, &op, dst_capacity, &src[anchor], ip - anchor, ip - ref, match_size)) {
+        return 0U;
+      }
+
+      ip += match_size;
+      anchor = ip;
+
+      /* Index the position just before the next search, which long runs would otherwise skip */
+      if (ip - 2U < match_limit) {
+        table[hash32(read32(&src[ip - 2U]))] = (u16)(ip - 2U);
+      }
+    }
+  }
+
+  if (!write_sequence(dst, &op, dst_capacity, &src[anchor], src_size - anchor, 0U, 0U)) {
+    return 0U;
+  }
+
+  return op;
+}
+
+/**
+ * @brief   Read the extension bytes of a length field
+ * @param   src Compressed block
+ * @param   src_size Size of the block
+ * @param   ip Current input position, advanced past the length bytes
+ * @param   length Length accumulated so far, extended in place
+ * @return  TRUE if the length bytes are complete
+ */
+static bool read_length(const u8 *src, u32 src_size, u32 *ip, u32 *length) {
+  u8 byte;
+
+  do {
+    if (*ip >= src_size) {
+      return false;
+    }
+    byte = src[(*ip)++];
+    *length += byte;
+  } while (byte == 255U);
+
+  return true;
+}
+
+u32 lz4_decompress(const u8 *src, u32 src_size, u8 *dst, u32 dst_capacity) {
+  u32 ip = 0U;
+  u32 op = 0U;
+
+  while (ip < src_size) {
+    u8 token = src[ip++];
+
+    u32 literal_size = token >> 4;
+    if (literal_size == LZ4_RUN_MASK && !read_length(src, src_size, &ip, &literal_size)) {
+      return 0U;
+    }
+
+    if (literal_size > src_size - ip || literal_size > dst_capacity - op) {
+      return 0U;
+    }
+
+    memcpy(&dst[op], &src[ip], literal_size);
+    ip += literal_size;
+    op += literal_size;
+
+    /* The last sequence has no match */
+    if (ip == src_size) {
+      break;
+    }
+
+    if (src_size - ip < 2U) {
+      return 0U;
+    }
+
+    u32 offset = (u32)src[ip] | ((u32)src[ip + 1U] << 8);
+    ip += 2U;
+
+    if (offset == 0U || offset > op) {
+      return 0U;
+    }
+
+    u32 match_size = token & LZ4_RUN_MASK;
+    if (match_size == LZ4_RUN_MASK && !read_length(src, src_size, &ip, &match_size)) {
+      return 0U;
+    }
+    match_size += LZ4_MIN_MATCH;
+
+    if (match_size > dst_capacity - op) {
+      return 0U;
+    }
+
+    /* Byte by byte, since a match may overlap the bytes it is producing */
+    for (u32 i = 0U; i < match_size; i++) {
+      dst[op + i] = dst[op - offset + i];
+    }
+    op += match_size;
+  }
+
+  return op;
+}
@@ -8,10 +8,221 @@
  *******************************************************************************************************************************/
 
 /* Standard library Headers */
+#include <stddef.h>
 
 /* Inter-component Headers */
+#include "arm64_atomic.h"
 #include "hardware.h"
+#include "irq.h"
 #include "scheduler.h"
 
 /* Intra-component Headers */
 #include "mutex.h"
+
+#define mutex_owner(mutex) ((struct TaskBlock *)((mutex)->owner & ~MUTEX_HAS_WAITERS))
+
+/* Before the scheduler runs the boot code is the init task, but tpidr_el1 is still 0 */
+static inline struct TaskBlock *mutex_self(void) {
+  struct TaskBlock *self = current;
+  return self ? self : &init_task;
+}
+
+/* Protects the lists of held mutexes with waiters and the ranks inherited through them. Taken after wait_lock */
+static struct Spinlock pi_lock = SPIN_LOCK_INIT;
+
+/* Called by the new owner with the mutex just acquired */
+static void mutex_acquired(Mutex *mutex, struct TaskBlock *self) {
+  mutex->lock_count = 1U;
+}
+
+/* Must be called with pi_lock held. The task inherits from every mutex it holds, not only the last one it locked,
+ * so releasing them out of order drops exactly the boosts that went away */
+static void pi_update(struct TaskBlock *task) {
+  long rank = SCHED_PI_NONE;
+  for (Mutex *it = task->pi_held; it; it = it->held_next) {
+    rank = max(rank, it->top_rank);
+  }
+
+  if (rank != task->pi_rank) {
+    scheduler_set_pi_rank(task, rank);
+  }
+}
+
+/* Must be called with pi_lock held */
+static void pi_held_remove(struct TaskBlock *task, Mutex *mutex) {
+  Mutex **link = &task->pi_held;
+
+  while (*link && *link != mutex) {
+    link = &(*link)->held_next;
+  }
+
+  if (*link) {
+    *link = mutex->held_next;
+  }
+  mutex->held_next = NULL;
+}
+
+void mutex_init(Mutex *mutex) {
+  mutex->owner = 0U;
+  mutex->lock_count = 0U;
+  mutex->recursive = false;
+  mutex->wait_lock.lock = 0U;
+  mutex->waiting = NULL;
+  mutex->waiting_tail = NULL;
+  mutex->top_rank = SCHED_PI_NONE;
+  mutex->held_next = NULL;
+}
+
+void mutex_init_recursive(Mutex *mutex) {
+  mutex_init(mutex);
+  mutex->recursive = true;
+}
+
+bool mutex_trylock(Mutex *mutex) {
+  struct TaskBlock *self = mutex_self();
+
+  if (mutex_owner(mutex) == self) {
+    if (!mutex->recursive) {
+      return false;
+    }
+    mutex->lock_count++;
+    return true;
+  }
+
+  if (atomic_cmpxchg(&mutex->owner, 0U, (u64)self) != 0U) {
+    return false;
+  }
+
+  mutex_acquired(mutex, self);
+  return true;
+}
+
+bool mutex_lock(Mutex *mutex) {
+  struct TaskBlock *self = mutex_self();
+
+  if (mutex_owner(mutex) == self) {
+    // Locking a normal mutex twice would wait forever
+    if (!mutex->recursive) {
+      return false;
+    }
+    mutex->lock_count++;
+    return true;
+  }
+
+  // Fast path, a single compare-and-swap when nobody holds the mutex
+  if (atomic_cmpxchg(&mutex->owner, 0U, (u64)self) == 0U) {
+    mutex_acquired(mutex, self);
+    return true;
+  }
+
+  // Unable to switch tasks, so the only way to wait is to spin
+  if (!scheduler_may_block()) {
+    while (atomic_cmpxchg(&mutex->owner, 0U, (u64)self) != 0U) {
+    }
+    mutex_acquired(mutex, self);
+    return true;
+  }
+
+  // IRQs stay masked until the task sleeps, so the tick cannot take it off the CPU half way to sleep
+  u64 flags = irq_save_flags();
+  spin_lock(&mutex->wait_lock);
+
+  // Flag the waiter before queueing it, so the owner either unlocked already or will hand the mutex over
+  while (1) {
+    u64 owner = mutex->owner;
+    if (owner == 0U) {
+      if (atomic_cmpxchg(&mutex->owner, 0U, (u64)self) == 0U) {
+        spin_unlock(&mutex->wait_lock);
+        irq_restore_flags(flags);
+        mutex_acquired(mutex, self);
+        return true;
+      }
+    } else if (atomic_cmpxchg(&mutex->owner, owner, owner | MUTEX_HAS_WAITERS) == owner) {
+      break;
+    }
+  }
+
+  struct MutexWaiter waiter = { .task = self, .next = NULL };
+  if (mutex->waiting_tail) {
+    mutex->waiting_tail->next = &waiter;
+  } else {
+    mutex->waiting = &waiter;
+  }
+  mutex->waiting_tail = &waiter;
+
+  // The owner cannot unlock meanwhile, its unlock has to take wait_lock to see the waiter
+  struct TaskBlock *owner = mutex_owner(mutex);
+  spin_lock(&pi_lock);
+  if (mutex->waiting == &waiter) {
+    mutex->top_rank = SCHED_PI_NONE;
+    mutex->held_next = owner->pi_held;
+    owner->pi_held = mutex;
+  }
+  mutex->top_rank = max(mutex->top_rank, scheduler_task_pi_rank(self));
+  pi_update(owner);
+  spin_unlock(&pi_lock);
+
+  // The unlocking task makes the first waiter the owner before waking it, so waking up means owning the mutex
+  while (mutex_owner(mutex) != self) {
+    self->state = TASK_SLEEPING;
+    spin_unlock(&mutex->wait_lock);
+    schedule();
+    spin_lock(&mutex->wait_lock);
+  }
+  self->state = TASK_RUNNING;
+
+  spin_unlock(&mutex->wait_lock);
+  irq_restore_flags(flags);
+  return true;
+}
+
+bool mutex_unlock(Mutex *mutex) {
+  struct TaskBlock *self = mutex_self();
+
+  if (mutex_owner(mutex) != self) {
+    return false;
+  }
+
+  if (--mutex->lock_count > 0U) {
+    return true;
+  }
+
+  // Fast path, nobody waits
+  if (atomic_cmpxchg(&mutex->owner, (u64)self, 0U) != (u64)self) {
+    u64 flags = irq_save_flags();
+    spin_lock(&mutex->wait_lock);
+
+    struct MutexWaiter *waiter = mutex->waiting;
+    mutex->waiting = waiter->next;
+    if (!mutex->waiting) {
+      mutex->waiting_tail = NULL;
+    }
+
+    // Hand over directly instead of unlocking, so a task that never waited cannot overtake the waiters
+    struct TaskBlock *next = waiter->task;
+    mutex_acquired(mutex, next);
+    atomic_xchg(&mutex->owner, (u64)next | (mutex->waiting ? MUTEX_HAS_WAITERS : 0U));
+
+    // The new owner inherits from the tasks still waiting, this task only from the mutexes it still holds
+    spin_lock(&pi_lock);
+    pi_held_remove(self, mutex);
+    mutex->top_rank = SCHED_PI_NONE;
+    if (mutex->waiting) {
+      for (struct MutexWaiter *it = mutex->waiting; it; it = it->next) {
+        mutex->top_rank = max(mutex->top_rank, scheduler_task_pi_rank(it->task));
+      }
+      mutex->held_next = next->pi_held;
+      next->pi_held = mutex;
+      pi_update(next);
+    }
+    pi_update(self);
+    spin_unlock(&pi_lock);
+
+    scheduler_wake_task(next);
+
+    spin_unlock(&mutex->wait_lock);
+    irq_restore_flags(flags);
+  }
+
+  return true;
+}
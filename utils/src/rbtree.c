@@ -0,0 +1,261 @@
+/*******************************************************************************************************************************
+ * @file   rbtree.c
+ *
+ * @brief  Intrusive red-black tree source file
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+
+/* Inter-component Headers */
+
+/* Intra-component Headers */
+#include "rbtree.h"
+
+static void replace_child(struct RbRoot *root, struct RbNode *parent, struct RbNode *old, struct RbNode *new) {
+  if (!parent) {
+    root->node = new;
+  } else if (parent->left == old) {
+    parent->left = new;
+  } else {
+    parent->right = new;
+  }
+}
+
+static void rotate_left(struct RbRoot *root, struct RbNode *node) {
+  struct RbNode *pivot = node->right;
+
+  node->right = pivot->left;
+  if (pivot->left) {
+    pivot->left->parent = node;
+  }
+
+  pivot->parent = node->parent;
+  replace_child(root, node->parent, node, pivot);
+
+  pivot->left = node;
+  node->parent = pivot;
+}
+
+static void rotate_right(struct RbRoot *root, struct RbNode *node) {
+  struct RbNode *pivot = node->left;
+
+  node->left = pivot->right;
+  if (pivot->right) {
+    pivot->right->parent = node;
+  }
+
+  pivot->parent = node->parent;
+  replace_child(root, node->parent, node, pivot);
+
+  pivot->right = node;
+  node->parent = pivot;
+}
+
+static inline bool is_red(struct RbNode *node) {
+  return node && node->red;
+}
+
+void rb_insert(struct RbRoot *root, struct RbNode *node, struct RbNode *parent, struct RbNode **link, bool leftmost) {
+  node->parent = parent;
+  node->left = NULL;
+  node->right = NULL;
+  node->red = true;
+  *link = node;
+
+  if (leftmost) {
+    root->leftmost = node;
+  }
+
+  // Fix up red-red violations, moving up two levels at a time while the uncle is red
+  while (is_red(node->parent)) {
+    struct RbNode *parent_node = node->parent;
+    struct RbNode *grandparent = parent_node->parent;
+
+    if (parent_node == grandparent->left) {
+      struct RbNode *uncle = grandparent->right;
+
+      if (is_red(uncle)) {
+        parent_node->red = false;
+        uncle->red = false;
+        grandparent->red = true;
+        node = grandparent;
+        continue;
+      }
+
+      if (node == parent_node->right) {
+        rotate_left(root, parent_node);
+        node = parent_node;
+        parent_node = node->parent;
+      }
+
+      parent_node->red = false;
+      grandparent->red = true;
+      rotate_right(root, grandparent);
+    } else {
+      struct RbNode *uncle = grandparent->left;
+
+      if (is_red(uncle)) {
+        parent_node->red = false;
+        uncle->red = false;
+        grandparent->red = true;
+        node = grandparent;
+        continue;
+      }
+
+      if (node == parent_node->left) {
+        rotate_right(root, parent_node);
+        node = parent_node;
+        parent_node = node->parent;
+      }
+
+      parent_node->red = false;
+      grandparent->red = true;
+      rotate_left(root, grandparent);
+    }
+  }
+
+  root->node->red = false;
+}
+
+struct RbNode *rb_next(struct RbNode *node) {
+  if (node->right) {
+    node = node->right;
+    while (node->left) {
+      node = node->left;
+    }
+    return node;
+  }
+
+  // Climb until we come up from a left child
+  while (node->parent && node == node->parent->right) {
+    node = node->parent;
+  }
+
+  return node->parent;
+}
+
+/* Restores the black height after a black node was removed from below parent. child may be NULL */
+static void erase_fixup(struct RbRoot *root, struct RbNode *child, struct RbNode *parent) {
+  while (child != root->node && !is_red(child)) {
+    if (child == parent->left) {
+      struct RbNode *sibling = parent->right;
+
+      if (is_red(sibling)) {
+        sibling->red = false;
+        parent->red = true;
+        rotate_left(root, parent);
+        sibling = parent->right;
+      }
+
+      if (!is_red(sibling->left) && !is_red(sibling->right)) {
+        sibling->red = true;
+        child = parent;
+        parent = child->parent;
+        continue;
+      }
+
+      if (!is_red(sibling->right)) {
+        sibling->left->red = false;
+        sibling->red = true;
+        rotate_right(root, sibling);
+        sibling = parent->right;
+      }
+
+      sibling->red = parent->red;
+      parent->red = false;
+      sibling->right->red = false;
+      rotate_left(root, parent);
+      child = root->node;
+    } else {
+      struct RbNode *sibling = parent->left;
+
+      if (is_red(sibling)) {
+        sibling->red = false;
+        parent->red = true;
+        rotate_right(root, parent);
+        sibling = parent->left;
+      }
+
+      if (!is_red(sibling->left) && !is_red(sibling->right)) {
+        sibling->red = true;
+        child = parent;
+        parent = child->parent;
+        continue;
+      }
+
+      if (!is_red(sibling->left)) {
+        sibling->right->red = false;
+        sibling->red = true;
+        rotate_left(root, sibling);
+        sibling = parent->left;
+      }
+
+      sibling->red = parent->red;
+      parent->red = false;
+      sibling->left->red = false;
+      rotate_right(root, parent);
+      child = root->node;
+    }
+  }
+
+  if (child) {
+    child->red = false;
+  }
+}
+
+void rb_erase(struct RbRoot *root, struct RbNode *node) {
+  if (root->leftmost == node) {
+    root->leftmost = rb_next(node);
+  }
+
+  struct RbNode *child;
+  struct RbNode *parent;
+  bool removed_red;
+
+  if (!node->left || !node->right) {
+    // At most one child, which takes the node's place
+    child = node->left ? node->left : node->right;
+    parent = node->parent;
+    removed_red = node->red;
+
+    if (child) {
+      child->parent = parent;
+    }
+    replace_child(root, parent, node, child);
+  } else {
+    // Two children: the in-order successor has no left child and takes the node's place and colour
+    struct RbNode *successor = node->right;
+    while (successor->left) {
+      successor = successor->left;
+    }
+
+    child = successor->right;
+    removed_red = successor->red;
+
+    if (successor->parent == node) {
+      parent = successor;
+    } else {
+      parent = successor->parent;
+      parent->left = child;
+      if (child) {
+        child->parent = parent;
+      }
+
+      successor->right = node->right;
+      node->right->parent = successor;
+    }
+
+    successor->left = node->left;
+    node->left->parent = successor;
+    successor->parent = node->parent;
+    successor->red = node->red;
+    replace_child(root, node->parent, node, successor);
+  }
+
+  if (!removed_red) {
+    erase_fixup(root, child, parent);
+  }
+}
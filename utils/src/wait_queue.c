@@ -0,0 +1,108 @@
+/*******************************************************************************************************************************
+ * @file   wait_queue.c
+ *
+ * @brief  Wait queue API, lets tasks sleep until a condition becomes true
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "irq.h"
+#include "scheduler.h"
+
+/* Intra-component Headers */
+#include "wait_queue.h"
+
+/* Must be called with the queue locked */
+static void entry_remove(WaitQueue *wq, struct WaitQueueEntry *entry) {
+  struct WaitQueueEntry *prev = NULL;
+  struct WaitQueueEntry *it = wq->head;
+
+  while (it && it != entry) {
+    prev = it;
+    it = it->next;
+  }
+  if (!it) {
+    return;
+  }
+
+  if (prev) {
+    prev->next = entry->next;
+  } else {
+    wq->head = entry->next;
+  }
+  if (wq->tail == entry) {
+    wq->tail = prev;
+  }
+
+  entry->next = NULL;
+  entry->queued = false;
+}
+
+void wait_queue_init(WaitQueue *wq) {
+  wq->lock.lock = 0U;
+  wq->head = NULL;
+  wq->tail = NULL;
+}
+
+void prepare_to_wait(WaitQueue *wq, struct WaitQueueEntry *entry) {
+  spin_lock(&wq->lock);
+
+  // Woken waiters are off the queue but still waiting for their condition, so they join again at the back
+  if (!entry->queued) {
+    entry->task = current;
+    entry->next = NULL;
+    entry->queued = true;
+    if (wq->tail) {
+      wq->tail->next = entry;
+    } else {
+      wq->head = entry;
+    }
+    wq->tail = entry;
+  }
+  current->state = TASK_SLEEPING;
+
+  spin_unlock(&wq->lock);
+}
+
+void finish_wait(WaitQueue *wq, struct WaitQueueEntry *entry) {
+  current->state = TASK_RUNNING;
+
+  spin_lock(&wq->lock);
+  if (entry->queued) {
+    entry_remove(wq, entry);
+  }
+  spin_unlock(&wq->lock);
+}
+
+void wake_up(WaitQueue *wq) {
+  u64 flags = irq_save_flags();
+  spin_lock(&wq->lock);
+
+  struct WaitQueueEntry *entry = wq->head;
+  if (entry) {
+    entry_remove(wq, entry);
+    scheduler_wake_task(entry->task);
+  }
+
+  spin_unlock(&wq->lock);
+  irq_restore_flags(flags);
+}
+
+void wake_up_all(WaitQueue *wq) {
+  u64 flags = irq_save_flags();
+  spin_lock(&wq->lock);
+
+  while (wq->head) {
+    struct WaitQueueEntry *entry = wq->head;
+    entry_remove(wq, entry);
+    scheduler_wake_task(entry->task);
+  }
+
+  spin_unlock(&wq->lock);
+  irq_restore_flags(flags);
+}
@@ -0,0 +1,177 @@
+/*******************************************************************************************************************************
+ * @file   workqueue.c
+ *
+ * @brief  Workqueue API, runs deferred work in per-CPU kernel worker threads
+ *
+ * @date   2026-10-19
+ * @author Aryan Kashem
+ *******************************************************************************************************************************/
+
+/* Standard library Headers */
+#include <stddef.h>
+
+/* Inter-component Headers */
+#include "arm64_atomic.h"
+#include "bcm2711_cpu.h"
+#include "irq.h"
+#include "sched_class.h"
+#include "scheduler.h"
+
+/* Intra-component Headers */
+#include "workqueue.h"
+
+struct Workqueue system_wq;
+
+/* Must be called with IRQs masked. The work must already be marked pending */
+static void insert_work(struct WorkqueueCpu *pool, struct Work *work) {
+  spin_lock(&pool->lock);
+
+  work->next = NULL;
+  bool was_empty = pool->head == NULL;
+  if (pool->tail) {
+    pool->tail->next = work;
+  } else {
+    pool->head = work;
+  }
+  pool->tail = work;
+
+  spin_unlock(&pool->lock);
+
+  // A non-empty queue already has a wakeup on the way, or the worker is still running its batch
+  if (was_empty) {
+    wake_up(&pool->more_work);
+  }
+}
+
+static void worker_thread(void *arg) {
+  struct WorkqueueCpu *pool = arg;
+
+  while (1) {
+    wait_event(&pool->more_work, pool->head != NULL);
+
+    // Take everything queued so far at once, later work goes onto a fresh list and wakes us again
+    u64 flags = irq_save_flags();
+    spin_lock(&pool->lock);
+    struct Work *batch = pool->head;
+    pool->head = NULL;
+    pool->tail = NULL;
+    spin_unlock(&pool->lock);
+    irq_restore_flags(flags);
+
+    pool->batches++;
+    while (batch) {
+      struct Work *work = batch;
+      batch = work->next;
+      work->next = NULL;
+
+      // Cleared first, so the work can queue itself again
+      atomic_xchg(&work->pending, 0U);
+      work->fn(work);
+      pool->items++;
+    }
+  }
+}
+
+int workqueue_init(struct Workqueue *wq, u32 policy, long priority) {
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    struct WorkqueueCpu *pool = &wq->cpus[cpu];
+    pool->lock.lock = 0U;
+    pool->head = NULL;
+    pool->tail = NULL;
+    pool->items = 0U;
+    pool->batches = 0U;
+    wait_queue_init(&pool->more_work);
+  }
+
+  for (u32 cpu = 0U; cpu < NUM_CPUS; cpu++) {
+    struct WorkqueueCpu *pool = &wq->cpus[cpu];
+    int res =
+        scheduler_create_task_affinity(PF_KTHREAD, (u64)&worker_thread, (u64)pool, priority, 1U << cpu, &pool->pid);
+    if (res != 0) {
+      return res;
+    }
+
+    if (policy != SCHED_NORMAL) {
+      scheduler_set_policy(pool->pid, policy, priority);
+    }
+  }
+
+  return 0;
+}
+
+int system_workqueue_init(long priority) {
+  return workqueue_init(&system_wq, SCHED_NORMAL, priority);
+}
+
+void work_init(struct Work *work, void (*fn)(struct Work *work), void *data) {
+  work->next = NULL;
+  work->fn = fn;
+  work->data = data;
+  work->pending = 0U;
+}
+
+bool queue_work_on(u32 cpu, struct Workqueue *wq, struct Work *work) {
+  if (cpu >= NUM_CPUS || atomic_cmpxchg(&work->pending, 0U, 1U) != 0U) {
+    return false;
+  }
+
+  u64 flags = irq_save_flags();
+  insert_work(&wq->cpus[cpu], work);
+  irq_restore_flags(flags);
+
+  return true;
+}
+
+bool queue_work(struct Workqueue *wq, struct Work *work) {
+  return queue_work_on(get_cpu_id(), wq, work);
+}
+
+bool schedule_work(struct Work *work) {
+  return queue_work(&system_wq, work);
+}
+
+/* Runs from the tick of the CPU that scheduled the work, which queues it there */
+static void delayed_work_timer_fn(struct SchedTimer *timer) {
+  struct DelayedWork *dwork = timer->data;
+
+  u64 flags = irq_save_flags();
+  insert_work(&dwork->wq->cpus[get_cpu_id()], &dwork->work);
+  irq_restore_flags(flags);
+}
+
+void delayed_work_init(struct DelayedWork *dwork, void (*fn)(struct Work *work), void *data) {
+  work_init(&dwork->work, fn, data);
+  sched_timer_init(&dwork->timer, delayed_work_timer_fn, dwork);
+  dwork->wq = NULL;
+}
+
+bool queue_delayed_work(struct Workqueue *wq, struct DelayedWork *dwork, u64 delay_us) {
+  if (atomic_cmpxchg(&dwork->work.pending, 0U, 1U) != 0U) {
+    return false;
+  }
+
+  dwork->wq = wq;
+
+  u64 flags = irq_save_flags();
+  if (delay_us == 0U) {
+    insert_work(&wq->cpus[get_cpu_id()], &dwork->work);
+  } else {
+    sched_timer_arm(&dwork->timer, sched_clock() + delay_us * NSEC_PER_USEC);
+  }
+  irq_restore_flags(flags);
+
+  return true;
+}
+
+bool schedule_delayed_work(struct DelayedWork *dwork, u64 delay_us) {
+  return queue_delayed_work(&system_wq, dwork, delay_us);
+}
+
+bool cancel_delayed_work(struct DelayedWork *dwork) {
+  if (!sched_timer_cancel(&dwork->timer)) {
+    return false;
+  }
+
+  atomic_xchg(&dwork->work.pending, 0U);
+  return true;
+}